@@ -0,0 +1,140 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+/**
+ * @brief Escape string for JSON
+ *
+ * @param str String to escape
+ * @return Quoted string
+ */
+std::string Quote(const std::string &str) {
+  std::ostringstream oss;
+  oss << '"';
+  for (const char ch : str) {
+    if ((ch == '"') || (ch == '\\')) {
+      oss << '\\' << ch;
+    } else if (static_cast<unsigned char>(ch) < 0x20) {
+      oss << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+          << static_cast<int>(ch) << std::dec;
+    } else {
+      oss << ch;
+    }
+  }
+  oss << '"';
+
+  return oss.str();
+}
+
+/**
+ * @return Current UTC time in ISO 8601 format
+ */
+std::string GetCurrentTime() {
+  const std::time_t now = std::time(nullptr);
+  std::tm tm{};
+  gmtime_r(&now, &tm);
+  std::ostringstream oss;
+  oss << std::put_time(&tm, "%Y-%m-%dT%H:%M:%SZ");
+
+  return oss.str();
+}
+
+} // namespace
+
+namespace bench {
+
+Runner::Runner(const std::chrono::milliseconds min_time,
+               const int repetitions, const std::string &filter) :
+min_time_ns_(std::chrono::duration<double, std::nano>(min_time).count()),
+repetitions_(std::max(repetitions, 1)),
+filter_(filter),
+results_() {
+}
+
+const std::vector<Result> &Runner::GetResults() const {
+  return results_;
+}
+
+void Runner::AddResult(const std::string &name, const uint64_t iterations,
+                       const uint64_t bytes_per_op,
+                       std::vector<double> times) {
+  std::sort(times.begin(), times.end());
+
+  Result result;
+  result.name = name;
+  result.iterations = iterations;
+  result.ns_per_op = times[times.size() / 2];
+  result.min_ns_per_op = times.front();
+  result.bytes_per_op = bytes_per_op;
+  results_.push_back(result);
+
+  std::cerr << std::left << std::setw(48) << name << std::right
+            << std::fixed << std::setprecision(1) << std::setw(12)
+            << result.ns_per_op << " ns/op";
+  if (bytes_per_op > 0) {
+    std::cerr << std::setw(10) << bytes_per_op / result.ns_per_op * 1e3
+              << " MB/s";
+  }
+  std::cerr << std::endl;
+}
+
+void WriteJson(std::ostream &os, const std::string &label,
+               const std::vector<Result> &results) {
+  os << std::fixed << std::setprecision(3)
+     << "{\n"
+     << "  \"context\": {\n"
+     << "    \"label\": " << Quote(label) << ",\n"
+     << "    \"date\": " << Quote(GetCurrentTime()) << ",\n"
+     << "    \"compiler\": " << Quote(__VERSION__) << ",\n"
+#ifdef NDEBUG
+     << "    \"optimized\": true,\n"
+#else
+     << "    \"optimized\": false,\n"
+#endif
+     << "    \"cpu_count\": " << std::thread::hardware_concurrency() << "\n"
+     << "  },\n"
+     << "  \"benchmarks\": [";
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const Result &result = results[i];
+    os << (i == 0 ? "\n" : ",\n")
+       << "    {\"name\": " << Quote(result.name)
+       << ", \"iterations\": " << result.iterations
+       << ", \"ns_per_op\": " << result.ns_per_op
+       << ", \"min_ns_per_op\": " << result.min_ns_per_op
+       << ", \"bytes_per_op\": " << result.bytes_per_op << "}";
+  }
+  os << "\n  ]\n}" << std::endl;
+}
+
+} // namespace bench
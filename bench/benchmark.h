@@ -0,0 +1,148 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+/**
+ * @brief Prevent compiler from optimizing out value computation
+ *
+ * @param value Value, that must be computed
+ */
+template <typename T>
+inline void DoNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief Result of one benchmark
+ */
+struct Result {
+  std::string name;
+  uint64_t iterations = 0; //!< Number of iterations in one repetition
+  double ns_per_op = 0; //!< Median time of one iteration
+  double min_ns_per_op = 0; //!< Best time of one iteration
+  uint64_t bytes_per_op = 0; //!< Number of processed bytes per iteration
+};
+
+/**
+ * @brief Runs benchmarks and collects their results
+ */
+class Runner {
+ public:
+  /**
+   * @param min_time Min duration of one repetition
+   * @param repetitions Number of measured repetitions
+   * @param filter Only benchmarks with names matching filter are run
+   */
+  Runner(std::chrono::milliseconds min_time, int repetitions,
+         const std::string &filter);
+
+  /**
+   * @brief Run benchmark, if it's selected by filter
+   * @details Number of iterations is chosen so repetition takes at least
+   * min_time
+   *
+   * @param name Unique benchmark name
+   * @param bytes_per_op Number of bytes processed by one call of function
+   * @param function Function to measure
+   */
+  template <typename Function>
+  void Run(const std::string &name, const uint64_t bytes_per_op,
+           Function &&function) {
+    if (!std::regex_search(name, filter_)) {
+      return;
+    }
+
+    const auto measure = [&function] (const uint64_t iterations) {
+      const auto start_time = Clock::now();
+      for (uint64_t i = 0; i < iterations; ++i) {
+        function();
+      }
+      return std::chrono::duration<double, std::nano>(Clock::now() -
+                                                      start_time).count();
+    };
+
+    uint64_t iterations = 1;
+    for (double elapsed_ns = measure(iterations);
+         elapsed_ns < min_time_ns_; elapsed_ns = measure(iterations)) {
+      // Overshoot a little, so usually one more try is enough
+      const double scale = (elapsed_ns > 0) ?
+                           1.2 * min_time_ns_ / elapsed_ns : 10;
+      iterations = std::max<uint64_t>(iterations * 2,
+                                      iterations * std::min(scale, 100.0));
+    }
+
+    std::vector<double> times;
+    for (int i = 0; i < repetitions_; ++i) {
+      times.push_back(measure(iterations) / iterations);
+    }
+    AddResult(name, iterations, bytes_per_op, std::move(times));
+  }
+
+  /**
+   * @return Results of run benchmarks in order of running
+   */
+  [[nodiscard]] const std::vector<Result> &GetResults() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  const double min_time_ns_;
+  const int repetitions_;
+  const std::regex filter_;
+  std::vector<Result> results_;
+
+  /**
+   * @brief Save result and print it to stderr
+   *
+   * @param name Benchmark name
+   * @param iterations Number of iterations in one repetition
+   * @param bytes_per_op Number of processed bytes per iteration
+   * @param times Time of one iteration in each repetition
+   */
+  void AddResult(const std::string &name, uint64_t iterations,
+                 uint64_t bytes_per_op, std::vector<double> times);
+};
+
+/**
+ * @brief Write results in JSON
+ *
+ * @param os Output stream
+ * @param label Label of the build, e.g. release version
+ * @param results Results to write
+ */
+void WriteJson(std::ostream &os, const std::string &label,
+               const std::vector<Result> &results);
+
+} // namespace bench
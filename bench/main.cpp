@@ -0,0 +1,364 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <getopt.h>
+
+#include <cstdlib>
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "split.h"
+#include "converters/chroma_downsampler.h"
+#include "servlet.h"
+#include "http/request.h"
+#include "http/response.h"
+#include "hls/servlet.h"
+#include "port_handler/request_dispatcher.h"
+#include "rtp/packet.h"
+#include "rtp/mjpeg/packet.h"
+#include "rtsp/request.h"
+#include "sdp/session_description.h"
+#include "test_source/rtp_jpeg_packetizer.h"
+
+namespace {
+
+//! Typical size of 1280x720 MJPEG frame from camera
+const std::size_t kJpegFrameSize = 100 * 1024;
+const std::size_t kRtpPacketSize = 1400;
+
+/**
+ * @brief Build RTP/JPEG packets of one frame with random scan data
+ *
+ * @return Packets
+ */
+std::vector<types::Bytes> BuildRtpJpegPackets() {
+  std::mt19937 random_engine(42);
+  std::uniform_int_distribution<int> byte_distribution(0, 255);
+
+  test_source::JpegFrame frame;
+  frame.quality = 255;
+  frame.width = 1280;
+  frame.height = 720;
+  for (int i = 0; i < 128; ++i) {
+    frame.quantization_tables.push_back(1 + byte_distribution(random_engine) % 64);
+  }
+  for (std::size_t i = 0; i < kJpegFrameSize; ++i) {
+    frame.scan_data.push_back(byte_distribution(random_engine));
+  }
+
+  test_source::RtpJpegPacketizer packetizer(0x12345678, kRtpPacketSize);
+  return packetizer.Packetize(frame, 0);
+}
+
+void BenchRtp(bench::Runner &runner) {
+  const std::vector<types::Bytes> rtp_packets = BuildRtpJpegPackets();
+  const types::Bytes &rtp_bytes = rtp_packets[1];
+  runner.Run("rtp::Packet::Deserialize", rtp_bytes.size(), [&rtp_bytes] {
+    rtp::Packet packet;
+    packet.Deserialize(rtp_bytes);
+    bench::DoNotOptimize(packet);
+  });
+
+  std::vector<types::Bytes> payloads;
+  uint64_t total_payload_size = 0;
+  for (const types::Bytes &bytes : rtp_packets) {
+    rtp::Packet packet;
+    packet.Deserialize(bytes);
+    total_payload_size += packet.payload.size();
+    payloads.push_back(std::move(packet.payload));
+  }
+
+  const types::Bytes &first_payload = payloads.front();
+  runner.Run("rtp::mjpeg::Packet::Deserialize/first", first_payload.size(),
+             [&first_payload] {
+    rtp::mjpeg::Packet packet;
+    packet.Deserialize(first_payload);
+    bench::DoNotOptimize(packet);
+  });
+
+  const types::Bytes &payload = payloads[1];
+  runner.Run("rtp::mjpeg::Packet::Deserialize", payload.size(), [&payload] {
+    rtp::mjpeg::Packet packet;
+    packet.Deserialize(payload);
+    bench::DoNotOptimize(packet);
+  });
+
+  std::vector<rtp::mjpeg::Packet> mjpeg_packets(payloads.size());
+  for (std::size_t i = 0; i < payloads.size(); ++i) {
+    mjpeg_packets[i].Deserialize(payloads[i]);
+  }
+  runner.Run("rtp::mjpeg::UnpackJpeg", total_payload_size, [&mjpeg_packets] {
+    bench::DoNotOptimize(rtp::mjpeg::UnpackJpeg(mjpeg_packets));
+  });
+}
+
+void BenchHttp(bench::Runner &runner) {
+  const std::string request_str =
+      "GET /chunk1234.ts HTTP/1.1\r\n"
+      "Host: 192.168.1.10:8080\r\n"
+      "User-Agent: VLC/3.0.12 LibVLC/3.0.12\r\n"
+      "Accept: */*\r\n"
+      "Accept-Language: en_US\r\n"
+      "Range: bytes=0-\r\n"
+      "Connection: close\r\n"
+      "Icy-MetaData: 1\r\n"
+      "\r\n";
+  runner.Run("http::ParseRequest", request_str.size(), [&request_str] {
+    bench::DoNotOptimize(
+        http::ParseRequest<http::Method, http::kProtocolName>(request_str));
+  });
+
+  const std::string response_str =
+      "RTSP/1.0 200 OK\r\n"
+      "CSeq: 3\r\n"
+      "Date: Sun, 18 Oct 2026 12:00:00 GMT\r\n"
+      "Transport: RTP/AVP;unicast;client_port=4577-4578;"
+      "server_port=6970-6971;ssrc=12345678\r\n"
+      "Session: 1234567890;timeout=60\r\n"
+      "\r\n";
+  runner.Run("http::ParseResponse/rtsp", response_str.size(),
+             [&response_str] {
+    bench::DoNotOptimize(http::ParseResponse(response_str));
+  });
+}
+
+void BenchSdp(bench::Runner &runner) {
+  const std::string sdp =
+      "v=0\r\n"
+      "o=- 1234567890 1 IN IP4 192.168.1.20\r\n"
+      "s=Raspberry Pi camera\r\n"
+      "c=IN IP4 0.0.0.0\r\n"
+      "t=0 0\r\n"
+      "a=tool:media-server-bench\r\n"
+      "a=range:npt=0-\r\n"
+      "m=video 0 RTP/AVP 26\r\n"
+      "a=control:track1\r\n"
+      "a=cliprect:0,0,720,1280\r\n"
+      "a=framerate:30\r\n";
+  runner.Run("sdp::ParseSessionDescription", sdp.size(), [&sdp] {
+    bench::DoNotOptimize(sdp::ParseSessionDescription(sdp));
+  });
+}
+
+/**
+ * @brief Servlet with constant response, so only dispatching is measured
+ */
+class StaticServlet : public Servlet<http::Request, http::Response> {
+ public:
+  [[nodiscard]] http::Response Handle(const http::Request &) override {
+    return {200, "OK"};
+  }
+};
+
+void BenchDispatcher(bench::Runner &runner) {
+  port_handler::RequestDispatcher<http::Request, http::Response> dispatcher;
+  for (const char *path : {"/", "/latency", "/metrics", "/snapshot",
+                           "/stream", "/api/v1/status"}) {
+    dispatcher.RegisterServlet(path, std::make_shared<StaticServlet>());
+  }
+
+  http::Request request;
+  request.method = http::Method::kGet;
+  request.version = 1.1;
+  request.headers["Host"] = "192.168.1.10:8080";
+
+  request.url = "/chunk1234.ts";
+  runner.Run("port_handler::RequestDispatcher::Dispatch/path", 0,
+             [&dispatcher, &request] {
+    bench::DoNotOptimize(dispatcher.Dispatch(request));
+  });
+
+  request.url = "http://192.168.1.10:8080/metrics";
+  runner.Run("port_handler::RequestDispatcher::Dispatch/url", 0,
+             [&dispatcher, &request] {
+    bench::DoNotOptimize(dispatcher.Dispatch(request));
+  });
+}
+
+void BenchSplit(bench::Runner &runner) {
+  const std::string methods = "OPTIONS, DESCRIBE, SETUP, TEARDOWN, PLAY, "
+                              "PAUSE, GET_PARAMETER, SET_PARAMETER";
+  runner.Run("Split", methods.size(), [&methods] {
+    bench::DoNotOptimize(Split(methods, ", "));
+  });
+}
+
+void BenchHls(bench::Runner &runner) {
+  const int kChunkCount = 3;
+  hls::Servlet servlet(kChunkCount, 8.0);
+  for (int i = 0; i < kChunkCount; ++i) {
+    types::Mpeg2TsChunk chunk;
+    chunk.media_sequence_number = i;
+    chunk.duration = 8.0;
+    chunk.ingest_time = types::Clock::now();
+    servlet.Receive(std::make_shared<const types::Mpeg2TsChunk>(
+        std::move(chunk)));
+  }
+
+  // Playlist is built on chunk receiving, so this measures its serving
+  http::Request request;
+  request.method = http::Method::kGet;
+  request.version = 1.1;
+  request.url = hls::kPlaylistPath;
+  runner.Run("hls::Servlet::Handle/playlist", 0, [&servlet, &request] {
+    bench::DoNotOptimize(servlet.Handle(request));
+  });
+}
+
+void BenchChroma(bench::Runner &runner) {
+  // Chroma plane of 1920x1080 4:2:2 frame
+  const int kWidth = 960;
+  const int kHeight = 1080;
+  std::mt19937 random_engine(42);
+  std::uniform_int_distribution<int> byte_distribution(0, 255);
+  std::vector<uint8_t> src(kWidth * kHeight);
+  for (uint8_t &value : src) {
+    value = byte_distribution(random_engine);
+  }
+
+  std::vector<uint8_t> dst(kWidth * kHeight / 2);
+  const converters::SimdLevel cpu_simd_level = converters::GetCpuSimdLevel();
+  for (const converters::SimdLevel simd_level : {
+           converters::SimdLevel::kScalar, converters::SimdLevel::kSse2,
+           converters::SimdLevel::kAvx2}) {
+    if (static_cast<int>(simd_level) > static_cast<int>(cpu_simd_level)) {
+      break;
+    }
+
+    // Odd width and height check tails of vector loops
+    const std::string name = converters::GetSimdLevelName(simd_level);
+    for (const auto &[width, height] : {std::pair(kWidth, kHeight),
+                                        std::pair(kWidth - 13, kHeight - 1)}) {
+      std::vector<uint8_t> scalar_dst(dst.size());
+      converters::DownsampleChroma(src.data(), kWidth, scalar_dst.data(),
+                                   kWidth, width, height,
+                                   converters::SimdLevel::kScalar);
+      std::vector<uint8_t> simd_dst(dst.size());
+      converters::DownsampleChroma(src.data(), kWidth, simd_dst.data(), kWidth,
+                                   width, height, simd_level);
+      if (simd_dst != scalar_dst) {
+        throw std::runtime_error("DownsampleChroma/" + name +
+                                 " doesn't match scalar result");
+      }
+    }
+
+    runner.Run("converters::DownsampleChroma/" + name, src.size(),
+               [&src, &dst, simd_level] {
+      converters::DownsampleChroma(src.data(), kWidth, dst.data(), kWidth,
+                                   kWidth, kHeight, simd_level);
+      bench::DoNotOptimize(dst);
+    });
+  }
+}
+
+void PrintUsage(const char *program_name) {
+  std::cerr << "Usage: " << program_name << " [options]\n"
+            << "Runs microbenchmarks and writes results in JSON\n"
+            << "  -f, --filter <regex>    Run only matching benchmarks\n"
+            << "  -t, --min-time <ms>     Min duration of one repetition "
+               "(default 100)\n"
+            << "  -r, --repetitions <n>   Number of repetitions, median is "
+               "reported (default 5)\n"
+            << "  -o, --output <file>     JSON output file (default stdout)\n"
+            << "  -l, --label <label>     Label of the build, e.g. version\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    std::string filter = ".*";
+    int min_time_ms = 100;
+    int repetitions = 5;
+    std::string output_path;
+    std::string label;
+
+    const option long_options[] = {
+        {"filter", required_argument, nullptr, 'f'},
+        {"min-time", required_argument, nullptr, 't'},
+        {"repetitions", required_argument, nullptr, 'r'},
+        {"output", required_argument, nullptr, 'o'},
+        {"label", required_argument, nullptr, 'l'},
+        {nullptr, 0, nullptr, 0}
+    };
+    int opt = 0;
+    while ((opt = getopt_long(argc, argv, "f:t:r:o:l:", long_options,
+                              nullptr)) != -1) {
+      switch (opt) {
+        case 'f':
+          filter = optarg;
+          break;
+        case 't':
+          min_time_ms = std::stoi(optarg);
+          break;
+        case 'r':
+          repetitions = std::stoi(optarg);
+          break;
+        case 'o':
+          output_path = optarg;
+          break;
+        case 'l':
+          label = optarg;
+          break;
+        default:
+          PrintUsage(argv[0]);
+          return EXIT_FAILURE;
+      }
+    }
+
+    // Benchmarked code logs warnings on errors, it mustn't affect timing
+    logging::Logger::GetInstance().SetLevel(logging::Level::kError);
+
+    bench::Runner runner(std::chrono::milliseconds(min_time_ms), repetitions,
+                         filter);
+    BenchRtp(runner);
+    BenchHttp(runner);
+    BenchSdp(runner);
+    BenchDispatcher(runner);
+    BenchSplit(runner);
+    BenchHls(runner);
+    BenchChroma(runner);
+
+    if (output_path.empty()) {
+      bench::WriteJson(std::cout, label, runner.GetResults());
+    } else {
+      std::ofstream output(output_path);
+      bench::WriteJson(output, label, runner.GetResults());
+      if (!output) {
+        throw std::runtime_error("Can't write " + output_path);
+      }
+    }
+  } catch (const std::exception &ex) {
+    std::cerr << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "chroma_downsampler.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CONVERTERS_X86
+#endif
+
+#include <cstring>
+
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+using converters::SimdLevel;
+
+/**
+ * @brief Average two rows
+ *
+ * @param top Upper row
+ * @param bottom Lower row
+ * @param dst Output row
+ * @param begin First column to process
+ * @param width Row width
+ */
+void AverageRowsScalar(const uint8_t *top, const uint8_t *bottom, uint8_t *dst,
+                       int begin, const int width) {
+  for (int x = begin; x < width; ++x) {
+    dst[x] = static_cast<uint8_t>((top[x] + bottom[x] + 1) >> 1);
+  }
+}
+
+#ifdef CONVERTERS_X86
+
+// pavgb rounds up like the scalar code, so all versions are bit-exact
+
+__attribute__((target("sse2")))
+void AverageRowsSse2(const uint8_t *top, const uint8_t *bottom, uint8_t *dst,
+                     const int width) {
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    const __m128i top_pixels = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(top + x));
+    const __m128i bottom_pixels = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(bottom + x));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x),
+                     _mm_avg_epu8(top_pixels, bottom_pixels));
+  }
+  AverageRowsScalar(top, bottom, dst, x, width);
+}
+
+__attribute__((target("avx2")))
+void AverageRowsAvx2(const uint8_t *top, const uint8_t *bottom, uint8_t *dst,
+                     const int width) {
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    const __m256i top_pixels = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(top + x));
+    const __m256i bottom_pixels = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(bottom + x));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x),
+                        _mm256_avg_epu8(top_pixels, bottom_pixels));
+  }
+  AverageRowsScalar(top, bottom, dst, x, width);
+}
+
+#endif // CONVERTERS_X86
+
+SimdLevel DetectSimdLevel() {
+#ifdef CONVERTERS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::kAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return SimdLevel::kSse2;
+  }
+#endif
+
+  return SimdLevel::kScalar;
+}
+
+} // namespace
+
+namespace converters {
+
+SimdLevel GetCpuSimdLevel() {
+  static const SimdLevel kSimdLevel = DetectSimdLevel();
+  return kSimdLevel;
+}
+
+const char *GetSimdLevelName(const SimdLevel simd_level) {
+  switch (simd_level) {
+    case SimdLevel::kScalar:
+      return "scalar";
+    case SimdLevel::kSse2:
+      return "sse2";
+    case SimdLevel::kAvx2:
+      return "avx2";
+  }
+
+  return "unknown";
+}
+
+void DownsampleChroma(const uint8_t *src, const int src_stride, uint8_t *dst,
+                      const int dst_stride, const int width, const int height,
+                      const SimdLevel simd_level) {
+  if (static_cast<int>(simd_level) > static_cast<int>(GetCpuSimdLevel())) {
+    throw std::invalid_argument(std::string(GetSimdLevelName(simd_level)) +
+                                " isn't supported by CPU");
+  }
+
+  int y = 0;
+  for (; y + 1 < height; y += 2) {
+    const uint8_t *top = src + y * src_stride;
+    const uint8_t *bottom = top + src_stride;
+    uint8_t *dst_row = dst + (y / 2) * dst_stride;
+    switch (simd_level) {
+#ifdef CONVERTERS_X86
+      case SimdLevel::kAvx2:
+        AverageRowsAvx2(top, bottom, dst_row, width);
+        break;
+      case SimdLevel::kSse2:
+        AverageRowsSse2(top, bottom, dst_row, width);
+        break;
+#endif
+      default:
+        AverageRowsScalar(top, bottom, dst_row, 0, width);
+        break;
+    }
+  }
+
+  if (y < height) {
+    std::memcpy(dst + (y / 2) * dst_stride, src + y * src_stride, width);
+  }
+}
+
+} // namespace converters
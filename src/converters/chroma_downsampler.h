@@ -0,0 +1,68 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+namespace converters {
+
+/**
+ * @brief Instruction set used by chroma downsampling
+ */
+enum class SimdLevel {
+  kScalar,
+  kSse2,
+  kAvx2
+};
+
+/**
+ * @return Best instruction set supported by CPU. Detected once by CPUID
+ */
+[[nodiscard]] SimdLevel GetCpuSimdLevel();
+
+/**
+ * @param simd_level Instruction set
+ * @return Name of instruction set
+ */
+[[nodiscard]] const char *GetSimdLevelName(SimdLevel simd_level);
+
+/**
+ * @brief Downsample chroma plane vertically by 2 for 4:2:2 -> 4:2:0 conversion
+ * @details Every output row is rounded average of two input rows, the last
+ * row of odd height is copied. Result doesn't depend on instruction set
+ *
+ * @param src Source plane
+ * @param src_stride Source line size in bytes
+ * @param dst Destination plane with (height + 1) / 2 rows
+ * @param dst_stride Destination line size in bytes
+ * @param width Plane width
+ * @param height Source plane height
+ * @param simd_level Instruction set to use. Must be supported by CPU
+ */
+void DownsampleChroma(const uint8_t *src, int src_stride, uint8_t *dst,
+                      int dst_stride, int width, int height,
+                      SimdLevel simd_level = GetCpuSimdLevel());
+
+} // namespace converters
@@ -0,0 +1,225 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "jpeg_decoder_pool.h"
+
+#include <stdexcept>
+
+#include "metrics/registry.h"
+#include "logging/logger.h"
+
+namespace converters {
+
+JpegDecoderPool::JpegDecoderPool(const int width, const int height,
+                                 const std::size_t decoder_count,
+                                 FrameCallback callback):
+callback_(std::move(callback)),
+max_frames_in_flight_(2 * decoder_count),
+dec_context_ptrs_(),
+jobs_(),
+decoded_frames_(),
+pushed_count_(0),
+output_count_(0),
+stop_(false),
+mutex_(),
+job_condition_(),
+decoded_condition_(),
+output_condition_(),
+decode_latency_(metrics::GetStageLatency("decode")),
+decoded_frames_counter_(metrics::Registry::GetInstance().GetCounter(
+    "frames_decoded_total", "Number of decoded JPEG frames")),
+dropped_frames_counter_(metrics::Registry::GetInstance().GetCounter(
+    "frames_dropped_total", "Number of frames dropped because of errors")),
+decoders_(),
+sequencer_() {
+  if (decoder_count == 0) {
+    throw std::invalid_argument("Decoder count must be positive");
+  }
+
+  AVCodec *dec = avcodec_find_decoder(AV_CODEC_ID_MJPEG);
+  for (std::size_t i = 0; i < decoder_count; ++i) {
+    AVCodecContext *dec_context_ptr = avcodec_alloc_context3(dec);
+    dec_context_ptrs_.push_back(dec_context_ptr);
+    dec_context_ptr->width = width;
+    dec_context_ptr->height = height;
+    // Frames are decoded in parallel, so every context needs only one thread
+    dec_context_ptr->thread_count = 1;
+
+    if (avcodec_open2(dec_context_ptr, dec, NULL) < 0) {
+      for (AVCodecContext *context_ptr : dec_context_ptrs_) {
+        avcodec_free_context(&context_ptr);
+      }
+      throw std::runtime_error("avcodec_open2 error with decoding context");
+    }
+  }
+
+  for (AVCodecContext *dec_context_ptr : dec_context_ptrs_) {
+    decoders_.emplace_back(&JpegDecoderPool::DecoderRoutine, this,
+                           dec_context_ptr);
+  }
+  sequencer_ = std::thread(&JpegDecoderPool::SequencerRoutine, this);
+}
+
+JpegDecoderPool::~JpegDecoderPool() noexcept {
+  Stop();
+
+  for (auto &[sequence_number, decoded_frame] : decoded_frames_) {
+    av_frame_free(&decoded_frame.frame_ptr);
+  }
+  for (AVCodecContext *dec_context_ptr : dec_context_ptrs_) {
+    avcodec_free_context(&dec_context_ptr);
+  }
+}
+
+void JpegDecoderPool::Push(std::shared_ptr<const types::MjpegFrame> frame_ptr) {
+  {
+    std::unique_lock lock(mutex_);
+    output_condition_.wait(lock, [this] {
+      return stop_ || (pushed_count_ - output_count_ < max_frames_in_flight_);
+    });
+    if (stop_) {
+      return;
+    }
+
+    jobs_.push_back({pushed_count_, std::move(frame_ptr)});
+    ++pushed_count_;
+  }
+  job_condition_.notify_one();
+}
+
+void JpegDecoderPool::Flush() {
+  std::unique_lock lock(mutex_);
+  output_condition_.wait(lock, [this] {
+    return stop_ || (output_count_ == pushed_count_);
+  });
+}
+
+void JpegDecoderPool::Stop() noexcept {
+  {
+    std::lock_guard guard(mutex_);
+    stop_ = true;
+  }
+  job_condition_.notify_all();
+  decoded_condition_.notify_all();
+  output_condition_.notify_all();
+
+  for (std::thread &decoder : decoders_) {
+    if (decoder.joinable()) {
+      decoder.join();
+    }
+  }
+  if (sequencer_.joinable()) {
+    sequencer_.join();
+  }
+}
+
+std::size_t JpegDecoderPool::GetDecoderCount() const {
+  return dec_context_ptrs_.size();
+}
+
+void JpegDecoderPool::DecoderRoutine(AVCodecContext *dec_context_ptr) {
+  AVPacket *packet_ptr = av_packet_alloc();
+
+  while (true) {
+    Job job;
+    {
+      std::unique_lock lock(mutex_);
+      job_condition_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+      if (stop_) {
+        break;
+      }
+
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+
+    AVFrame *frame_ptr = Decode(dec_context_ptr, packet_ptr, *job.frame_ptr);
+    {
+      std::lock_guard guard(mutex_);
+      decoded_frames_[job.sequence_number] = {frame_ptr,
+                                              std::move(job.frame_ptr)};
+    }
+    decoded_condition_.notify_one();
+  }
+
+  av_packet_free(&packet_ptr);
+}
+
+void JpegDecoderPool::SequencerRoutine() {
+  while (true) {
+    DecodedFrame decoded_frame{};
+    {
+      std::unique_lock lock(mutex_);
+      decoded_condition_.wait(lock, [this] {
+        return stop_ || (decoded_frames_.count(output_count_) != 0);
+      });
+      if (stop_) {
+        break;
+      }
+
+      auto it = decoded_frames_.find(output_count_);
+      decoded_frame = std::move(it->second);
+      decoded_frames_.erase(it);
+    }
+
+    if (decoded_frame.frame_ptr) {
+      try {
+        callback_(*decoded_frame.frame_ptr, *decoded_frame.source_ptr);
+      } catch (const std::exception &ex) {
+        LOG(kWarning) << "Can't process decoded frame: " << ex.what();
+        dropped_frames_counter_.Add();
+      }
+      av_frame_free(&decoded_frame.frame_ptr);
+    }
+
+    {
+      std::lock_guard guard(mutex_);
+      ++output_count_;
+    }
+    output_condition_.notify_all();
+  }
+}
+
+AVFrame *JpegDecoderPool::Decode(AVCodecContext *dec_context_ptr,
+                                 AVPacket *packet_ptr,
+                                 const types::MjpegFrame &frame) {
+  metrics::ScopedTimer timer(decode_latency_);
+  packet_ptr->data = const_cast<types::Byte *>(frame.data.data());
+  packet_ptr->size = frame.data.size();
+
+  // MJPEG decoder has no delay, so every packet gives exactly one frame
+  AVFrame *frame_ptr = av_frame_alloc();
+  if ((avcodec_send_packet(dec_context_ptr, packet_ptr) < 0) ||
+      (avcodec_receive_frame(dec_context_ptr, frame_ptr) < 0)) {
+    LOG(kWarning) << "Can't decode JPEG frame";
+    dropped_frames_counter_.Add();
+    av_frame_free(&frame_ptr);
+    return nullptr;
+  }
+
+  decoded_frames_counter_.Add();
+  return frame_ptr;
+}
+
+} // namespace converters
@@ -0,0 +1,153 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "types/mjpeg_frame.h"
+#include "metrics/counter.h"
+#include "metrics/histogram.h"
+
+namespace converters {
+
+/**
+ * @brief Decodes JPEG frames on several threads and outputs them in order
+ * @details Every decoder thread has its own codec context. Decoded frames are
+ * put to reorder buffer, and a single sequencer thread passes them to the
+ * callback in the order they were pushed. Frames, that failed to decode, are
+ * skipped
+ */
+class JpegDecoderPool {
+ public:
+  /**
+   * @brief Called on sequencer thread for every decoded frame in push order.
+   * Frame is valid only until callback returns
+   */
+  using FrameCallback = std::function<void(const AVFrame &frame,
+                                           const types::MjpegFrame &source)>;
+
+  /**
+   * @param width Image width
+   * @param height Image height
+   * @param decoder_count Number of decoder threads
+   * @param callback Callback for decoded frames
+   */
+  JpegDecoderPool(int width, int height, std::size_t decoder_count,
+                  FrameCallback callback);
+
+  ~JpegDecoderPool() noexcept;
+
+  JpegDecoderPool(const JpegDecoderPool &) = delete;
+  JpegDecoderPool &operator=(const JpegDecoderPool &) = delete;
+
+  /**
+   * @brief Queue frame for decoding
+   * @details Blocks while too many frames are being decoded or wait for the
+   * callback, so a slow consumer slows down the producer
+   *
+   * @param frame_ptr JPEG frame
+   */
+  void Push(std::shared_ptr<const types::MjpegFrame> frame_ptr);
+
+  /**
+   * @brief Wait until all pushed frames are passed to the callback or skipped
+   */
+  void Flush();
+
+  /**
+   * @brief Stop and join all threads. Callback isn't called after return.
+   * Queued frames are dropped. Safe to call more than once
+   */
+  void Stop() noexcept;
+
+  [[nodiscard]] std::size_t GetDecoderCount() const;
+
+ private:
+  struct Job {
+    uint64_t sequence_number;
+    std::shared_ptr<const types::MjpegFrame> frame_ptr;
+  };
+
+  struct DecodedFrame {
+    AVFrame *frame_ptr; //!< nullptr, if frame failed to decode
+    std::shared_ptr<const types::MjpegFrame> source_ptr;
+  };
+
+  const FrameCallback callback_;
+  //! Max number of frames between Push() and the end of the callback
+  const std::size_t max_frames_in_flight_;
+  std::vector<AVCodecContext *> dec_context_ptrs_; //!< One per decoder thread
+  std::deque<Job> jobs_; //!< Frames waiting for a free decoder
+  //! Reorder buffer: sequence number -> decoded frame
+  std::map<uint64_t, DecodedFrame> decoded_frames_;
+  uint64_t pushed_count_; //!< Sequence number of the next pushed frame
+  uint64_t output_count_; //!< Sequence number of the next frame to output
+  bool stop_; //!< True, if threads should stop
+  std::mutex mutex_; //!< Mutex for jobs, reorder buffer and counters
+  std::condition_variable job_condition_; //!< Job is queued or stop
+  std::condition_variable decoded_condition_; //!< Frame is decoded or stop
+  std::condition_variable output_condition_; //!< Frame is output
+  metrics::Histogram &decode_latency_;
+  metrics::Counter &decoded_frames_counter_;
+  metrics::Counter &dropped_frames_counter_;
+  std::vector<std::thread> decoders_;
+  std::thread sequencer_;
+
+  /**
+   * @brief Decode queued frames until stop
+   *
+   * @param dec_context_ptr Codec context of this thread
+   */
+  void DecoderRoutine(AVCodecContext *dec_context_ptr);
+
+  /**
+   * @brief Pass decoded frames to the callback in order until stop
+   */
+  void SequencerRoutine();
+
+  /**
+   * @brief Decode one JPEG frame
+   *
+   * @param dec_context_ptr Codec context to decode with
+   * @param packet_ptr Packet of this thread to reference frame data with
+   * @param frame MJPEG frame
+   * @return Decoded frame or nullptr, if it can't be decoded
+   */
+  AVFrame *Decode(AVCodecContext *dec_context_ptr, AVPacket *packet_ptr,
+                  const types::MjpegFrame &frame);
+};
+
+} // namespace converters
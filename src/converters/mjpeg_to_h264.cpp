@@ -28,130 +28,188 @@ extern "C" {
 #include <libavformat/avformat.h>
 #include <libavutil/opt.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 }
 
 #include <algorithm>
 
+#include "chroma_downsampler.h"
+#include "metrics/registry.h"
+#include "logging/logger.h"
+
 namespace {
 
 const uint32_t kH264SampleRate = 90'000;
+//! Larger timestamp gap is treated as discontinuity of the source stream
+const int64_t kMaxTimestampGap = 10 * kH264SampleRate;
+
+/**
+ * @param format Pixel format
+ * @return Limited range format with the same memory layout
+ */
+AVPixelFormat GetLayoutFormat(const AVPixelFormat format) {
+  switch (format) {
+    case AV_PIX_FMT_YUVJ420P:
+      return AV_PIX_FMT_YUV420P;
+    case AV_PIX_FMT_YUVJ422P:
+      return AV_PIX_FMT_YUV422P;
+    case AV_PIX_FMT_YUVJ444P:
+      return AV_PIX_FMT_YUV444P;
+    default:
+      return format;
+  }
+}
+
+/**
+ * @param frame Decoded frame
+ * @return True, if frame samples use full (JPEG) range
+ */
+bool IsFullRange(const AVFrame &frame) {
+  const auto format = static_cast<AVPixelFormat>(frame.format);
+  return (frame.color_range == AVCOL_RANGE_JPEG) ||
+         (GetLayoutFormat(format) != format);
+}
 
 } // namespace
 
 namespace converters {
 
-MjpegToH264::MjpegToH264(const int width, const int height, const int fps):
+MjpegToH264::MjpegToH264(const int width, const int height, const int fps,
+                         const MjpegToH264Options &options):
 width_(width),
 height_(height),
 fps_(fps),
-dec_context_ptr_(nullptr),
+key_frame_interval_(options.key_frame_interval),
 enc_context_ptr_(nullptr),
-src_frame_ptr_(nullptr),
 dst_frame_ptr_(nullptr),
-src_packet_ptr_(nullptr),
+ref_frame_ptr_(nullptr),
 dst_packet_ptr_(nullptr),
 sws_context_ptr_(nullptr),
-frame_counter_(0) {
-  AVCodec *dec = avcodec_find_decoder(AV_CODEC_ID_MJPEG);
-  dec_context_ptr_ = avcodec_alloc_context3(dec);
-  dec_context_ptr_->width = width_;
-  dec_context_ptr_->height = height_;
-  dec_context_ptr_->pix_fmt = AV_PIX_FMT_YUV420P;
-
-  if (dec->capabilities & AV_CODEC_CAP_TRUNCATED) {
-    dec_context_ptr_->flags |= AV_CODEC_FLAG_TRUNCATED;
-  }
-
-  if (avcodec_open2(dec_context_ptr_, dec, NULL) < 0) {
-    throw std::runtime_error("avcodec_open2 error with decoding context");
-  }
-
+has_pts_(false),
+last_pts_(0),
+timestamp_offset_(0),
+has_key_frame_(false),
+key_frame_pts_(0),
+ingest_times_(),
+scale_latency_(metrics::GetStageLatency("scale")),
+encode_latency_(metrics::GetStageLatency("encode")),
+encoded_frames_counter_(metrics::Registry::GetInstance().GetCounter(
+    "frames_encoded_total", "Number of encoded H.264 frames")),
+unscaled_frames_counter_(metrics::Registry::GetInstance().GetCounter(
+    "frames_unscaled_total", "Number of decoded frames passed to encoder "
+    "without conversion")),
+static_frames_counter_(metrics::Registry::GetInstance().GetCounter(
+    "frames_skipped_static_total", "Number of decoded frames not encoded, "
+    "because scene is static")),
+motion_latency_(metrics::GetStageLatency("motion")),
+motion_detector_ptr_(),
+encoder_fps_gauge_(metrics::Registry::GetInstance().GetGauge(
+    "encoder_fps", "Encoded frames per second during the last second")),
+fps_window_start_time_(types::Clock::now()),
+fps_window_frame_count_(0),
+decoder_pool_(width, height, options.decoder_count,
+              [this] (const AVFrame &src_frame,
+                      const types::MjpegFrame &source) {
+                EncodeToH264(src_frame, source);
+              }) {
   AVCodec *enc = avcodec_find_encoder(AV_CODEC_ID_H264);
   enc_context_ptr_ = avcodec_alloc_context3(enc);
   enc_context_ptr_->width = width_;
   enc_context_ptr_->height = height_;
   enc_context_ptr_->bit_rate = 1024;
   enc_context_ptr_->pix_fmt = AV_PIX_FMT_YUV420P;
+  // JPEG samples are full range, so they are encoded as is
+  enc_context_ptr_->color_range = AVCOL_RANGE_JPEG;
+  // Pts are RTP timestamps, fps is nominal and is used only for rate control
   enc_context_ptr_->time_base.num = 1;
-  enc_context_ptr_->time_base.den = fps_;
+  enc_context_ptr_->time_base.den = kH264SampleRate;
   enc_context_ptr_->framerate.num = fps_;
   enc_context_ptr_->framerate.den = 1;
-  enc_context_ptr_->gop_size = 12;
+  // Key frames are forced by time in EncodeToH264(), so chunks can start with
+  // them. Frame count limit and scene cuts must not add others
+  enc_context_ptr_->gop_size = std::max<int64_t>(
+      1, 2 * key_frame_interval_ * fps_ / kH264SampleRate);
   enc_context_ptr_->max_b_frames = 0;
   av_opt_set(enc_context_ptr_->priv_data, "preset", "slow", 0);
+  av_opt_set(enc_context_ptr_->priv_data, "forced-idr", "1", 0);
+  av_opt_set(enc_context_ptr_, "sc_threshold", "0", AV_OPT_SEARCH_CHILDREN);
 
   if (avcodec_open2(enc_context_ptr_, enc, NULL) < 0) {
     throw std::runtime_error("avcodec_open2 error with encoding context");
   }
 
-  sws_context_ptr_ = sws_getContext(
-      dec_context_ptr_->width, dec_context_ptr_->height, dec_context_ptr_->pix_fmt,
-      enc_context_ptr_->width, enc_context_ptr_->height, enc_context_ptr_->pix_fmt,
-      SWS_BILINEAR, NULL, NULL, NULL);
-
-  src_frame_ptr_ = av_frame_alloc();
-
-  src_packet_ptr_ = av_packet_alloc();
-
   dst_frame_ptr_ = av_frame_alloc();
-  int res = av_image_alloc(dst_frame_ptr_->data, dst_frame_ptr_->linesize,
-                           enc_context_ptr_->width, enc_context_ptr_->height,
-                           enc_context_ptr_->pix_fmt, 32);
-  if (res < 0) {
-    throw std::runtime_error("Can't allocate memory for image");
-  }
-
-  dst_frame_ptr_->width = enc_context_ptr_->width;
-  dst_frame_ptr_->height = enc_context_ptr_->height;
-  dst_frame_ptr_->format = static_cast<int>(enc_context_ptr_->pix_fmt);
-  dst_frame_ptr_->pts = 0;
-
+  ref_frame_ptr_ = av_frame_alloc();
   dst_packet_ptr_ = av_packet_alloc();
+
+  if (options.motion_options) {
+    // Static scene still gets a frame to start every key frame interval with
+    MotionOptions motion_options = *options.motion_options;
+    motion_options.static_frame_interval = std::min(
+        motion_options.static_frame_interval, key_frame_interval_);
+    motion_detector_ptr_ = std::make_unique<MotionDetector>(motion_options);
+  }
 }
 
 MjpegToH264::~MjpegToH264() noexcept {
+  // Sequencer thread must not call EncodeToH264() with freed encoder
+  decoder_pool_.Stop();
   sws_freeContext(sws_context_ptr_);
-  avcodec_free_context(&dec_context_ptr_);
   avcodec_free_context(&enc_context_ptr_);
   av_freep(&dst_frame_ptr_->data);
-  av_frame_free(&src_frame_ptr_);
   av_frame_free(&dst_frame_ptr_);
-  av_packet_free(&src_packet_ptr_);
+  av_frame_free(&ref_frame_ptr_);
   av_packet_free(&dst_packet_ptr_);
 }
 
-void MjpegToH264::Receive(const types::MjpegFrame &frame) {
-  src_packet_ptr_->data = const_cast<types::Byte *>(frame.data.data());
-  src_packet_ptr_->size = frame.data.size();
+void MjpegToH264::Receive(DataPtr frame_ptr) {
+  decoder_pool_.Push(std::move(frame_ptr));
+}
 
-  int res = avcodec_send_packet(dec_context_ptr_, src_packet_ptr_);
-  if (res < 0) {
-    throw std::runtime_error("Error sending packet for decoding");
-  }
+void MjpegToH264::Flush() {
+  decoder_pool_.Flush();
+}
 
-  while (res >= 0) {
-    res = avcodec_receive_frame(dec_context_ptr_, src_frame_ptr_);
-    if ((res == AVERROR(EAGAIN)) || (res == AVERROR_EOF)) {
-      break;
-    } else if (res < 0) {
-      throw std::runtime_error("Error during decoding");
+void MjpegToH264::EncodeToH264(const AVFrame &src_frame,
+                               const types::MjpegFrame &source) {
+  const int64_t pts = GetPts(source.timestamp);
+  const bool is_key_frame = IsKeyFrameDue(pts);
+  if (motion_detector_ptr_ && !is_key_frame) {
+    bool is_needed = true;
+    {
+      metrics::ScopedTimer timer(motion_latency_);
+      is_needed = motion_detector_ptr_->IsFrameNeeded(
+          src_frame.data[0], src_frame.linesize[0], src_frame.width,
+          src_frame.height, pts);
+    }
+    if (!is_needed) {
+      static_frames_counter_.Add();
+      return;
     }
-
-    EncodeToH264();
   }
 
-  ++frame_counter_;
-}
-
-void MjpegToH264::EncodeToH264() {
-  sws_scale(sws_context_ptr_, src_frame_ptr_->data, src_frame_ptr_->linesize, 0,
-            src_frame_ptr_->height, dst_frame_ptr_->data, dst_frame_ptr_->linesize);
+  AVFrame *enc_frame_ptr = nullptr;
+  {
+    metrics::ScopedTimer timer(scale_latency_);
+    enc_frame_ptr = PrepareEncoderFrame(src_frame);
+  }
 
-  dst_frame_ptr_->pts = (1.0 / fps_) * kH264SampleRate * frame_counter_;
-  dst_packet_ptr_->dts = dst_frame_ptr_->pts;
+  enc_frame_ptr->pts = pts;
+  // Decoded JPEG frames are intra, so their type must not be passed on
+  enc_frame_ptr->pict_type = is_key_frame ? AV_PICTURE_TYPE_I :
+                                            AV_PICTURE_TYPE_NONE;
+  if (is_key_frame) {
+    has_key_frame_ = true;
+    key_frame_pts_ = pts;
+  }
+  dst_packet_ptr_->dts = enc_frame_ptr->pts;
   dst_packet_ptr_->pts = dst_packet_ptr_->dts;
+  ingest_times_[enc_frame_ptr->pts] = source.ingest_time;
 
-  int res = avcodec_send_frame(enc_context_ptr_, dst_frame_ptr_);
+  types::Timestamp encode_start_time = types::Clock::now();
+  int res = avcodec_send_frame(enc_context_ptr_, enc_frame_ptr);
+  // Encoder makes its own reference if it needs the frame later
+  av_frame_unref(ref_frame_ptr_);
   if (res < 0) {
     throw std::runtime_error("Error sending frame for encoding");
   }
@@ -163,16 +221,167 @@ void MjpegToH264::EncodeToH264() {
     } else if (res < 0) {
       throw std::runtime_error("Error during encoding");
     }
+    encode_latency_.RecordDuration(types::Clock::now() - encode_start_time);
+    CountEncodedFrame();
 
     types::H264Frame h264_frame;
     h264_frame.pts = dst_packet_ptr_->pts;
     h264_frame.dts = dst_packet_ptr_->dts;
-    h264_frame.data.reserve(dst_packet_ptr_->size);
-    std::move(dst_packet_ptr_->data,
-              dst_packet_ptr_->data + dst_packet_ptr_->size,
-              std::back_inserter(h264_frame.data));
-    ProvideToAll(h264_frame);
-    av_packet_unref(dst_packet_ptr_);
+    h264_frame.key_frame = (dst_packet_ptr_->flags & AV_PKT_FLAG_KEY) != 0;
+    h264_frame.ingest_time = TakeIngestTime(dst_packet_ptr_->pts);
+    h264_frame.data = TakePacketData();
+    ProvideToAll(std::move(h264_frame));
+    encode_start_time = types::Clock::now();
+  }
+}
+
+AVFrame *MjpegToH264::PrepareEncoderFrame(const AVFrame &src_frame) {
+  const auto src_format = static_cast<AVPixelFormat>(src_frame.format);
+  const AVPixelFormat src_layout_format = GetLayoutFormat(src_format);
+  const bool is_same_size = (src_frame.width == enc_context_ptr_->width) &&
+                            (src_frame.height == enc_context_ptr_->height);
+  if ((src_layout_format == enc_context_ptr_->pix_fmt) &&
+      IsFullRange(src_frame) && is_same_size) {
+    if (av_frame_ref(ref_frame_ptr_, &src_frame) < 0) {
+      throw std::runtime_error("Can't reference decoded frame");
+    }
+    ref_frame_ptr_->format = static_cast<int>(enc_context_ptr_->pix_fmt);
+    unscaled_frames_counter_.Add();
+    return ref_frame_ptr_;
+  }
+
+  // RTP/JPEG type 0 is 4:2:2, only chroma height differs from encoder format
+  if ((src_layout_format == AV_PIX_FMT_YUV422P) &&
+      (enc_context_ptr_->pix_fmt == AV_PIX_FMT_YUV420P) &&
+      IsFullRange(src_frame) && is_same_size) {
+    AllocateDstImage();
+    if (av_frame_ref(ref_frame_ptr_, &src_frame) < 0) {
+      throw std::runtime_error("Can't reference decoded frame");
+    }
+
+    const int chroma_width = (src_frame.width + 1) / 2;
+    for (int plane = 1; plane <= 2; ++plane) {
+      DownsampleChroma(src_frame.data[plane], src_frame.linesize[plane],
+                       dst_frame_ptr_->data[plane],
+                       dst_frame_ptr_->linesize[plane], chroma_width,
+                       src_frame.height);
+      ref_frame_ptr_->data[plane] = dst_frame_ptr_->data[plane];
+      ref_frame_ptr_->linesize[plane] = dst_frame_ptr_->linesize[plane];
+    }
+    ref_frame_ptr_->format = static_cast<int>(enc_context_ptr_->pix_fmt);
+    return ref_frame_ptr_;
+  }
+
+  // Old context is freed, if it doesn't suit the frame
+  SwsContext *sws_context_ptr = sws_getCachedContext(
+      sws_context_ptr_, src_frame.width, src_frame.height, src_format,
+      enc_context_ptr_->width, enc_context_ptr_->height,
+      enc_context_ptr_->pix_fmt, SWS_BILINEAR, NULL, NULL, NULL);
+  const bool is_new_context = (sws_context_ptr != sws_context_ptr_);
+  sws_context_ptr_ = sws_context_ptr;
+  if (!sws_context_ptr_) {
+    throw std::runtime_error("Can't create scaling context");
+  }
+  if (is_new_context) {
+    LOG(kInfo) << "Converting decoded " << src_frame.width << "x"
+               << src_frame.height << " " << av_get_pix_fmt_name(src_format)
+               << " frames to " << enc_context_ptr_->width << "x"
+               << enc_context_ptr_->height << " "
+               << av_get_pix_fmt_name(enc_context_ptr_->pix_fmt);
+    // Encoder signals full range, so converted samples must be full range too
+    const int *coefficients = sws_getCoefficients(SWS_CS_DEFAULT);
+    sws_setColorspaceDetails(sws_context_ptr_, coefficients,
+                             IsFullRange(src_frame) ? 1 : 0, coefficients, 1,
+                             0, 1 << 16, 1 << 16);
+  }
+
+  AllocateDstImage();
+  sws_scale(sws_context_ptr_, src_frame.data, src_frame.linesize,
+            0, src_frame.height, dst_frame_ptr_->data,
+            dst_frame_ptr_->linesize);
+  return dst_frame_ptr_;
+}
+
+void MjpegToH264::AllocateDstImage() {
+  if (dst_frame_ptr_->data[0]) {
+    return;
+  }
+
+  int res = av_image_alloc(dst_frame_ptr_->data, dst_frame_ptr_->linesize,
+                           enc_context_ptr_->width, enc_context_ptr_->height,
+                           enc_context_ptr_->pix_fmt, 32);
+  if (res < 0) {
+    throw std::runtime_error("Can't allocate memory for image");
+  }
+
+  dst_frame_ptr_->width = enc_context_ptr_->width;
+  dst_frame_ptr_->height = enc_context_ptr_->height;
+  dst_frame_ptr_->format = static_cast<int>(enc_context_ptr_->pix_fmt);
+}
+
+bool MjpegToH264::IsKeyFrameDue(const int64_t pts) const {
+  // Same rule finishes chunks in Mpeg2TsPackager, so they start with key frames
+  return !has_key_frame_ ||
+         (pts + kH264SampleRate / fps_ - key_frame_pts_ > key_frame_interval_);
+}
+
+int64_t MjpegToH264::GetPts(const int64_t timestamp) {
+  if (!has_pts_) {
+    has_pts_ = true;
+    timestamp_offset_ = -timestamp;
+  } else {
+    const int64_t gap = timestamp + timestamp_offset_ - last_pts_;
+    if ((gap <= 0) || (gap > kMaxTimestampGap)) {
+      LOG(kInfo) << "Source timestamps jumped by " << gap << ", continuing "
+                    "after the last frame";
+      timestamp_offset_ = last_pts_ + kH264SampleRate / fps_ - timestamp;
+    }
+  }
+
+  last_pts_ = timestamp + timestamp_offset_;
+  return last_pts_;
+}
+
+types::SharedBuffer MjpegToH264::TakePacketData() {
+  if (av_packet_make_refcounted(dst_packet_ptr_) < 0) {
+    throw std::runtime_error("Can't reference encoded packet");
+  }
+
+  // Encoder's buffer is taken from the packet, so it's shared without copying
+  std::shared_ptr<AVBufferRef> buffer_ptr(
+      dst_packet_ptr_->buf, [] (AVBufferRef *buffer_ptr) {
+        av_buffer_unref(&buffer_ptr);
+      });
+  types::SharedBuffer data(buffer_ptr, dst_packet_ptr_->data,
+                           dst_packet_ptr_->size);
+  dst_packet_ptr_->buf = nullptr;
+  av_packet_unref(dst_packet_ptr_);
+
+  return data;
+}
+
+types::Timestamp MjpegToH264::TakeIngestTime(const int64_t pts) {
+  types::Timestamp ingest_time = types::Clock::now();
+  auto it = ingest_times_.find(pts);
+  if (it != ingest_times_.end()) {
+    ingest_time = it->second;
+  }
+
+  // Encoder doesn't return frames it has dropped, so older entries are stale
+  ingest_times_.erase(ingest_times_.begin(), ingest_times_.upper_bound(pts));
+  return ingest_time;
+}
+
+void MjpegToH264::CountEncodedFrame() {
+  encoded_frames_counter_.Add();
+  ++fps_window_frame_count_;
+
+  const types::Timestamp now = types::Clock::now();
+  const std::chrono::duration<double> elapsed = now - fps_window_start_time_;
+  if (elapsed >= std::chrono::seconds(1)) {
+    encoder_fps_gauge_.Set(fps_window_frame_count_ / elapsed.count());
+    fps_window_start_time_ = now;
+    fps_window_frame_count_ = 0;
   }
 }
 
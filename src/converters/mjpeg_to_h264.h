@@ -28,6 +28,10 @@ SOFTWARE.
 #include "provider.h"
 #include "types/mjpeg_frame.h"
 #include "types/h264_frame.h"
+#include "jpeg_decoder_pool.h"
+#include "motion_detector.h"
+#include "metrics/counter.h"
+#include "metrics/histogram.h"
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -35,11 +39,29 @@ extern "C" {
 }
 
 #include <fstream>
+#include <map>
+#include <memory>
+#include <optional>
 
 namespace converters {
 
+/**
+ * @brief Options of MjpegToH264
+ */
+struct MjpegToH264Options {
+  //! Number of threads decoding JPEG frames in parallel
+  std::size_t decoder_count = 1;
+  //! Frames of static scene are skipped, if set. Every frame is encoded, if not
+  std::optional<MotionOptions> motion_options;
+  //! Max time between key frames in 90 kHz units. Key frame is forced before
+  //! the frame, that would be displayed past it
+  int64_t key_frame_interval = 180'000;
+};
+
 /**
  * @brief Converts MJPEG-encoded video to H264-encoded
+ * @details JPEG frames are decoded by a pool of threads, and a single encoder
+ * gets them in the original order on the pool's sequencer thread
  */
  class MjpegToH264 : public Observer<types::MjpegFrame>,
                      public Provider<types::H264Frame> {
@@ -48,33 +70,125 @@ namespace converters {
      * @param width Image width
      * @param height Image height
      * @param fps Video fps
+     * @param options Decoding and encoding options
      */
-    MjpegToH264(int width, int height, int fps);
+    MjpegToH264(int width, int height, int fps,
+                const MjpegToH264Options &options = MjpegToH264Options());
 
    ~MjpegToH264() noexcept override;
 
     MjpegToH264(const MjpegToH264 &) = delete;
     MjpegToH264 &operator=(const MjpegToH264 &) = delete;
 
-    void Receive(const types::MjpegFrame &frame) override;
+    /**
+     * @brief Queue frame for decoding. Encoded frames are provided from the
+     * decoder pool thread in the same order
+     */
+    void Receive(DataPtr frame_ptr) override;
+
+    /**
+     * @brief Wait until all received frames are encoded
+     */
+    void Flush();
 
   private:
    const int width_;
    const int height_;
    const int fps_;
-   AVCodecContext *dec_context_ptr_;
+   const int64_t key_frame_interval_; //!< Max time between key frames
    AVCodecContext *enc_context_ptr_;
-   AVFrame *src_frame_ptr_;
+   //! Converted frame. Image is allocated with the first conversion
    AVFrame *dst_frame_ptr_;
-   AVPacket *src_packet_ptr_;
+   //! Reference to decoded frame, when its luma is passed to encoder as is
+   AVFrame *ref_frame_ptr_;
    AVPacket *dst_packet_ptr_;
+   //! Created for the actual decoder output, when it can't be encoded as is
    SwsContext *sws_context_ptr_;
-   uint64_t frame_counter_;
+   bool has_pts_; //!< True, if at least one frame was encoded
+   int64_t last_pts_; //!< Pts of the last frame sent to encoder
+   //! Difference between pts and RTP timestamp of the current stream
+   int64_t timestamp_offset_;
+   bool has_key_frame_; //!< True, if at least one key frame was forced
+   int64_t key_frame_pts_; //!< Pts of the last forced key frame
+   //! Pts of frames inside encoder -> ingest time of their source frames
+   std::map<int64_t, types::Timestamp> ingest_times_;
+   metrics::Histogram &scale_latency_;
+   metrics::Histogram &encode_latency_;
+   metrics::Counter &encoded_frames_counter_;
+   metrics::Counter &unscaled_frames_counter_;
+   metrics::Counter &static_frames_counter_; //!< Frames skipped as static
+   metrics::Histogram &motion_latency_;
+   //! Skips frames of static scene. nullptr, if every frame is encoded
+   std::unique_ptr<MotionDetector> motion_detector_ptr_;
+   metrics::Gauge &encoder_fps_gauge_;
+   //! Start of the current encoder fps measurement window
+   types::Timestamp fps_window_start_time_;
+   uint64_t fps_window_frame_count_; //!< Frames encoded in current window
+   //! Decodes frames and calls EncodeToH264() in order. Stopped at the start
+   //! of destructor, before the encoder is freed
+   JpegDecoderPool decoder_pool_;
+
+   /**
+    * @brief Encode raw frame with H.264 codec and provide encoded frames
+    *
+    * @param src_frame Decoded frame
+    * @param source Source JPEG frame
+    */
+   void EncodeToH264(const AVFrame &src_frame, const types::MjpegFrame &source);
+
+   /**
+    * @param pts Pts of the next frame
+    * @return True, if the frame must be a key frame
+    */
+   [[nodiscard]] bool IsKeyFrameDue(int64_t pts) const;
+
+   /**
+    * @brief Convert RTP timestamp to pts
+    * @details Pts starts from 0 and follows RTP timestamps, so dropped frames
+    * and camera clock drift keep real timing. Jumps back or too far forward
+    * (new RTSP session, camera restart) continue one frame after the last pts
+    *
+    * @param timestamp Extended RTP timestamp of frame
+    * @return Pts in 90 kHz units
+    */
+   int64_t GetPts(int64_t timestamp);
+
+   /**
+    * @brief Get frame in encoder format
+    * @details If decoded frame already has encoder layout and size, it's
+    * referenced without copying. 4:2:2 frames reference decoded luma and get
+    * chroma downsampled to dst_frame_ planes. Otherwise frame is converted to
+    * dst_frame_ with scaling context made for its format
+    *
+    * @param src_frame Decoded frame
+    * @return ref_frame_ or dst_frame_
+    */
+   AVFrame *PrepareEncoderFrame(const AVFrame &src_frame);
+
+   /**
+    * @brief Allocate dst_frame_ image in encoder format, if it isn't allocated
+    */
+   void AllocateDstImage();
+
+   /**
+    * @brief Take encoded data out of dst_packet_ and reset the packet
+    *
+    * @return Data referencing encoder's packet buffer
+    */
+   types::SharedBuffer TakePacketData();
+
+   /**
+    * @brief Take ingest time of the frame with given pts and forget older ones
+    *
+    * @param pts Pts of encoded frame
+    * @return Ingest time of the source frame
+    */
+   types::Timestamp TakeIngestTime(int64_t pts);
 
    /**
-    * @brief Encode raw frame in src_frame_ with H.264 codec and put it to dst_packet_
+    * @brief Count encoded frame and update encoder fps once per second
     */
-   void EncodeToH264();
+   void CountEncodedFrame();
 };
 
 } // namespace converters
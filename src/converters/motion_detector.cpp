@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "motion_detector.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace converters {
+
+MotionDetector::MotionDetector(const MotionOptions &options):
+options_(options),
+cells_(),
+reference_cells_(),
+cells_width_(0),
+cells_height_(0),
+has_reference_(false),
+reference_pts_(0),
+motion_pts_(0) {
+}
+
+bool MotionDetector::IsFrameNeeded(const uint8_t *luma, const int stride,
+                                   const int width, const int height,
+                                   const int64_t pts) {
+  const int previous_cells_width = cells_width_;
+  const int previous_cells_height = cells_height_;
+  Downscale(luma, stride, width, height);
+
+  // Frame of other size can't be compared, so it's taken as motion
+  const bool is_comparable = has_reference_ &&
+                             (cells_width_ == previous_cells_width) &&
+                             (cells_height_ == previous_cells_height);
+  if (!is_comparable ||
+      (CountChangedBlocks() >= options_.min_changed_blocks)) {
+    motion_pts_ = pts;
+  } else if ((pts - motion_pts_ >= options_.motion_hold_duration) &&
+             (pts - reference_pts_ < options_.static_frame_interval)) {
+    return false;
+  }
+
+  has_reference_ = true;
+  reference_pts_ = pts;
+  std::swap(cells_, reference_cells_);
+  return true;
+}
+
+void MotionDetector::Downscale(const uint8_t *luma, const int stride,
+                               const int width, const int height) {
+  cells_width_ = width / kCellSize;
+  cells_height_ = height / kCellSize;
+  cells_.resize(cells_width_ * cells_height_);
+
+  std::vector<uint32_t> row_sums(cells_width_);
+  for (int cell_y = 0; cell_y < cells_height_; ++cell_y) {
+    std::fill(row_sums.begin(), row_sums.end(), 0);
+    for (int y = cell_y * kCellSize; y < (cell_y + 1) * kCellSize; ++y) {
+      const uint8_t *row = luma + y * stride;
+      for (int x = 0; x < cells_width_ * kCellSize; ++x) {
+        row_sums[x / kCellSize] += row[x];
+      }
+    }
+
+    for (int cell_x = 0; cell_x < cells_width_; ++cell_x) {
+      cells_[cell_y * cells_width_ + cell_x] = static_cast<uint8_t>(
+          row_sums[cell_x] / (kCellSize * kCellSize));
+    }
+  }
+}
+
+int MotionDetector::CountChangedBlocks() const {
+  int changed_block_count = 0;
+  for (int block_y = 0; block_y < cells_height_; block_y += kBlockSize) {
+    for (int block_x = 0; block_x < cells_width_; block_x += kBlockSize) {
+      const int block_height = std::min(kBlockSize, cells_height_ - block_y);
+      const int block_width = std::min(kBlockSize, cells_width_ - block_x);
+      int sad = 0;
+      for (int y = block_y; y < block_y + block_height; ++y) {
+        for (int x = block_x; x < block_x + block_width; ++x) {
+          const int index = y * cells_width_ + x;
+          sad += std::abs(cells_[index] - reference_cells_[index]);
+        }
+      }
+
+      if (sad > options_.block_threshold * block_width * block_height) {
+        ++changed_block_count;
+      }
+    }
+  }
+
+  return changed_block_count;
+}
+
+} // namespace converters
@@ -0,0 +1,99 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace converters {
+
+/**
+ * @brief Options of MotionDetector
+ */
+struct MotionOptions {
+  //! Mean absolute luma difference of changed block
+  int block_threshold = 8;
+  //! Number of changed blocks, that means motion
+  int min_changed_blocks = 1;
+  //! Max interval between encoded frames of static scene in 90 kHz units
+  int64_t static_frame_interval = 90'000;
+  //! Time to keep full frame rate after the last motion in 90 kHz units
+  int64_t motion_hold_duration = 180'000;
+};
+
+/**
+ * @brief Decides, which frames of a mostly static scene need to be encoded
+ * @details Luma is downscaled by averaging 8x8 pixel cells, and the result is
+ * compared with the last encoded frame by blocks of 8x8 cells. Frame is needed
+ * if enough blocks changed, for a while after motion, and periodically, so
+ * static scene still gets frames at reduced rate
+ */
+class MotionDetector {
+ public:
+  /**
+   * @param options Detection thresholds
+   */
+  explicit MotionDetector(const MotionOptions &options);
+
+  /**
+   * @brief Check frame and remember it as reference, if it's needed
+   *
+   * @param luma Luma plane
+   * @param stride Luma line size in bytes
+   * @param width Image width
+   * @param height Image height
+   * @param pts Frame pts in 90 kHz units
+   * @return True, if frame should be encoded
+   */
+  [[nodiscard]] bool IsFrameNeeded(const uint8_t *luma, int stride, int width,
+                                   int height, int64_t pts);
+
+ private:
+  //! Size of square cell averaged to one downscaled pixel
+  static constexpr int kCellSize = 8;
+  //! Size of square block of downscaled pixels compared at once
+  static constexpr int kBlockSize = 8;
+
+  const MotionOptions options_;
+  std::vector<uint8_t> cells_; //!< Downscaled luma of the current frame
+  std::vector<uint8_t> reference_cells_; //!< Downscaled luma of encoded frame
+  int cells_width_; //!< Width of downscaled plane
+  int cells_height_; //!< Height of downscaled plane
+  bool has_reference_; //!< True, if at least one frame was needed
+  int64_t reference_pts_; //!< Pts of the last needed frame
+  int64_t motion_pts_; //!< Pts of the last frame with motion
+
+  /**
+   * @brief Average luma cells into cells_
+   */
+  void Downscale(const uint8_t *luma, int stride, int width, int height);
+
+  /**
+   * @return Number of blocks, that differ from reference by more than threshold
+   */
+  [[nodiscard]] int CountChangedBlocks() const;
+};
+
+} // namespace converters
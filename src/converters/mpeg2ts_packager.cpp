@@ -24,10 +24,20 @@ SOFTWARE.
 
 #include "mpeg2ts_packager.h"
 
+#include <algorithm>
 #include <stdexcept>
+
+#include "metrics/registry.h"
 //#include <iostream>
 //#include <fstream>
 
+namespace {
+
+//! MPEG2-TS timestamps are always in 90 kHz units
+const int64_t kMpeg2TsSampleRate = 90'000;
+
+} // namespace
+
 namespace converters {
 
 Mpeg2TsPackager::Mpeg2TsPackager(const int width, const int height,
@@ -35,14 +45,28 @@ Mpeg2TsPackager::Mpeg2TsPackager(const int width, const int height,
 width_(width),
 height_(height),
 fps_(fps),
-chunk_duration_(chunk_duration),
-frames_per_chunk_(fps_ * chunk_duration_),
+chunk_duration_pts_(chunk_duration * kMpeg2TsSampleRate),
+frame_duration_pts_(kMpeg2TsSampleRate / fps),
 chunk_frame_counter_(0),
+chunk_start_pts_(0),
+last_frame_pts_(0),
 chunk_counter_(0),
 output_context_ptr_(nullptr),
 buffer_data_(),
 format_context_ptr_(nullptr),
-packet_ptr_(nullptr) {
+packet_ptr_(nullptr),
+last_ingest_time_(),
+waiting_for_key_frame_(true),
+reset_time_(),
+mux_latency_(metrics::GetStageLatency("mux")),
+segments_counter_(metrics::Registry::GetInstance().GetCounter(
+    "segments_total", "Number of packed MPEG2-TS segments")),
+segment_bytes_counter_(metrics::Registry::GetInstance().GetCounter(
+    "segment_bytes_total", "Total size of packed MPEG2-TS segments")),
+segment_size_gauge_(metrics::Registry::GetInstance().GetGauge(
+    "segment_size_bytes", "Size of the last MPEG2-TS segment")),
+segment_duration_gauge_(metrics::Registry::GetInstance().GetGauge(
+    "segment_duration_seconds", "Duration of the last MPEG2-TS segment")) {
   InitOutputContext();
   InitFormatContext();
   InitVideoStream();
@@ -59,41 +83,91 @@ Mpeg2TsPackager::~Mpeg2TsPackager() noexcept {
   avio_context_free(&output_context_ptr_);
 }
 
-void Mpeg2TsPackager::Receive(const types::H264Frame &frame) {
-  ++chunk_frame_counter_;
+void Mpeg2TsPackager::Receive(DataPtr frame_ptr) {
+  // Chunk must be decodable on its own
+  if (frame_ptr->ingest_time < reset_time_) {
+    return;
+  }
+  if (waiting_for_key_frame_) {
+    if (!frame_ptr->key_frame) {
+      return;
+    }
+    waiting_for_key_frame_ = false;
+  }
 
-  WriteFrame(frame);
+  // Chunk ends where the next one starts, so its duration includes display
+  // time of its last frame. Frame, that would be displayed past the target
+  // duration, starts the next chunk. Chunk must be decodable on its own, so
+  // it's cut only at a key frame. Encoder forces key frames by the same rule
+  if ((chunk_frame_counter_ > 0) && frame_ptr->key_frame &&
+      (frame_ptr->pts + frame_duration_pts_ - chunk_start_pts_ >
+       chunk_duration_pts_)) {
+    // Long source gap before the frame isn't counted beyond the target
+    FinishChunk(std::min(frame_ptr->pts,
+                         std::max(chunk_start_pts_ + chunk_duration_pts_,
+                                  last_frame_pts_ + frame_duration_pts_)));
+  }
 
-  if (chunk_frame_counter_ >= static_cast<int>(frames_per_chunk_)) {
-    WriteTrailer();
+  if (chunk_frame_counter_ == 0) {
+    chunk_start_pts_ = frame_ptr->pts;
+  }
+  ++chunk_frame_counter_;
 
-    // Saving chunk
-//    {
-//      using namespace std::string_literals;
-//      static int chunk_counter = 0;
-//
-//      ++chunk_counter;
-//      const std::string filename = "chunk"s + std::to_string(chunk_counter) +
-//                                   ".mpegts";
-//      std::ofstream file(filename, std::ios::out | std::ios::binary);
-//      const types::Bytes &data_to_write = buffer_data_.data;
-//      file.write(reinterpret_cast<const char *>(data_to_write.data()),
-//                 data_to_write.size());
-//      std::cout << "Chunk saved in " << filename << std::endl;
-//    }
-
-    types::Mpeg2TsChunk chunk;
-    chunk.duration = chunk_frame_counter_ / fps_;
-    chunk.media_sequence_number = chunk_counter_;
-    chunk.data = std::move(buffer_data_.data);
-    ProvideToAll(chunk);
+  metrics::ScopedTimer timer(mux_latency_);
+  WriteFrame(*frame_ptr);
+  last_frame_pts_ = frame_ptr->pts;
+  last_ingest_time_ = frame_ptr->ingest_time;
+}
 
+void Mpeg2TsPackager::Reset() {
+  if (chunk_frame_counter_ > 0) {
+    WriteTrailer();
     buffer_data_.data.clear();
     chunk_frame_counter_ = 0;
-    ++chunk_counter_;
-
     WriteHeader();
   }
+  waiting_for_key_frame_ = true;
+  reset_time_ = types::Clock::now();
+}
+
+void Mpeg2TsPackager::FinishChunk(const int64_t end_pts) {
+  {
+    metrics::ScopedTimer timer(mux_latency_);
+    WriteTrailer();
+  }
+
+  // Saving chunk
+//  {
+//    using namespace std::string_literals;
+//    static int chunk_counter = 0;
+//
+//    ++chunk_counter;
+//    const std::string filename = "chunk"s + std::to_string(chunk_counter) +
+//                                 ".mpegts";
+//    std::ofstream file(filename, std::ios::out | std::ios::binary);
+//    const types::Bytes &data_to_write = buffer_data_.data;
+//    file.write(reinterpret_cast<const char *>(data_to_write.data()),
+//               data_to_write.size());
+//    std::cout << "Chunk saved in " << filename << std::endl;
+//  }
+
+  types::Mpeg2TsChunk chunk;
+  chunk.duration = static_cast<float>(end_pts - chunk_start_pts_) /
+                   kMpeg2TsSampleRate;
+  chunk.media_sequence_number = chunk_counter_;
+  chunk.data = std::move(buffer_data_.data);
+  chunk.ingest_time = last_ingest_time_;
+  segments_counter_.Add();
+  segment_bytes_counter_.Add(chunk.data.size());
+  segment_size_gauge_.Set(chunk.data.size());
+  segment_duration_gauge_.Set(chunk.duration);
+  ProvideToAll(std::move(chunk));
+
+  buffer_data_.data.clear();
+  chunk_frame_counter_ = 0;
+  ++chunk_counter_;
+
+  WriteHeader();
 }
 
 void Mpeg2TsPackager::InitOutputContext() {
@@ -143,8 +217,12 @@ void Mpeg2TsPackager::WriteFrame(const types::H264Frame &frame) {
   packet_ptr_->dts = frame.dts;
   packet_ptr_->data = const_cast<types::Byte *>(frame.data.data());
   packet_ptr_->size = frame.data.size();
+  // Marks random access points in the stream
+  packet_ptr_->flags = frame.key_frame ? AV_PKT_FLAG_KEY : 0;
 
-  if (av_interleaved_write_frame(format_context_ptr_, packet_ptr_)) {
+  // There is only one stream, so no interleaving is needed. Unlike
+  // av_interleaved_write_frame() it doesn't copy packet data without buffer
+  if (av_write_frame(format_context_ptr_, packet_ptr_) < 0) {
     throw std::runtime_error("Can't write packet");
   }
 
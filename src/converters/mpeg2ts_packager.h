@@ -28,6 +28,8 @@ SOFTWARE.
 #include "provider.h"
 #include "types/h264_frame.h"
 #include "types/mpeg2ts_chunk.h"
+#include "metrics/counter.h"
+#include "metrics/histogram.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -47,7 +49,9 @@ namespace converters {
    * @param width Image width
    * @param height Image height
    * @param fps Video fps
-   * @param chunk_duration_sec Chunk max duration in seconds
+   * @param chunk_duration Max chunk duration in seconds. Chunk is finished
+   * at the key frame, that would be displayed past it. Encoder must force key
+   * frames with the same interval
    */
   Mpeg2TsPackager(int width, int height, int fps, float chunk_duration);
 
@@ -56,7 +60,15 @@ namespace converters {
   Mpeg2TsPackager(const Mpeg2TsPackager &) = delete;
   Mpeg2TsPackager &operator=(const Mpeg2TsPackager &) = delete;
 
-  void Receive(const types::H264Frame &frame) override;
+  void Receive(DataPtr frame_ptr) override;
+
+  /**
+   * @brief Drop unfinished chunk and start the next one from a key frame
+   * ingested after this call
+   * @details Used when ingest is restarted, so chunks never mix frames of
+   * different runs. Must not be called concurrently with Receive()
+   */
+  void Reset();
 
  private:
   /**
@@ -81,15 +93,30 @@ namespace converters {
   const int width_; //!< Image width
   const int height_; //!< Image height
   const int fps_; //!< Video fps
-  const int chunk_duration_; //!< Chunk max duration
-  const float frames_per_chunk_; //!< Number of frames per chunk
+  const int64_t chunk_duration_pts_; //!< Max chunk duration in 90 kHz units
+  //! Nominal frame display time in 90 kHz units
+  const int64_t frame_duration_pts_;
   int chunk_frame_counter_; //!< Number of frames for current chunk
+  int64_t chunk_start_pts_; //!< Pts of the first frame of current chunk
+  int64_t last_frame_pts_; //!< Pts of the last frame of current chunk
   uint64_t chunk_counter_; //!< Number of packed chunks
   AVIOContext *output_context_ptr_; //!< Output context to write into buffer
   BufferData buffer_data_; //!< Buffer to write data
   //! Format context to pack data into container
   AVFormatContext *format_context_ptr_;
   AVPacket *packet_ptr_; //!< Packet with compressed data
+  //! Ingest time of the last frame written to current chunk
+  types::Timestamp last_ingest_time_;
+  //! True, if frames are dropped until the next key frame
+  bool waiting_for_key_frame_;
+  //! Frames ingested before it are dropped. They are left in the encoder
+  //! from the previous run
+  types::Timestamp reset_time_;
+  metrics::Histogram &mux_latency_;
+  metrics::Counter &segments_counter_;
+  metrics::Counter &segment_bytes_counter_;
+  metrics::Gauge &segment_size_gauge_; //!< Size of the last segment
+  metrics::Gauge &segment_duration_gauge_; //!< Duration of the last segment
 
   /**
    * @brief Init output_context_ptr_
@@ -122,6 +149,13 @@ namespace converters {
    * @brief Write container trailer
    */
   void WriteTrailer();
+
+  /**
+   * @brief Write trailer, provide current chunk and start the next one
+   *
+   * @param end_pts Pts of the first frame after the chunk
+   */
+  void FinishChunk(int64_t end_pts);
 };
 
 } // namespace converters
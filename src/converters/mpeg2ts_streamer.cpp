@@ -0,0 +1,143 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "mpeg2ts_streamer.h"
+
+#include <stdexcept>
+
+#include "metrics/registry.h"
+
+extern "C" {
+#include <libavutil/opt.h>
+}
+
+namespace converters {
+
+Mpeg2TsStreamer::Mpeg2TsStreamer(const int width, const int height):
+width_(width),
+height_(height),
+output_context_ptr_(nullptr),
+buffer_(),
+format_context_ptr_(nullptr),
+packet_ptr_(nullptr),
+mux_latency_(metrics::GetStageLatency("stream_mux")),
+fragment_bytes_counter_(metrics::Registry::GetInstance().GetCounter(
+    "stream_fragment_bytes_total", "Total size of packed MPEG2-TS stream")) {
+  InitOutputContext();
+  InitFormatContext();
+
+  packet_ptr_ = av_packet_alloc();
+}
+
+Mpeg2TsStreamer::~Mpeg2TsStreamer() noexcept {
+  av_packet_free(&packet_ptr_);
+  avformat_free_context(format_context_ptr_);
+  av_freep(&output_context_ptr_->buffer);
+  avio_context_free(&output_context_ptr_);
+}
+
+void Mpeg2TsStreamer::Receive(DataPtr frame_ptr) {
+  types::Mpeg2TsFragment fragment;
+  {
+    metrics::ScopedTimer timer(mux_latency_);
+    WriteFrame(*frame_ptr);
+  }
+
+  fragment.key_frame = frame_ptr->key_frame;
+  fragment.ingest_time = frame_ptr->ingest_time;
+  fragment_bytes_counter_.Add(buffer_.size());
+  fragment.data = types::SharedBuffer(std::move(buffer_));
+  buffer_.clear();
+  ProvideToAll(std::move(fragment));
+}
+
+void Mpeg2TsStreamer::InitOutputContext() {
+  const int kOutputContextBufferSize = 4096;
+
+  types::Byte *output_context_buffer_ptr = reinterpret_cast<types::Byte *>(
+      av_malloc(kOutputContextBufferSize));
+  output_context_ptr_ = avio_alloc_context(
+      output_context_buffer_ptr, kOutputContextBufferSize, 1, this,
+      NULL, WritePacket, NULL);
+  if (output_context_ptr_ == NULL) {
+    throw std::runtime_error("Could not create context");
+  }
+}
+
+void Mpeg2TsStreamer::InitFormatContext() {
+  avformat_alloc_output_context2(&format_context_ptr_, NULL, "mpegts", NULL);
+  if (format_context_ptr_ == NULL) {
+    throw std::runtime_error("Could not create MPEG-2 TS output format context");
+  }
+  format_context_ptr_->pb = output_context_ptr_;
+
+  AVCodec *video_codec_ptr = avcodec_find_encoder(AV_CODEC_ID_H264);
+  AVStream *video_stream_ptr = avformat_new_stream(format_context_ptr_,
+                                                   video_codec_ptr);
+  if (video_stream_ptr == NULL) {
+    throw std::runtime_error("Could not create new output stream");
+  }
+  video_stream_ptr->id = format_context_ptr_->nb_streams - 1;
+  AVCodecParameters *params_ptr = video_stream_ptr->codecpar;
+  params_ptr->codec_id = AV_CODEC_ID_H264;
+  params_ptr->codec_type = AVMEDIA_TYPE_VIDEO;
+  params_ptr->width = width_;
+  params_ptr->height = height_;
+
+  if (avformat_write_header(format_context_ptr_, NULL) < 0) {
+    throw std::runtime_error("Could not write header");
+  }
+}
+
+void Mpeg2TsStreamer::WriteFrame(const types::H264Frame &frame) {
+  if (frame.key_frame) {
+    av_opt_set(format_context_ptr_->priv_data, "mpegts_flags",
+               "+resend_headers", 0);
+  }
+
+  packet_ptr_->pts = frame.pts;
+  packet_ptr_->dts = frame.dts;
+  packet_ptr_->data = const_cast<types::Byte *>(frame.data.data());
+  packet_ptr_->size = frame.data.size();
+  packet_ptr_->flags = frame.key_frame ? AV_PKT_FLAG_KEY : 0;
+
+  if (av_write_frame(format_context_ptr_, packet_ptr_) < 0) {
+    throw std::runtime_error("Can't write packet");
+  }
+  av_packet_unref(packet_ptr_);
+
+  // Fragment must contain the whole frame
+  avio_flush(output_context_ptr_);
+}
+
+int Mpeg2TsStreamer::WritePacket(void *opaque, uint8_t *buf,
+                                 const int buf_size) {
+  auto streamer_ptr = reinterpret_cast<Mpeg2TsStreamer *>(opaque);
+  streamer_ptr->buffer_.insert(streamer_ptr->buffer_.end(), buf,
+                               buf + buf_size);
+
+  return buf_size;
+}
+
+} // namespace converters
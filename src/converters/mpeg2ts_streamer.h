@@ -0,0 +1,103 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "observer.h"
+#include "provider.h"
+#include "types/h264_frame.h"
+#include "types/mpeg2ts_fragment.h"
+#include "metrics/counter.h"
+#include "metrics/histogram.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace converters {
+
+/**
+ * @brief Packs H.264 frames into one endless MPEG2-TS stream
+ * @details Unlike Mpeg2TsPackager, stream isn't cut into chunks. Every frame is
+ * provided as soon as it's packed, so clients get it with sub-second latency
+ */
+class Mpeg2TsStreamer : public Observer<types::H264Frame>,
+                        public Provider<types::Mpeg2TsFragment> {
+ public:
+  /**
+   * @param width Image width
+   * @param height Image height
+   */
+  Mpeg2TsStreamer(int width, int height);
+
+  ~Mpeg2TsStreamer() noexcept override;
+
+  Mpeg2TsStreamer(const Mpeg2TsStreamer &) = delete;
+  Mpeg2TsStreamer &operator=(const Mpeg2TsStreamer &) = delete;
+
+  void Receive(DataPtr frame_ptr) override;
+
+ private:
+  const int width_; //!< Image width
+  const int height_; //!< Image height
+  AVIOContext *output_context_ptr_; //!< Output context to write into buffer
+  types::Bytes buffer_; //!< Packets of the current frame
+  //! Format context to pack data into container
+  AVFormatContext *format_context_ptr_;
+  AVPacket *packet_ptr_; //!< Packet with compressed data
+  metrics::Histogram &mux_latency_;
+  metrics::Counter &fragment_bytes_counter_;
+
+  /**
+   * @brief Append data to buffer_
+   * @details Function for ffmpeg avio_alloc_context() API
+   *
+   * @param opaque Pointer to Mpeg2TsStreamer
+   * @param buf Pointer to data
+   * @param buf_size Size of data
+   * @return Size of written data
+   */
+  static int WritePacket(void *opaque, types::Byte *buf, int buf_size);
+
+  /**
+   * @brief Init output_context_ptr_
+   */
+  void InitOutputContext();
+
+  /**
+   * @brief Init format_context_ptr_ with one H.264 stream and write header
+   */
+  void InitFormatContext();
+
+  /**
+   * @brief Write frame to buffer_
+   * @details PAT and PMT are written before every key frame, so clients can
+   * start playback from it
+   *
+   * @param frame H.264 encoded frame
+   */
+  void WriteFrame(const types::H264Frame &frame);
+};
+
+} // namespace converters
@@ -0,0 +1,149 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "segment_store.h"
+
+#include <cstring>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <stdexcept>
+
+namespace {
+
+/**
+ * @brief Write all bytes to file
+ * @throw std::runtime_error if write failed
+ *
+ * @param descriptor File descriptor
+ * @param bytes Bytes to write
+ */
+void WriteAll(const int descriptor, const types::Bytes &bytes) {
+  std::size_t written = 0;
+  while (written < bytes.size()) {
+    ssize_t res = write(descriptor, bytes.data() + written,
+                        bytes.size() - written);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("Can't write chunk: ") +
+                               strerror(errno));
+    }
+    written += res;
+  }
+}
+
+} // namespace
+
+namespace hls {
+
+SegmentStore::SegmentStore(std::string directory,
+                           const std::size_t segment_count) :
+directory_(std::move(directory)),
+segment_count_(segment_count),
+first_stored_number_(0),
+next_number_(0) {
+  if ((mkdir(directory_.c_str(), 0755) < 0) && (errno != EEXIST)) {
+    throw std::runtime_error("Can't create directory " + directory_ + ": " +
+                             strerror(errno));
+  }
+}
+
+SegmentStore::~SegmentStore() {
+  Clear();
+  // Directory is left if there are other files
+  rmdir(directory_.c_str());
+}
+
+void SegmentStore::Store(const types::Mpeg2TsChunk &chunk) {
+  // Numbering restarts with a new packager, so the old window is dropped
+  if ((next_number_ != 0) && (chunk.media_sequence_number != next_number_)) {
+    Clear();
+  }
+
+  const std::string path = BuildPath(chunk.media_sequence_number);
+  const std::string tmp_path = path + ".tmp";
+
+  int descriptor = open(tmp_path.c_str(),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (descriptor < 0) {
+    throw std::runtime_error("Can't create " + tmp_path + ": " +
+                             strerror(errno));
+  }
+  try {
+    WriteAll(descriptor, chunk.data);
+  } catch (const std::runtime_error &) {
+    close(descriptor);
+    unlink(tmp_path.c_str());
+    throw;
+  }
+  close(descriptor);
+
+  if (rename(tmp_path.c_str(), path.c_str()) < 0) {
+    unlink(tmp_path.c_str());
+    throw std::runtime_error("Can't publish " + path + ": " + strerror(errno));
+  }
+
+  if (next_number_ == 0) {
+    first_stored_number_ = chunk.media_sequence_number;
+  }
+  next_number_ = chunk.media_sequence_number + 1;
+  while (next_number_ - first_stored_number_ > segment_count_) {
+    unlink(BuildPath(first_stored_number_).c_str());
+    ++first_stored_number_;
+  }
+}
+
+std::shared_ptr<const http::BodyFile> SegmentStore::Open(
+    const uint64_t media_sequence_number) const {
+  int descriptor = open(BuildPath(media_sequence_number).c_str(),
+                        O_RDONLY | O_CLOEXEC);
+  if (descriptor < 0) {
+    return nullptr;
+  }
+
+  struct stat file_stat;
+  if (fstat(descriptor, &file_stat) < 0) {
+    close(descriptor);
+    return nullptr;
+  }
+
+  return std::make_shared<const http::BodyFile>(descriptor, file_stat.st_size);
+}
+
+void SegmentStore::Clear() {
+  for (uint64_t number = first_stored_number_; number < next_number_; ++number) {
+    unlink(BuildPath(number).c_str());
+  }
+  first_stored_number_ = 0;
+  next_number_ = 0;
+}
+
+std::string SegmentStore::BuildPath(const uint64_t media_sequence_number) const {
+  return directory_ + "/chunk" + std::to_string(media_sequence_number) + ".ts";
+}
+
+} // namespace hls
@@ -0,0 +1,97 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <memory>
+
+#include "http/body_file.h"
+#include "types/mpeg2ts_chunk.h"
+
+namespace hls {
+
+/**
+ * @brief Stores MPEG2-TS chunks as files in directory (tmpfs or disk-backed)
+ * @details Only the last segment_count chunks are kept, older ones are removed.
+ * If chunk numbers aren't consecutive (packager is recreated), all stored
+ * chunks are removed.
+ * Files are published atomically, so readers never see partially written chunk
+ */
+class SegmentStore {
+ public:
+  /**
+   * @param directory Directory to store chunks in. Created if it doesn't exist
+   * @param segment_count Number of the most recent chunks to keep
+   */
+  SegmentStore(std::string directory, std::size_t segment_count);
+
+  /**
+   * @brief Remove all stored chunks and directory, if it's empty
+   */
+  ~SegmentStore();
+
+  SegmentStore(const SegmentStore &) = delete;
+  SegmentStore &operator=(const SegmentStore &) = delete;
+
+  /**
+   * @brief Write chunk to file and remove outdated one
+   * @throw std::runtime_error if can't write chunk
+   *
+   * @param chunk Chunk to store
+   */
+  void Store(const types::Mpeg2TsChunk &chunk);
+
+  /**
+   * @brief Open stored chunk
+   *
+   * @param media_sequence_number Number of chunk to open
+   * @return Opened file with chunk data
+   * @return nullptr if there is no such chunk
+   */
+  [[nodiscard]] std::shared_ptr<const http::BodyFile> Open(
+      uint64_t media_sequence_number) const;
+
+  /**
+   * @brief Remove all stored chunks and start a new window
+   */
+  void Clear();
+
+ private:
+  const std::string directory_; //!< Directory with chunk files
+  const std::size_t segment_count_; //!< Number of chunks to keep
+  uint64_t first_stored_number_; //!< Number of the oldest stored chunk
+  uint64_t next_number_; //!< Number of chunk, that will be stored next
+
+  /**
+   * @brief Build path to the chunk file
+   *
+   * @param media_sequence_number Number of chunk
+   * @return Path to the chunk file
+   */
+  [[nodiscard]] std::string BuildPath(uint64_t media_sequence_number) const;
+};
+
+} // namespace hls
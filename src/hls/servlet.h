@@ -24,14 +24,11 @@ SOFTWARE.
 
 #pragma once
 
-extern "C" {
-#include <libavformat/avformat.h>
-}
-
-#include <iostream>
 #include <algorithm>
+#include <cmath>
 #include <regex>
 #include <sstream>
+#include <stdexcept>
 #include <mutex>
 
 #include "servlet.h"
@@ -39,6 +36,9 @@ extern "C" {
 #include "http/response.h"
 #include "observer.h"
 #include "types/mpeg2ts_chunk.h"
+#include "segment_store.h"
+#include "logging/logger.h"
+#include "metrics/registry.h"
 
 namespace hls {
 
@@ -49,16 +49,31 @@ const http::Response NotFoundResponse = {404, "Not Found"};
 
 class Servlet : public ::Servlet<http::Request, http::Response>,
                 public Observer<types::Mpeg2TsChunk> {
+  using ChunkPtr = Observer<types::Mpeg2TsChunk>::DataPtr;
+
  public:
   /**
    * @param chunk_count Number of chunk to store in memory
-   * @param chunk_duration Max duration of one chunk in seconds
+   * @param chunk_duration Expected max duration of one chunk in seconds
+   * @param segment_store_ptr Store to keep chunks data in. If nullptr, data is
+   * kept in memory
    */
-  Servlet(int chunk_count, float chunk_duration):
-  chunks_(chunk_count),
-  cached_chunks_(chunk_count),
+  Servlet(int chunk_count, float chunk_duration,
+          std::shared_ptr<SegmentStore> segment_store_ptr = nullptr):
+  empty_chunk_ptr_(std::make_shared<const types::Mpeg2TsChunk>()),
+  chunks_(chunk_count, empty_chunk_ptr_),
+  cached_chunks_(chunk_count, empty_chunk_ptr_),
   chunk_duration_(chunk_duration),
-  chunks_mutex_() {
+  target_duration_(GetTargetDuration(chunk_duration)),
+  segment_store_ptr_(std::move(segment_store_ptr)),
+  store_errors_counter_(metrics::Registry::GetInstance().GetCounter(
+      "hls_store_errors_total", "Number of chunks dropped because they "
+      "couldn't be stored")),
+  chunks_mutex_(),
+  playlist_ptr_(),
+  publish_latency_(metrics::GetStageLatency("publish")),
+  end_to_end_latency_(metrics::GetStageLatency("end_to_end")) {
+    playlist_ptr_ = BuildPlaylist();
   }
 
   [[nodiscard]] http::Response Handle(const http::Request &request) override {
@@ -70,35 +85,100 @@ class Servlet : public ::Servlet<http::Request, http::Response>,
   }
 
   /**
-   * @param data MPEG2-TS data represented in bytes
+   * @param chunk_ptr MPEG2-TS chunk. Kept without copying if there is no store.
+   * Dropped if it can't be stored
    */
-  void Receive(const types::Mpeg2TsChunk &chunk) override {
+  void Receive(ChunkPtr chunk_ptr) override {
+    metrics::ScopedTimer timer(publish_latency_);
+    const types::Timestamp ingest_time = chunk_ptr->ingest_time;
+    const uint64_t media_sequence_number = chunk_ptr->media_sequence_number;
+    if (segment_store_ptr_) {
+      // Error must not stop the packager, so only this chunk is lost
+      try {
+        segment_store_ptr_->Store(*chunk_ptr);
+      } catch (const std::runtime_error &ex) {
+        store_errors_counter_.Add();
+        LOG(kError) << "HLS: Chunk " << media_sequence_number
+                    << " is dropped: " << ex.what();
+        return;
+      }
+
+      // Only chunk info is kept in memory
+      types::Mpeg2TsChunk chunk_info;
+      chunk_info.media_sequence_number = media_sequence_number;
+      chunk_info.duration = chunk_ptr->duration;
+      chunk_ptr = std::make_shared<const types::Mpeg2TsChunk>(
+          std::move(chunk_info));
+    }
+
     std::lock_guard guard(chunks_mutex_);
-    std::cout << "HLS: Received " << chunk.media_sequence_number
-              << " chunk" << std::endl;
+    LOG(kDebug) << "HLS: Received " << media_sequence_number << " chunk";
+    target_duration_ = std::max(target_duration_,
+                                GetTargetDuration(chunk_ptr->duration));
     AppendNewChunk(cached_chunks_, chunks_.at(0));
-    AppendNewChunk(chunks_, chunk);
+    AppendNewChunk(chunks_, std::move(chunk_ptr));
+    playlist_ptr_ = BuildPlaylist();
+    end_to_end_latency_.RecordDuration(types::Clock::now() - ingest_time);
 
-    if (chunk.media_sequence_number == chunks_.size() - 1) {
-      std::cout << "HLS: Ready" << std::endl;
+    if ((chunks_.front() != empty_chunk_ptr_) &&
+        (cached_chunks_.back() == empty_chunk_ptr_)) {
+      LOG(kInfo) << "HLS: Ready";
     }
   }
 
+  /**
+   * @brief Forget all chunks and remove them from store
+   * @details Called when ingest is stopped, so chunks of the stopped run
+   * aren't served as live later. Must not be called concurrently with Receive()
+   */
+  void Clear() {
+    std::lock_guard guard(chunks_mutex_);
+    std::fill(chunks_.begin(), chunks_.end(), empty_chunk_ptr_);
+    std::fill(cached_chunks_.begin(), cached_chunks_.end(), empty_chunk_ptr_);
+    target_duration_ = GetTargetDuration(chunk_duration_);
+    if (segment_store_ptr_) {
+      segment_store_ptr_->Clear();
+    }
+    playlist_ptr_ = BuildPlaylist();
+    LOG(kInfo) << "HLS: Chunks are cleared";
+  }
+
  private:
-  std::vector<types::Mpeg2TsChunk> chunks_;
-  std::vector<types::Mpeg2TsChunk> cached_chunks_;
+  //! Fills slots of chunks, that aren't received yet
+  const ChunkPtr empty_chunk_ptr_;
+  std::vector<ChunkPtr> chunks_;
+  std::vector<ChunkPtr> cached_chunks_;
   const float chunk_duration_;
-  mutable std::mutex chunks_mutex_;
+  //! Playlist target duration in seconds. Covers the longest received chunk
+  //! and only grows, as clients expect it to be constant
+  int target_duration_;
+  //! Store with chunks data. If nullptr, data is stored in chunks_
+  const std::shared_ptr<SegmentStore> segment_store_ptr_;
+  metrics::Counter &store_errors_counter_;
+  mutable std::mutex chunks_mutex_; //!< Mutex for chunks and playlist
+  //! Playlist is built once per chunk and shared by all requests
+  std::shared_ptr<const std::string> playlist_ptr_;
+  metrics::Histogram &publish_latency_;
+  //! Time from frame ingest to its chunk being available for clients
+  metrics::Histogram &end_to_end_latency_;
 
   [[nodiscard]] http::Response HandleGet(const http::Request &request) const {
     http::Response response;
 
     if (request.url == kPlaylistPath) {
+      std::shared_ptr<const std::string> playlist_ptr;
+      {
+        std::lock_guard guard(chunks_mutex_);
+        playlist_ptr = playlist_ptr_;
+      }
       response.code = 200;
       response.description = "OK";
-      response.body = GetPlaylistContent();
+      response.body_buffer = types::SharedBuffer(
+          playlist_ptr,
+          reinterpret_cast<const types::Byte *>(playlist_ptr->data()),
+          playlist_ptr->size());
       response.headers[kContentLengthHeaderName] =
-          std::to_string(response.body.size());
+          std::to_string(playlist_ptr->size());
     } else if (std::regex_match(request.url, kChunkPathRegex)) {
       return GetChunk(request);
     } else {
@@ -110,64 +190,110 @@ class Servlet : public ::Servlet<http::Request, http::Response>,
 
   [[nodiscard]] http::Response GetChunk(const http::Request &request) const {
     const uint64_t chunk_number = ExtractChunkNumberFromUrl(request.url);
-    const std::vector<types::Mpeg2TsChunk> *chunks_ptr = &cached_chunks_;
-    if (chunk_number >= (chunks_.back().media_sequence_number + 1) - chunks_.size()) {
-      chunks_ptr = &chunks_;
+    if (segment_store_ptr_) {
+      return GetStoredChunk(chunk_number);
     }
 
-    std::lock_guard guard(chunks_mutex_);
-    auto it = FindChunk(*chunks_ptr, chunk_number);
-    if (it == chunks_ptr->end()) {
+    ChunkPtr chunk_ptr;
+    {
+      std::lock_guard guard(chunks_mutex_);
+      const std::vector<ChunkPtr> *chunks_ptr = &cached_chunks_;
+      if (chunk_number >= (chunks_.back()->media_sequence_number + 1) -
+                          chunks_.size()) {
+        chunks_ptr = &chunks_;
+      }
+
+      auto it = FindChunk(*chunks_ptr, chunk_number);
+      if (it == chunks_ptr->end()) {
+        return NotFoundResponse;
+      }
+      chunk_ptr = *it;
+    }
+
+    // Chunk is sent from the shared data without copying
+    http::Response response;
+    response.code = 200;
+    response.description = "OK";
+    response.body_buffer = types::SharedBuffer(chunk_ptr,
+                                               chunk_ptr->data.data(),
+                                               chunk_ptr->data.size());
+    response.headers[kContentLengthHeaderName] =
+        std::to_string(chunk_ptr->data.size());
+
+    return response;
+  }
+
+  [[nodiscard]] http::Response GetStoredChunk(
+      const uint64_t chunk_number) const {
+    auto body_file_ptr = segment_store_ptr_->Open(chunk_number);
+    if (!body_file_ptr) {
       return NotFoundResponse;
     }
 
     http::Response response;
     response.code = 200;
     response.description = "OK";
-    response.body.insert(response.body.begin(), it->data.data(),
-                         it->data.data() + it->data.size());
     response.headers[kContentLengthHeaderName] =
-        std::to_string(response.body.size());
+        std::to_string(body_file_ptr->GetSize());
+    response.body_file_ptr = std::move(body_file_ptr);
 
     return response;
   }
 
-  [[nodiscard]] std::string GetPlaylistContent() const {
+  /**
+   * @details chunks_mutex_ must be locked
+   */
+  [[nodiscard]] std::shared_ptr<const std::string> BuildPlaylist() const {
     using namespace std::string_literals;
 
+    // Chunks are received in order, so empty slots are at the front
+    auto first_it = std::find_if(chunks_.begin(), chunks_.end(),
+                                 [this] (const ChunkPtr &chunk_ptr) {
+                                   return chunk_ptr != empty_chunk_ptr_;
+                                 });
+    const uint64_t media_sequence_number =
+        (first_it != chunks_.end()) ? (*first_it)->media_sequence_number : 0;
     std::ostringstream oss(
         "#EXTM3U\n"
         "#EXT-X-VERSION:3\n"
-        "#EXT-X-TARGETDURATION:"s + std::to_string(chunk_duration_) + "\n"
-        "#EXT-X-MEDIA-SEQUENCE:"s +
-            std::to_string(chunks_.front().media_sequence_number) + "\n",
+        "#EXT-X-TARGETDURATION:"s + std::to_string(target_duration_) + "\n"
+        "#EXT-X-MEDIA-SEQUENCE:"s + std::to_string(media_sequence_number) +
+            "\n",
         std::ios::ate);
 
-    {
-      std::lock_guard guard(chunks_mutex_);
-      for (const auto &chunk : chunks_) {
-        oss << "#EXTINF:" << chunk.duration << ",\n"
-            << "/chunk" << chunk.media_sequence_number << ".ts\n";
-      }
+    for (auto it = first_it; it != chunks_.end(); ++it) {
+      const ChunkPtr &chunk_ptr = *it;
+      oss << "#EXTINF:" << chunk_ptr->duration << ",\n"
+          << "/chunk" << chunk_ptr->media_sequence_number << ".ts\n";
     }
 
-    return oss.str();
+    return std::make_shared<const std::string>(oss.str());
+  }
+
+  /**
+   * @param duration Chunk duration in seconds
+   * @return Target duration, that isn't less than chunk duration
+   */
+  [[nodiscard]] static int GetTargetDuration(const float duration) {
+    return std::max(1, static_cast<int>(std::ceil(duration)));
   }
 
-  static void AppendNewChunk(std::vector<types::Mpeg2TsChunk> &chunks,
-                             const types::Mpeg2TsChunk &chunk) {
+  static void AppendNewChunk(std::vector<ChunkPtr> &chunks,
+                             ChunkPtr chunk_ptr) {
     for (std::size_t i = 0; i < chunks.size() - 1; ++i) {
       chunks[i] = std::move(chunks[i + 1]);
     }
-    chunks.back() = chunk;
+    chunks.back() = std::move(chunk_ptr);
   }
 
-  static typename std::vector<types::Mpeg2TsChunk>::const_iterator
-  FindChunk(const std::vector<types::Mpeg2TsChunk> &chunks,
-            const uint64_t chunk_number) {
+  [[nodiscard]] typename std::vector<ChunkPtr>::const_iterator
+  FindChunk(const std::vector<ChunkPtr> &chunks,
+            const uint64_t chunk_number) const {
     return std::find_if(chunks.begin(), chunks.end(),
-                        [chunk_number] (const types::Mpeg2TsChunk &chunk) {
-                          return chunk.media_sequence_number == chunk_number;
+                        [this, chunk_number] (const ChunkPtr &chunk_ptr) {
+                          return (chunk_ptr != empty_chunk_ptr_) &&
+                                 (chunk_ptr->media_sequence_number ==
+                                  chunk_number);
                         });
   }
 
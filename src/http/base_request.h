@@ -24,6 +24,7 @@ SOFTWARE.
 
 #pragma once
 
+#include <algorithm>
 #include <unordered_map>
 
 #include "sock/socket.h"
@@ -102,6 +103,8 @@ struct BaseRequest {
   float version;
   Headers headers;
   std::string body;
+  //! Ip address of the client. Isn't a part of request, set by receiver
+  std::string remote_address;
 };
 
 /**
@@ -150,7 +153,7 @@ template <typename Method, const char protocol_name[]>
 std::ostream &operator<<(std::ostream &os, const BaseRequest<Method, protocol_name> &request) {
   os << MethodToString(request.method) << " " << request.url << " " << protocol_name << "/"
      << std::fixed << std::setprecision(1) << request.version << "\r\n"
-     << request.headers << "\r\n\r\n"
+     << request.headers << "\r\n"
      << request.body;
 
   return os;
@@ -177,10 +180,13 @@ sock::Socket &operator>>(sock::Socket &socket,
 
   request = ParseRequest<Method, protocol_name>(request_str);
 
-  const int content_length = ExtractContentLength(request.headers);
-  const int diff = content_length - request.body.size();
-  if (diff > 0) {
-    request.body += socket.Read(diff);
+  // Body can come in several segments
+  const std::size_t content_length =
+      std::max(ExtractContentLength(request.headers), 0);
+  while (request.body.size() < content_length) {
+    constexpr std::size_t kMaxReadSize = 64 * 1024;
+    request.body += socket.Read(std::min(content_length - request.body.size(),
+                                         kMaxReadSize));
   }
 
   return socket;
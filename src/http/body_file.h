@@ -0,0 +1,71 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+namespace http {
+
+/**
+ * @brief Opened file, which content is used as response body
+ * @details Content isn't read into memory. It's sent with sendfile(2) directly
+ * from page cache to the client socket
+ */
+class BodyFile {
+ public:
+  /**
+   * @param descriptor Opened file descriptor. BodyFile takes ownership of it
+   * @param size Size of file content in bytes
+   */
+  BodyFile(int descriptor, std::size_t size);
+
+  /**
+   * @brief Closes file descriptor
+   */
+  ~BodyFile();
+
+  BodyFile(const BodyFile &) = delete;
+  BodyFile &operator=(const BodyFile &) = delete;
+
+  /**
+   * @brief Get file descriptor
+   *
+   * @return descriptor
+   */
+  [[nodiscard]] int GetDescriptor() const;
+
+  /**
+   * @brief Get size of file content
+   *
+   * @return Size in bytes
+   */
+  [[nodiscard]] std::size_t GetSize() const;
+
+ private:
+  int descriptor_; //!< File descriptor
+  std::size_t size_; //!< Size of file content
+};
+
+} // namespace http
@@ -0,0 +1,50 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "sock/socket.h"
+
+namespace http {
+
+/**
+ * @brief Endless response body, which is sent part by part after headers
+ * @details Used for streaming to clients. Connection is closed after the
+ * stream is finished
+ */
+class BodyStream {
+ public:
+  virtual ~BodyStream() = default;
+
+  /**
+   * @brief Wait for the next part of body and send it
+   * @throw sock::SendError if client has disconnected
+   *
+   * @param socket Client socket
+   * @return False, if stream is finished
+   */
+  virtual bool SendNext(sock::Socket &socket) = 0;
+};
+
+} // namespace http
@@ -24,27 +24,22 @@ SOFTWARE.
 
 #include "response.h"
 
+#include <algorithm>
 #include <utility>
 #include <iomanip>
 
-namespace {
+namespace http {
 
-/**
- * @brief Parse RTSP response from string
- * @throws rtsp::ParseError if some error occurred during parsing
- *
- * @param request_str String with response
- * @return Extracted response
- */
-http::Response ParseResponse(std::string &&response_str) {
-  http::Response response;
+Response ParseResponse(const std::string &response_str) {
+  Response response;
 
   std::istringstream iss(response_str);
 
-  std::string protocol;
-  std::getline(iss, protocol, '/');
-  if (protocol != "RTSP") {
-    throw http::ParseError("Expected RTSP protocol, but got " + protocol);
+  std::getline(iss, response.protocol_name, '/');
+  if ((response.protocol_name != "HTTP") &&
+      (response.protocol_name != "RTSP")) {
+    throw ParseError("Expected HTTP or RTSP protocol, but got " +
+                     response.protocol_name);
   }
 
   iss >> response.version;
@@ -55,7 +50,7 @@ http::Response ParseResponse(std::string &&response_str) {
   iss.ignore(2, '\n');
   std::string line;
   while (std::getline(iss, line) && line != "\r") {
-    response.headers.insert(http::ParseHeader(line));
+    response.headers.insert(ParseHeader(line));
   }
 
   response.body = iss.str().substr(iss.tellg());
@@ -63,17 +58,16 @@ http::Response ParseResponse(std::string &&response_str) {
   return response;
 }
 
-} // namespace
-
-namespace http {
-
 Response::Response() :
 protocol_name("HTTP"),
 version(1.0),
 code(0),
 description(),
 headers(),
-body() {
+body(),
+body_buffer(),
+body_file_ptr(),
+body_stream_ptr() {
 }
 
 Response::Response(int code, std::string description,
@@ -83,7 +77,10 @@ version(1.0),
 code(code),
 description(std::move(description)),
 headers(std::move(headers)),
-body(std::move(body)) {
+body(std::move(body)),
+body_buffer(),
+body_file_ptr(),
+body_stream_ptr() {
 }
 
 std::ostream &operator<<(std::ostream &os, const Response &response) {
@@ -101,12 +98,15 @@ sock::Socket &operator>>(sock::Socket &socket, Response &response) {
     response_str += socket.Read(kBuffSize);
   }
 
-  response = ParseResponse(std::move(response_str));
+  response = ParseResponse(response_str);
 
-  const int content_length = ExtractContentLength(response.headers);
-  const int diff = content_length - response.body.size();
-  if (diff > 0) {
-    response.body += socket.Read(diff);
+  // Body can come in several segments
+  const std::size_t content_length =
+      std::max(ExtractContentLength(response.headers), 0);
+  while (response.body.size() < content_length) {
+    constexpr std::size_t kMaxReadSize = 64 * 1024;
+    response.body += socket.Read(std::min(content_length - response.body.size(),
+                                          kMaxReadSize));
   }
 
   return socket;
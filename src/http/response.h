@@ -24,7 +24,12 @@ SOFTWARE.
 
 #pragma once
 
+#include <memory>
+
 #include "base_request.h"
+#include "body_file.h"
+#include "body_stream.h"
+#include "types/shared_buffer.h"
 
 namespace http {
 
@@ -47,8 +52,23 @@ struct Response {
   std::string description;
   Headers headers;
   std::string body;
+  //! Data to send after body. Used to avoid copying data kept elsewhere
+  types::SharedBuffer body_buffer;
+  //! File to send after body. Used to avoid copying big files to user space
+  std::shared_ptr<const BodyFile> body_file_ptr;
+  //! Stream to send after body. Connection is closed when it's finished
+  std::shared_ptr<BodyStream> body_stream_ptr;
 };
 
+/**
+ * @brief Parse HTTP or RTSP response from string
+ * @throw ParseError if some error occurred during parsing
+ *
+ * @param response_str String with status line, headers and body
+ * @return Extracted response
+ */
+Response ParseResponse(const std::string &response_str);
+
 std::ostream &operator<<(std::ostream &os, const Response &response);
 
 sock::Socket &operator>>(sock::Socket &socket, Response &response);
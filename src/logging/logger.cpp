@@ -0,0 +1,259 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "logger.h"
+
+#include <ctime>
+
+#include <array>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+/**
+ * @brief Get printable name of level
+ *
+ * @param level Log level
+ * @return Level name
+ */
+const char *LevelToString(const logging::Level level) {
+  switch (level) {
+    case logging::Level::kDebug:
+      return "DEBUG";
+    case logging::Level::kInfo:
+      return "INFO";
+    case logging::Level::kWarning:
+      return "WARNING";
+    case logging::Level::kError:
+      return "ERROR";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+} // namespace
+
+namespace logging {
+
+/**
+ * @brief Single-producer single-consumer lock-free ring buffer of messages
+ */
+class Logger::RingBuffer {
+ public:
+  /**
+   * @brief Message with its metadata
+   */
+  struct Entry {
+    Level level;
+    std::chrono::system_clock::time_point time;
+    std::string message;
+  };
+
+  RingBuffer() :
+  entries_(),
+  head_(0),
+  tail_(0) {
+  }
+
+  /**
+   * @brief Push entry. Called only by owner thread
+   *
+   * @param entry Entry to push
+   * @return false if buffer is full
+   */
+  bool TryPush(Entry &&entry) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == entries_.size()) {
+      return false;
+    }
+
+    entries_[head % entries_.size()] = std::move(entry);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Pop all entries and write them to the stream. Called only by flusher
+   *
+   * @param os Stream to write to
+   * @return Number of popped entries
+   */
+  std::size_t PopAll(std::ostream &os) {
+    const std::size_t head = head_.load(std::memory_order_acquire);
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    const std::size_t count = head - tail;
+
+    for (; tail != head; ++tail) {
+      Entry &entry = entries_[tail % entries_.size()];
+      const std::time_t time = std::chrono::system_clock::to_time_t(entry.time);
+      const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+          entry.time.time_since_epoch()).count() % 1000;
+      std::tm tm;
+      localtime_r(&time, &tm);
+      os << std::put_time(&tm, "%F %T") << '.' << std::setfill('0')
+         << std::setw(3) << ms << std::setfill(' ') << " ["
+         << LevelToString(entry.level) << "] " << entry.message << '\n';
+      entry.message = std::string();
+      tail_.store(tail + 1, std::memory_order_release);
+    }
+
+    return count;
+  }
+
+  /**
+   * @brief Get number of entries in buffer. Can be called by any thread
+   *
+   * @return Number of entries
+   */
+  [[nodiscard]] std::size_t GetSize() const {
+    // Tail is read first, so it can't overtake head
+    const std::size_t tail = tail_.load(std::memory_order_acquire);
+    return head_.load(std::memory_order_acquire) - tail;
+  }
+
+ private:
+  std::array<Entry, kRingBufferCapacity> entries_; //!< Ring of entries
+  std::atomic<std::size_t> head_; //!< Index of the next entry to push
+  std::atomic<std::size_t> tail_; //!< Index of the next entry to pop
+};
+
+Level ParseLevel(const std::string &level_str) {
+  if (level_str == "debug") {
+    return Level::kDebug;
+  } else if (level_str == "info") {
+    return Level::kInfo;
+  } else if (level_str == "warning") {
+    return Level::kWarning;
+  } else if (level_str == "error") {
+    return Level::kError;
+  }
+
+  throw std::invalid_argument("Unknown log level " + level_str);
+}
+
+Logger &Logger::GetInstance() {
+  static Logger logger;
+  return logger;
+}
+
+Logger::Logger() :
+level_(Level::kInfo),
+dropped_count_(0),
+buffers_(),
+buffers_mutex_(),
+stop_(false),
+flusher_() {
+  flusher_ = std::thread(&Logger::FlusherRoutine, this);
+}
+
+Logger::~Logger() {
+  stop_ = true;
+  flusher_.join();
+  Flush();
+}
+
+void Logger::SetLevel(const Level level) {
+  level_.store(level, std::memory_order_relaxed);
+}
+
+void Logger::Write(const Level level, std::string message) {
+  RingBuffer::Entry entry{level, std::chrono::system_clock::now(),
+                          std::move(message)};
+  if (!GetThreadBuffer().TryPush(std::move(entry))) {
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+uint64_t Logger::GetDroppedCount() const {
+  return dropped_count_.load(std::memory_order_relaxed);
+}
+
+std::size_t Logger::GetQueuedCount() const {
+  std::lock_guard guard(buffers_mutex_);
+  std::size_t count = 0;
+  for (const auto &buffer_ptr : buffers_) {
+    count += buffer_ptr->GetSize();
+  }
+
+  return count;
+}
+
+Logger::RingBuffer &Logger::GetThreadBuffer() {
+  thread_local std::shared_ptr<RingBuffer> buffer_ptr;
+  if (!buffer_ptr) {
+    buffer_ptr = std::make_shared<RingBuffer>();
+    std::lock_guard guard(buffers_mutex_);
+    buffers_.push_back(buffer_ptr);
+  }
+
+  return *buffer_ptr;
+}
+
+void Logger::Flush() {
+  std::ostringstream oss;
+  std::size_t count = 0;
+  {
+    std::lock_guard guard(buffers_mutex_);
+    for (auto it = buffers_.begin(); it != buffers_.end();) {
+      // Owner thread has finished, if it doesn't hold the buffer. It's checked
+      // before draining, so records written right before exit aren't lost
+      const bool is_released = (it->use_count() == 1);
+      count += (*it)->PopAll(oss);
+
+      if (is_released) {
+        it = buffers_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  if (count > 0) {
+    std::cout << oss.str() << std::flush;
+  }
+}
+
+void Logger::FlusherRoutine() {
+  while (!stop_) {
+    std::this_thread::sleep_for(kFlushPeriod);
+    Flush();
+  }
+}
+
+Line::Line(const Level level) :
+level_(level),
+stream_() {
+}
+
+Line::~Line() {
+  Logger::GetInstance().Write(level_, stream_.str());
+}
+
+Line &Line::operator<<(std::ostream &(*)(std::ostream &)) {
+  return *this;
+}
+
+} // namespace logging
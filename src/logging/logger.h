@@ -0,0 +1,206 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace logging {
+
+/**
+ * @brief Log levels in order of increasing severity
+ */
+enum class Level {
+  kDebug,
+  kInfo,
+  kWarning,
+  kError
+};
+
+/**
+ * @brief Parse level from string
+ * @throw std::invalid_argument if string isn't one of "debug", "info",
+ * "warning" or "error"
+ *
+ * @param level_str String with level
+ * @return Parsed level
+ */
+Level ParseLevel(const std::string &level_str);
+
+/**
+ * @brief Asynchronous logger
+ * @details Every thread writes messages to its own lock-free ring buffer.
+ * Background thread drains all buffers and writes messages to stdout. If
+ * buffer is full, message is dropped instead of blocking the caller.
+ * Use LOG() macros instead of calling Write() directly, so messages with
+ * disabled level aren't even formatted
+ */
+class Logger {
+ public:
+  /**
+   * @brief Get global logger
+   *
+   * @return Logger
+   */
+  static Logger &GetInstance();
+
+  /**
+   * @brief Stops background thread and writes all remaining messages
+   */
+  ~Logger();
+
+  Logger(const Logger &) = delete;
+  Logger &operator=(const Logger &) = delete;
+
+  /**
+   * @brief Set min level of messages to be written
+   *
+   * @param level Min level
+   */
+  void SetLevel(Level level);
+
+  /**
+   * @brief Check if messages with given level are written
+   *
+   * @param level Message level
+   * @return true if messages are written
+   */
+  [[nodiscard]] bool IsEnabled(Level level) const {
+    return level >= level_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Put message to the buffer of calling thread
+   *
+   * @param level Message level
+   * @param message Message without trailing new line
+   */
+  void Write(Level level, std::string message);
+
+  /**
+   * @brief Get number of messages dropped because of full buffers
+   *
+   * @return Number of dropped messages
+   */
+  [[nodiscard]] uint64_t GetDroppedCount() const;
+
+  /**
+   * @brief Get number of messages waiting in buffers to be written
+   *
+   * @return Number of queued messages
+   */
+  [[nodiscard]] std::size_t GetQueuedCount() const;
+
+ private:
+  class RingBuffer;
+
+  //! Capacity of ring buffer of every thread
+  static constexpr std::size_t kRingBufferCapacity = 1024;
+  //! Period of draining buffers by background thread
+  static constexpr std::chrono::milliseconds kFlushPeriod{20};
+
+  std::atomic<Level> level_; //!< Min level of written messages
+  std::atomic<uint64_t> dropped_count_; //!< Number of dropped messages
+  //! Buffers of all threads, that have ever written messages
+  std::vector<std::shared_ptr<RingBuffer>> buffers_;
+  mutable std::mutex buffers_mutex_; //!< Mutex for buffers_
+  std::atomic<bool> stop_; //!< True, if flusher_ should stop
+  std::thread flusher_; //!< Thread, that drains buffers
+
+  Logger();
+
+  /**
+   * @brief Get ring buffer of calling thread. Registers it on first call
+   *
+   * @return Ring buffer
+   */
+  RingBuffer &GetThreadBuffer();
+
+  /**
+   * @brief Drain all buffers and write messages to stdout
+   */
+  void Flush();
+
+  /**
+   * @brief Routine of flusher_
+   */
+  void FlusherRoutine();
+};
+
+/**
+ * @brief Single log message. Collects everything printed into it and writes
+ * it to the Logger on destruction
+ */
+class Line {
+ public:
+  explicit Line(Level level);
+
+  ~Line();
+
+  Line(const Line &) = delete;
+  Line &operator=(const Line &) = delete;
+
+  template <typename T>
+  Line &operator<<(const T &value) {
+    stream_ << value;
+    return *this;
+  }
+
+  /**
+   * @brief Output operator for std::endl and etc. Line ends are ignored,
+   * every Line is written as one line
+   */
+  Line &operator<<(std::ostream &(*f)(std::ostream &));
+
+ private:
+  const Level level_; //!< Message level
+  std::ostringstream stream_; //!< Message buffer
+};
+
+} // namespace logging
+
+/**
+ * @brief Log message with given level. Usage: LOG(kInfo) << "message";
+ * @details Message isn't formatted if level is disabled
+ */
+#define LOG(level) \
+  if (!logging::Logger::GetInstance().IsEnabled(logging::Level::level)) {} \
+  else logging::Line(logging::Level::level)
+
+/**
+ * @brief Log only every n-th message from this place. Used on hot paths
+ */
+#define LOG_EVERY_N(level, n) \
+  if (static std::atomic<uint64_t> log_occurrences{0}; \
+      (log_occurrences.fetch_add(1, std::memory_order_relaxed) % (n) != 0) || \
+      !logging::Logger::GetInstance().IsEnabled(logging::Level::level)) {} \
+  else logging::Line(logging::Level::level)
@@ -22,69 +22,225 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <sys/resource.h>
+#include <unistd.h>
+
 #include <csignal>
+#include <cstdlib>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <thread>
+#include <chrono>
 
 #include "port_handler/port_handler.h"
 #include "port_handler/port_handler_manager.h"
-#include "rtsp/client.h"
-#include "converters/mjpeg_to_h264.h"
-#include "converters/mpeg2ts_packager.h"
+#include "pipeline/on_demand_pipeline.h"
+#include "pipeline/demand_servlet.h"
 #include "hls/servlet.h"
+#include "snapshot/snapshot_servlet.h"
+#include "multipart/mjpeg_servlet.h"
+#include "progressive/ts_servlet.h"
+#include "rtsp/server_servlet.h"
+#include "recording/recorder.h"
+#include "metrics/latency_servlet.h"
+#include "metrics/prometheus_servlet.h"
+#include "logging/logger.h"
 
 namespace {
 
 volatile bool stop_flag = false;
 
+const int kDefaultIdleTimeoutSec = 60;
+//! Prefix of default directory for HLS chunks. Should be on tmpfs to avoid
+//! disk I/O
+const char kDefaultHlsSegmentDirectory[] = "/dev/shm/media-server";
+//! Max default number of JPEG decoder threads. Single encoder is the
+//! bottleneck beyond that
+const unsigned int kMaxDefaultDecoderCount = 4;
+
 void SignalHandler(int) {
   stop_flag = true;
 }
 
+/**
+ * @brief Read transcoding options from environment variables
+ *
+ * @return Options
+ */
+converters::MjpegToH264Options ReadTranscodingOptions() {
+  converters::MjpegToH264Options options;
+
+  // JPEG frames are decoded in parallel by this number of threads
+  options.decoder_count = std::clamp(std::thread::hardware_concurrency(), 1U,
+                                     kMaxDefaultDecoderCount);
+  if (const char *decoder_threads =
+          std::getenv("MEDIA_SERVER_DECODER_THREADS")) {
+    options.decoder_count = std::stoul(decoder_threads);
+    if (options.decoder_count == 0) {
+      throw std::invalid_argument("Decoder thread count must be positive");
+    }
+  }
+
+  // Frames of static scene are skipped only if motion threshold is set
+  if (const char *motion_threshold =
+          std::getenv("MEDIA_SERVER_MOTION_THRESHOLD")) {
+    converters::MotionOptions motion_options;
+    motion_options.block_threshold = std::stoi(motion_threshold);
+    if (const char *min_changed_blocks =
+            std::getenv("MEDIA_SERVER_MOTION_MIN_BLOCKS")) {
+      motion_options.min_changed_blocks = std::stoi(min_changed_blocks);
+    }
+    if (const char *static_frame_interval_ms =
+            std::getenv("MEDIA_SERVER_STATIC_FRAME_INTERVAL_MS")) {
+      motion_options.static_frame_interval =
+          std::stoll(static_frame_interval_ms) * 90;
+    }
+    options.motion_options = motion_options;
+  }
+
+  return options;
+}
+
+/**
+ * @brief Read recording options from environment variables
+ *
+ * @return Options
+ * @return std::nullopt if recording is disabled
+ */
+std::optional<recording::RecorderOptions> ReadRecorderOptions() {
+  // Stream is recorded only if directory is set
+  const char *directory = std::getenv("MEDIA_SERVER_RECORDING_DIR");
+  if (!directory) {
+    return std::nullopt;
+  }
+
+  recording::RecorderOptions options;
+  options.directory = directory;
+  if (const char *file_duration_sec =
+          std::getenv("MEDIA_SERVER_RECORDING_FILE_DURATION_SEC")) {
+    options.file_duration = std::chrono::seconds(std::stoi(file_duration_sec));
+  }
+  if (const char *direct_io = std::getenv("MEDIA_SERVER_RECORDING_DIRECT_IO")) {
+    options.direct_io = (std::string(direct_io) == "1");
+  }
+
+  return options;
+}
+
 class MediaServer {
  public:
-  explicit MediaServer(const std::string &rtsp_stream_url):
-  rtsp_client_(rtsp_stream_url),
-  mjpeg_to_h264_ptr_(),
-  mpeg2ts_packager_ptr_(),
-  port_handler_manager_() {
-    const int width = rtsp_client_.GetWidth();
-    const int height = rtsp_client_.GetHeight();
-    const int fps = rtsp_client_.GetFps();
-
-    mjpeg_to_h264_ptr_ = std::make_shared<converters::MjpegToH264>
-        (width, height, fps);
-    mpeg2ts_packager_ptr_ = std::make_shared<converters::Mpeg2TsPackager>
-        (width, height, fps, kHlsChunkDurationSec);
-    rtsp_client_.AddObserver(mjpeg_to_h264_ptr_);
-    mjpeg_to_h264_ptr_->AddObserver(mpeg2ts_packager_ptr_);
-
+  /**
+   * @param rtsp_stream_url Url of the source RTSP stream
+   * @param idle_timeout Time without clients after which transcoding is stopped
+   * @param transcoding_options Options of MJPEG to H.264 transcoding
+   * @param recorder_options Options of recording. std::nullopt to disable it
+   * @param segment_directory Directory for HLS chunks. Its files are removed
+   */
+  MediaServer(const std::string &rtsp_stream_url,
+              const std::string &segment_directory,
+              const std::chrono::milliseconds idle_timeout,
+              const converters::MjpegToH264Options &transcoding_options,
+              const std::optional<recording::RecorderOptions>
+                  &recorder_options):
+  pipeline_(rtsp_stream_url, kHlsChunkDurationSec, idle_timeout,
+            transcoding_options),
+  acceptor_count_(std::max(std::thread::hardware_concurrency(), 1U)),
+  port_handler_manager_(acceptor_count_),
+  segment_directory_(segment_directory),
+  rtsp_servlet_ptr_(),
+  recorder_ptr_() {
+    if (recorder_options) {
+      recorder_ptr_ = std::make_shared<recording::Recorder>(*recorder_options);
+      pipeline_.AddObserver(recorder_ptr_);
+    }
+    RegisterLoggerMetrics();
+    RegisterProcessMetrics();
     port_handler_manager_.RegisterPortHandler(BuildHlsPortHandler());
+    port_handler_manager_.RegisterPortHandler(BuildRtspPortHandler());
   }
 
   void Start() {
-    std::cout << "Media server started" << std::endl;
+    LOG(kInfo) << "Media server started";
 
     const int kAcceptTimeoutInMilliseconds = 2000;
+    port_handler_manager_.StartAcceptors(kAcceptTimeoutInMilliseconds);
     while (!stop_flag) {
-      try {
-        port_handler_manager_.TryAcceptClients(kAcceptTimeoutInMilliseconds);
-      } catch (std::runtime_error &ex) {
-        std::cout << "Warning: " << ex.what() << std::endl;
+      // Recording runs without clients, and UDP sessions send requests only
+      // as rare keep-alives
+      if (recorder_ptr_ || rtsp_servlet_ptr_->HasPlayingSessions()) {
+        pipeline_.Touch();
       }
+      pipeline_.Update();
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
+    port_handler_manager_.StopAcceptors();
   }
 
  private:
   static constexpr int kHlsPort = 8080;
+  static constexpr int kHlsBacklog = 1024;
+  static constexpr std::size_t kHlsMaxConnections = 512;
   static constexpr int kHlsChunkCount = 3;
   static constexpr float kHlsChunkDurationSec = 8.0;
+  //! Number of last JPEG frames available by sequence number
+  static constexpr std::size_t kSnapshotHistorySize = 30;
+  //! Older frame isn't served as the latest one
+  static constexpr std::chrono::seconds kSnapshotMaxAge{5};
+  //! MJPEG stream is finished if there are no frames for that time
+  static constexpr std::chrono::seconds kMjpegFrameTimeout{15};
+  //! Max number of frames queued for one MPEG2-TS stream viewer. Must be
+  //! greater than GOP, so cached GOP fits in it
+  static constexpr std::size_t kTsStreamQueueSize = 90;
+  static constexpr std::size_t kTsStreamMaxGopSize = 60;
+  static constexpr std::chrono::seconds kTsStreamFragmentTimeout{15};
+  static constexpr int kRtspPort = 8555;
+  static constexpr std::size_t kRtspMaxConnections = 256;
 
-  rtsp::Client rtsp_client_;
-  std::shared_ptr<converters::MjpegToH264> mjpeg_to_h264_ptr_;
-  std::shared_ptr<converters::Mpeg2TsPackager> mpeg2ts_packager_ptr_;
+  //! Ingest and transcoding, that runs only while there are HLS clients
+  pipeline::OnDemandPipeline pipeline_;
+  //! Number of acceptor threads and listening sockets per port
+  const unsigned int acceptor_count_;
   port_handler::PortHandlerManager port_handler_manager_;
+  const std::string segment_directory_; //!< Directory for HLS chunks
+  //! Re-streams encoded video to RTSP clients
+  std::shared_ptr<rtsp::ServerServlet> rtsp_servlet_ptr_;
+  //! Writes HLS chunks to disk. nullptr if recording is disabled
+  std::shared_ptr<recording::Recorder> recorder_ptr_;
+
+  /**
+   * @brief Export logger queue state as metrics
+   */
+  static void RegisterLoggerMetrics() {
+    metrics::Registry &registry = metrics::Registry::GetInstance();
+    registry.AddCallback("log_queue_depth", "Number of messages waiting to be "
+                         "written by logger", metrics::Type::kGauge, [] {
+      return logging::Logger::GetInstance().GetQueuedCount();
+    });
+    registry.AddCallback("log_messages_dropped_total", "Number of messages "
+                         "dropped because of full logger queue",
+                         metrics::Type::kCounter, [] {
+      return logging::Logger::GetInstance().GetDroppedCount();
+    });
+  }
+
+  /**
+   * @brief Export resource usage of the whole process as metrics
+   */
+  static void RegisterProcessMetrics() {
+    metrics::Registry::GetInstance().AddCallback(
+        "process_cpu_seconds_total", "User and system CPU time spent by "
+        "server", metrics::Type::kCounter, [] {
+      rusage usage{};
+      getrusage(RUSAGE_SELF, &usage);
+      const auto to_seconds = [] (const timeval &time) {
+        return time.tv_sec + time.tv_usec / 1e6;
+      };
+      return to_seconds(usage.ru_utime) + to_seconds(usage.ru_stime);
+    });
+  }
 
   /**
    * @brief Create HLS handler
@@ -92,16 +248,91 @@ class MediaServer {
    * @return Pointer to PortHandlerBase with HLS port handler inside
    */
   std::unique_ptr<port_handler::PortHandlerBase> BuildHlsPortHandler() {
+    port_handler::Options options;
+    options.socket_count = acceptor_count_;
+    options.backlog = kHlsBacklog;
+    options.max_connections = kHlsMaxConnections;
     auto hls_port_handler_ptr = std::make_unique<
-        port_handler::PortHandler<http::Request, http::Response>>(kHlsPort);
+        port_handler::PortHandler<http::Request, http::Response>>(kHlsPort,
+                                                                 options);
+
+    // Store keeps both current and cached chunks
+    auto segment_store_ptr = std::make_shared<hls::SegmentStore>(
+        segment_directory_, 2 * kHlsChunkCount);
+    auto servlet_ptr = std::make_shared<hls::Servlet>(
+        kHlsChunkCount, kHlsChunkDurationSec, segment_store_ptr);
+    pipeline_.AddObserver(servlet_ptr);
+    pipeline_.AddStopCallback([servlet_ptr] { servlet_ptr->Clear(); });
+
+    // Every HLS request keeps the pipeline running
+    auto demand_servlet_ptr = std::make_shared<
+        pipeline::DemandServlet<http::Request, http::Response>>(servlet_ptr,
+                                                                pipeline_);
+    hls_port_handler_ptr->RegisterServlet("/", demand_servlet_ptr);
 
-    auto servlet_ptr = std::make_shared<hls::Servlet>(kHlsChunkCount, kHlsChunkDurationSec);
-    mpeg2ts_packager_ptr_->AddObserver(servlet_ptr);
+    // Snapshots are served from the same RTSP session
+    auto snapshot_servlet_ptr = std::make_shared<snapshot::Servlet>(
+        kSnapshotHistorySize, kSnapshotMaxAge);
+    pipeline_.AddFrameObserver(snapshot_servlet_ptr);
+    auto demand_snapshot_servlet_ptr = std::make_shared<
+        pipeline::DemandServlet<http::Request, http::Response>>(
+            snapshot_servlet_ptr, pipeline_);
+    hls_port_handler_ptr->RegisterServlet("/snapshot.jpg",
+                                          demand_snapshot_servlet_ptr);
+    hls_port_handler_ptr->RegisterServlet("/snapshots",
+                                          demand_snapshot_servlet_ptr);
 
-    hls_port_handler_ptr->RegisterServlet("/", servlet_ptr);
+    // Source frames for viewers without H.264 support
+    auto mjpeg_servlet_ptr = std::make_shared<multipart::MjpegServlet>(
+        kMjpegFrameTimeout);
+    pipeline_.AddFrameObserver(mjpeg_servlet_ptr);
+    hls_port_handler_ptr->RegisterServlet(
+        "/stream.mjpg",
+        std::make_shared<pipeline::DemandServlet<http::Request,
+                                                 http::Response>>(
+            mjpeg_servlet_ptr, pipeline_));
+
+    // Continuous MPEG2-TS for low latency consumers
+    auto ts_servlet_ptr = std::make_shared<progressive::TsServlet>(
+        kTsStreamQueueSize, kTsStreamMaxGopSize, kTsStreamFragmentTimeout);
+    pipeline_.AddFragmentObserver(ts_servlet_ptr);
+    pipeline_.AddStopCallback([ts_servlet_ptr] {
+      ts_servlet_ptr->ClearCache();
+    });
+    hls_port_handler_ptr->RegisterServlet(
+        "/stream.ts",
+        std::make_shared<pipeline::DemandServlet<http::Request,
+                                                 http::Response>>(
+            ts_servlet_ptr, pipeline_));
+    hls_port_handler_ptr->RegisterServlet(
+        "/latency", std::make_shared<metrics::LatencyServlet>());
+    hls_port_handler_ptr->RegisterServlet(
+        "/metrics", std::make_shared<metrics::PrometheusServlet>());
 
     return hls_port_handler_ptr;
   }
+
+  std::unique_ptr<port_handler::PortHandlerBase> BuildRtspPortHandler() {
+    const rtsp::ServerOptions server_options;
+    port_handler::Options options;
+    options.max_connections = kRtspMaxConnections;
+    // Clients send requests only as keep-alives within session timeout
+    options.idle_timeout = 2 * server_options.session_timeout;
+    options.io_timeout = 2 * server_options.session_timeout;
+    auto rtsp_port_handler_ptr = std::make_unique<
+        port_handler::PortHandler<rtsp::Request, rtsp::Response>>(kRtspPort,
+                                                                 options);
+
+    rtsp_servlet_ptr_ = std::make_shared<rtsp::ServerServlet>(server_options);
+    pipeline_.AddEncodedFrameObserver(rtsp_servlet_ptr_);
+    rtsp_port_handler_ptr->RegisterServlet(
+        "/live",
+        std::make_shared<pipeline::DemandServlet<rtsp::Request,
+                                                 rtsp::Response>>(
+            rtsp_servlet_ptr_, pipeline_));
+
+    return rtsp_port_handler_ptr;
+  }
 };
 
 } // namespace
@@ -116,13 +347,35 @@ int main(int argc, char **argv) {
       return EXIT_FAILURE;
     }
 
-    MediaServer media_server(argv[1]);
+    // Log level can be set with environment variable: debug, info, warning, error
+    if (const char *log_level = std::getenv("MEDIA_SERVER_LOG_LEVEL")) {
+      logging::Logger::GetInstance().SetLevel(logging::ParseLevel(log_level));
+    }
+
+    // Transcoding is stopped after this number of seconds without clients
+    std::chrono::seconds idle_timeout(kDefaultIdleTimeoutSec);
+    if (const char *idle_timeout_sec =
+            std::getenv("MEDIA_SERVER_IDLE_TIMEOUT_SEC")) {
+      idle_timeout = std::chrono::seconds(std::stoi(idle_timeout_sec));
+    }
+
+    // Directory is unique per process by default, as its files are removed
+    std::string segment_directory = std::string(kDefaultHlsSegmentDirectory) +
+                                    "-" + std::to_string(getpid());
+    if (const char *hls_segment_dir =
+            std::getenv("MEDIA_SERVER_HLS_SEGMENT_DIR")) {
+      segment_directory = hls_segment_dir;
+    }
+
+    MediaServer media_server(argv[1], segment_directory, idle_timeout,
+                             ReadTranscodingOptions(),
+                             ReadRecorderOptions());
     media_server.Start();
   } catch (const std::exception &ex) {
-    std::cerr << "Error: " << ex.what() << std::endl;
+    LOG(kError) << ex.what();
     return EXIT_FAILURE;
   } catch (...) {
-    std::cerr << "Unknown error occurred" << std::endl;
+    LOG(kError) << "Unknown error occurred";
     return EXIT_FAILURE;
   }
 
@@ -0,0 +1,64 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "counter.h"
+
+namespace metrics {
+
+Counter::Counter():
+shards_() {
+  for (auto &shard : shards_) {
+    shard.value.store(0, std::memory_order_relaxed);
+  }
+}
+
+uint64_t Counter::Get() const {
+  uint64_t sum = 0;
+  for (const auto &shard : shards_) {
+    sum += shard.value.load(std::memory_order_relaxed);
+  }
+
+  return sum;
+}
+
+Gauge::Gauge():
+value_(0) {
+}
+
+void Gauge::Set(const double value) {
+  value_.store(value, std::memory_order_relaxed);
+}
+
+void Gauge::Add(const double value) {
+  double current = value_.load(std::memory_order_relaxed);
+  while (!value_.compare_exchange_weak(current, current + value,
+                                       std::memory_order_relaxed)) {
+  }
+}
+
+double Gauge::Get() const {
+  return value_.load(std::memory_order_relaxed);
+}
+
+} // namespace metrics
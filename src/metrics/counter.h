@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+
+namespace metrics {
+
+/**
+ * @brief Monotonic counter, sharded between threads
+ * @details Every thread increments its own cache line, so hot paths of
+ * different threads never contend on the same atomic. Reading sums all shards
+ */
+class Counter {
+ public:
+  Counter();
+
+  Counter(const Counter &) = delete;
+  Counter &operator=(const Counter &) = delete;
+
+  /**
+   * @brief Increase counter
+   *
+   * @param value Value to add
+   */
+  void Add(const uint64_t value = 1) {
+    shards_[GetShardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /**
+   * @return Sum of all shards
+   */
+  [[nodiscard]] uint64_t Get() const;
+
+ private:
+  static constexpr std::size_t kShardCount = 16;
+  static constexpr std::size_t kCacheLineSize = 64;
+
+  /**
+   * @brief Part of counter, that is placed in its own cache line
+   */
+  struct alignas(kCacheLineSize) Shard {
+    std::atomic<uint64_t> value;
+  };
+
+  std::array<Shard, kShardCount> shards_;
+
+  /**
+   * @brief Get shard of calling thread. Threads get shards in round robin
+   *
+   * @return Shard index
+   */
+  static std::size_t GetShardIndex() {
+    static std::atomic<std::size_t> next_index{0};
+    thread_local const std::size_t index =
+        next_index.fetch_add(1, std::memory_order_relaxed) % kShardCount;
+    return index;
+  }
+};
+
+/**
+ * @brief Value, that can go up and down
+ */
+class Gauge {
+ public:
+  Gauge();
+
+  Gauge(const Gauge &) = delete;
+  Gauge &operator=(const Gauge &) = delete;
+
+  /**
+   * @param value New value
+   */
+  void Set(double value);
+
+  /**
+   * @param value Value to add. Can be negative
+   */
+  void Add(double value);
+
+  /**
+   * @return Current value
+   */
+  [[nodiscard]] double Get() const;
+
+ private:
+  std::atomic<double> value_;
+};
+
+} // namespace metrics
@@ -0,0 +1,133 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace metrics {
+
+Histogram::Histogram():
+buckets_(),
+count_(0),
+sum_(0),
+max_(0) {
+  for (auto &bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+void Histogram::Record(const uint64_t value) {
+  buckets_[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+
+  uint64_t max = max_.load(std::memory_order_relaxed);
+  while ((value > max) &&
+         !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+void Histogram::RecordDuration(const std::chrono::nanoseconds duration) {
+  const auto microseconds =
+      std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  Record(microseconds > 0 ? static_cast<uint64_t>(microseconds) : 0);
+}
+
+uint64_t Histogram::GetCount() const {
+  return count_.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::GetSum() const {
+  return sum_.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::GetMax() const {
+  return max_.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::GetQuantile(const double quantile) const {
+  // Buckets are read one by one, so total is taken from them and not count_
+  uint64_t total = 0;
+  for (const auto &bucket : buckets_) {
+    total += bucket.load(std::memory_order_relaxed);
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  const auto rank = static_cast<uint64_t>(
+      std::ceil(std::clamp(quantile, 0.0, 1.0) * total));
+  uint64_t seen = 0;
+  for (std::size_t i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if ((seen >= rank) && (seen > 0)) {
+      return std::min(GetBucketUpperBound(i), GetMax());
+    }
+  }
+
+  return GetMax();
+}
+
+uint64_t Histogram::GetBucketCount(const std::size_t index) const {
+  return buckets_.at(index).load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::GetBucketUpperBound(const std::size_t index) {
+  if (index < kSubBucketCount) {
+    return index;
+  }
+
+  const std::size_t shift = index / kSubBucketCount - 1;
+  const uint64_t sub_bucket = kSubBucketCount + index % kSubBucketCount;
+  return ((sub_bucket + 1) << shift) - 1;
+}
+
+std::size_t Histogram::GetBucketIndex(const uint64_t value) {
+  if (value < kSubBucketCount) {
+    return value;
+  }
+
+  const int msb = 63 - __builtin_clzll(value);
+  if (msb >= kMaxValueBits) {
+    return kBucketCount - 1;
+  }
+
+  // Top kSubBucketBits + 1 bits of value select the bucket
+  const int shift = msb - kSubBucketBits;
+  return (shift + 1) * kSubBucketCount +
+         ((value >> shift) & (kSubBucketCount - 1));
+}
+
+ScopedTimer::ScopedTimer(Histogram &histogram):
+histogram_(histogram),
+start_time_(std::chrono::steady_clock::now()) {
+}
+
+ScopedTimer::~ScopedTimer() {
+  histogram_.RecordDuration(std::chrono::steady_clock::now() - start_time_);
+}
+
+} // namespace metrics
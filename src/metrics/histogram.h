@@ -0,0 +1,142 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <chrono>
+
+namespace metrics {
+
+/**
+ * @brief Lock-free histogram of non-negative integer values
+ * @details Values are put in log-linear buckets like in HDR histogram: every
+ * power of two is split into kSubBucketCount equal buckets, so relative error
+ * of any quantile is below 1 / kSubBucketCount. Recording is a few relaxed
+ * atomic increments and can be done from any thread
+ */
+class Histogram {
+ public:
+  //! Number of bits of value, that select bucket inside power of two
+  static constexpr int kSubBucketBits = 4;
+  static constexpr uint64_t kSubBucketCount = 1U << kSubBucketBits;
+  //! Values with more significant bits are put in the last bucket
+  static constexpr int kMaxValueBits = 40;
+  static constexpr std::size_t kBucketCount =
+      (kMaxValueBits - kSubBucketBits + 1) * kSubBucketCount;
+
+  Histogram();
+
+  Histogram(const Histogram &) = delete;
+  Histogram &operator=(const Histogram &) = delete;
+
+  /**
+   * @brief Record value
+   *
+   * @param value Value to record
+   */
+  void Record(uint64_t value);
+
+  /**
+   * @brief Record duration in microseconds
+   *
+   * @param duration Duration to record. Negative durations are recorded as 0
+   */
+  void RecordDuration(std::chrono::nanoseconds duration);
+
+  /**
+   * @return Number of recorded values
+   */
+  [[nodiscard]] uint64_t GetCount() const;
+
+  /**
+   * @return Sum of all recorded values
+   */
+  [[nodiscard]] uint64_t GetSum() const;
+
+  /**
+   * @return Max recorded value
+   */
+  [[nodiscard]] uint64_t GetMax() const;
+
+  /**
+   * @brief Get approximate quantile
+   *
+   * @param quantile Quantile in range [0, 1]
+   * @return Upper bound of the bucket, that contains quantile
+   * @return 0 if histogram is empty
+   */
+  [[nodiscard]] uint64_t GetQuantile(double quantile) const;
+
+  /**
+   * @brief Get number of values in bucket
+   *
+   * @param index Bucket index less than kBucketCount
+   * @return Number of values
+   */
+  [[nodiscard]] uint64_t GetBucketCount(std::size_t index) const;
+
+  /**
+   * @brief Get max value, that is put in bucket
+   *
+   * @param index Bucket index less than kBucketCount
+   * @return Bucket upper bound
+   */
+  [[nodiscard]] static uint64_t GetBucketUpperBound(std::size_t index);
+
+ private:
+  std::array<std::atomic<uint64_t>, kBucketCount> buckets_;
+  std::atomic<uint64_t> count_; //!< Number of recorded values
+  std::atomic<uint64_t> sum_; //!< Sum of recorded values
+  std::atomic<uint64_t> max_; //!< Max recorded value
+
+  /**
+   * @brief Get index of bucket for value
+   *
+   * @param value Value
+   * @return Bucket index
+   */
+  [[nodiscard]] static std::size_t GetBucketIndex(uint64_t value);
+};
+
+/**
+ * @brief Records time of its life into histogram
+ */
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Histogram &histogram);
+
+  ~ScopedTimer();
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+ private:
+  Histogram &histogram_;
+  const std::chrono::steady_clock::time_point start_time_;
+};
+
+} // namespace metrics
@@ -0,0 +1,111 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <iomanip>
+#include <sstream>
+
+#include "servlet.h"
+#include "http/request.h"
+#include "http/response.h"
+#include "registry.h"
+
+namespace metrics {
+
+/**
+ * @brief Servlet, that shows quantiles of all registered histograms as a table
+ */
+class LatencyServlet : public Servlet<http::Request, http::Response> {
+ public:
+  [[nodiscard]] http::Response Handle(const http::Request &request) override {
+    if (request.method != http::Method::kGet) {
+      return {501, "Not Implemented"};
+    }
+
+    http::Response response;
+    response.code = 200;
+    response.description = "OK";
+    response.headers["Content-Type"] = "text/plain";
+    response.body = GetTable();
+    response.headers["Content-Length"] = std::to_string(response.body.size());
+
+    return response;
+  }
+
+ private:
+  static constexpr int kNameWidth = 40;
+  static constexpr int kValueWidth = 12;
+
+  /**
+   * @brief Build table with one histogram per line. Values are in microseconds
+   *
+   * @return Table
+   */
+  [[nodiscard]] static std::string GetTable() {
+    std::ostringstream oss;
+    oss << std::left << std::setw(kNameWidth) << "name" << std::right;
+    for (const char *column : {"count", "mean", "p50", "p90", "p99", "p999",
+                               "max"}) {
+      oss << std::setw(kValueWidth) << column;
+    }
+    oss << "\n";
+
+    Registry::GetInstance().VisitFamilies(
+        [&oss] (const std::string &name, const Registry::Family &family) {
+          if (family.type != Type::kHistogram) {
+            return;
+          }
+
+          for (const auto &[labels, metric] : family.metrics) {
+            const std::string full_name =
+                labels.empty() ? name : name + "{" + labels + "}";
+            PrintRow(oss, full_name, *metric.histogram_ptr);
+          }
+        });
+
+    return oss.str();
+  }
+
+  /**
+   * @brief Print histogram quantiles as one table row
+   *
+   * @param os Stream to print to
+   * @param name Row name
+   * @param histogram Histogram
+   */
+  static void PrintRow(std::ostream &os, const std::string &name,
+                       const Histogram &histogram) {
+    const uint64_t count = histogram.GetCount();
+    os << std::left << std::setw(kNameWidth) << name << std::right
+       << std::setw(kValueWidth) << count
+       << std::setw(kValueWidth) << (count == 0 ? 0 : histogram.GetSum() / count);
+    for (double quantile : {0.5, 0.9, 0.99, 0.999}) {
+      os << std::setw(kValueWidth) << histogram.GetQuantile(quantile);
+    }
+    os << std::setw(kValueWidth) << histogram.GetMax() << "\n";
+  }
+};
+
+} // namespace metrics
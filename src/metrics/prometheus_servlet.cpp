@@ -0,0 +1,150 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "prometheus_servlet.h"
+
+#include <limits>
+#include <sstream>
+
+namespace {
+
+/**
+ * @brief Build Prometheus series selector
+ *
+ * @param name Series name
+ * @param labels Labels. Can be empty
+ * @param extra_label Label to append to labels. Can be empty
+ * @return Series selector like name{labels,extra_label}
+ */
+std::string BuildSeries(const std::string &name, const std::string &labels,
+                        const std::string &extra_label = "") {
+  std::string all_labels = labels;
+  if (!extra_label.empty()) {
+    all_labels += (all_labels.empty() ? "" : ",") + extra_label;
+  }
+
+  return all_labels.empty() ? name : name + "{" + all_labels + "}";
+}
+
+/**
+ * @brief Get name of Prometheus metric type
+ *
+ * @param type Metric type
+ * @return Type name
+ */
+const char *TypeToString(const metrics::Type type) {
+  switch (type) {
+    case metrics::Type::kCounter:
+      return "counter";
+    case metrics::Type::kGauge:
+      return "gauge";
+    case metrics::Type::kHistogram:
+      return "histogram";
+    default:
+      return "untyped";
+  }
+}
+
+} // namespace
+
+namespace metrics {
+
+http::Response PrometheusServlet::Handle(const http::Request &request) {
+  if (request.method != http::Method::kGet) {
+    return {501, "Not Implemented"};
+  }
+
+  std::ostringstream oss;
+  WriteMetrics(oss);
+
+  http::Response response;
+  response.code = 200;
+  response.description = "OK";
+  response.headers["Content-Type"] = "text/plain; version=0.0.4";
+  response.body = oss.str();
+  response.headers["Content-Length"] = std::to_string(response.body.size());
+
+  return response;
+}
+
+void PrometheusServlet::WriteMetrics(std::ostream &os) {
+  os.precision(std::numeric_limits<double>::digits10);
+
+  Registry::GetInstance().VisitFamilies(
+      [&os] (const std::string &name, const Registry::Family &family) {
+        std::string full_name = kNamePrefix + name;
+        if (family.type == Type::kHistogram) {
+          full_name += "_seconds";
+        }
+
+        os << "# HELP " << full_name << " " << family.help << "\n"
+           << "# TYPE " << full_name << " " << TypeToString(family.type) << "\n";
+        for (const auto &[labels, metric] : family.metrics) {
+          if (metric.histogram_ptr) {
+            WriteHistogram(os, full_name, labels, *metric.histogram_ptr);
+          } else if (metric.callback) {
+            os << BuildSeries(full_name, labels) << " " << metric.callback()
+               << "\n";
+          } else if (metric.counter_ptr) {
+            os << BuildSeries(full_name, labels) << " "
+               << metric.counter_ptr->Get() << "\n";
+          } else if (metric.gauge_ptr) {
+            os << BuildSeries(full_name, labels) << " "
+               << metric.gauge_ptr->Get() << "\n";
+          }
+        }
+      });
+}
+
+void PrometheusServlet::WriteHistogram(std::ostream &os,
+                                       const std::string &name,
+                                       const std::string &labels,
+                                       const Histogram &histogram) {
+  const double kMicrosecondsInSecond = 1'000'000.0;
+  const std::string bucket_name = name + "_bucket";
+
+  uint64_t cumulative_count = 0;
+  int next_bound_bits = kMinBucketBits;
+  for (std::size_t i = 0; i < Histogram::kBucketCount; ++i) {
+    cumulative_count += histogram.GetBucketCount(i);
+
+    const uint64_t bound = Histogram::GetBucketUpperBound(i) + 1;
+    if ((next_bound_bits <= kMaxBucketBits) &&
+        (bound == (uint64_t{1} << next_bound_bits))) {
+      os << BuildSeries(bucket_name, labels,
+                        "le=\"" + std::to_string(bound / kMicrosecondsInSecond)
+                            + "\"")
+         << " " << cumulative_count << "\n";
+      ++next_bound_bits;
+    }
+  }
+
+  os << BuildSeries(bucket_name, labels, "le=\"+Inf\"") << " "
+     << cumulative_count << "\n"
+     << BuildSeries(name + "_sum", labels) << " "
+     << histogram.GetSum() / kMicrosecondsInSecond << "\n"
+     << BuildSeries(name + "_count", labels) << " " << cumulative_count << "\n";
+}
+
+} // namespace metrics
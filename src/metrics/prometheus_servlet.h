@@ -0,0 +1,73 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <ostream>
+#include <string>
+
+#include "servlet.h"
+#include "http/request.h"
+#include "http/response.h"
+#include "registry.h"
+
+namespace metrics {
+
+/**
+ * @brief Servlet, that exports all registered metrics in Prometheus text format
+ * @details Every metric name is prefixed with "media_server_". Histograms are
+ * exported in seconds with power of two bucket bounds
+ */
+class PrometheusServlet : public Servlet<http::Request, http::Response> {
+ public:
+  [[nodiscard]] http::Response Handle(const http::Request &request) override;
+
+ private:
+  static constexpr char kNamePrefix[] = "media_server_";
+  //! Smallest and largest histogram bucket bounds are 2^kMinBucketBits and
+  //! 2^kMaxBucketBits microseconds
+  static constexpr int kMinBucketBits = Histogram::kSubBucketBits;
+  static constexpr int kMaxBucketBits = 26;
+
+  /**
+   * @brief Write all metrics of the registry
+   *
+   * @param os Stream to write to
+   */
+  static void WriteMetrics(std::ostream &os);
+
+  /**
+   * @brief Write histogram as set of cumulative buckets, sum and count
+   *
+   * @param os Stream to write to
+   * @param name Full family name
+   * @param labels Labels of histogram
+   * @param histogram Histogram with microseconds
+   */
+  static void WriteHistogram(std::ostream &os, const std::string &name,
+                             const std::string &labels,
+                             const Histogram &histogram);
+};
+
+} // namespace metrics
@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "registry.h"
+
+#include <stdexcept>
+
+namespace metrics {
+
+Registry &Registry::GetInstance() {
+  static Registry registry;
+  return registry;
+}
+
+Registry::Registry():
+families_(),
+mutex_() {
+}
+
+Counter &Registry::GetCounter(const std::string &name, const std::string &help,
+                              const std::string &labels) {
+  std::lock_guard guard(mutex_);
+  Metric &metric = GetMetric(name, help, Type::kCounter, labels);
+  if (!metric.counter_ptr) {
+    metric.counter_ptr = std::make_unique<Counter>();
+  }
+
+  return *metric.counter_ptr;
+}
+
+Gauge &Registry::GetGauge(const std::string &name, const std::string &help,
+                          const std::string &labels) {
+  std::lock_guard guard(mutex_);
+  Metric &metric = GetMetric(name, help, Type::kGauge, labels);
+  if (!metric.gauge_ptr) {
+    metric.gauge_ptr = std::make_unique<Gauge>();
+  }
+
+  return *metric.gauge_ptr;
+}
+
+Histogram &Registry::GetHistogram(const std::string &name,
+                                  const std::string &help,
+                                  const std::string &labels) {
+  std::lock_guard guard(mutex_);
+  Metric &metric = GetMetric(name, help, Type::kHistogram, labels);
+  if (!metric.histogram_ptr) {
+    metric.histogram_ptr = std::make_unique<Histogram>();
+  }
+
+  return *metric.histogram_ptr;
+}
+
+void Registry::AddCallback(const std::string &name, const std::string &help,
+                           const Type type, std::function<double()> callback,
+                           const std::string &labels) {
+  if (type == Type::kHistogram) {
+    throw std::logic_error("Histogram can't be sampled with callback");
+  }
+
+  std::lock_guard guard(mutex_);
+  GetMetric(name, help, type, labels).callback = std::move(callback);
+}
+
+void Registry::VisitFamilies(const FamilyVisitor &visitor) const {
+  std::lock_guard guard(mutex_);
+  for (const auto &[name, family] : families_) {
+    visitor(name, family);
+  }
+}
+
+Registry::Metric &Registry::GetMetric(const std::string &name,
+                                      const std::string &help, const Type type,
+                                      const std::string &labels) {
+  auto [it, inserted] = families_.try_emplace(name);
+  Family &family = it->second;
+  if (inserted) {
+    family.type = type;
+    family.help = help;
+  } else if (family.type != type) {
+    throw std::logic_error("Metric " + name + " is already registered with "
+                           "another type");
+  }
+
+  return family.metrics[labels];
+}
+
+Histogram &GetStageLatency(const std::string &stage) {
+  return Registry::GetInstance().GetHistogram(
+      "stage_latency", "Latency of pipeline stage", "stage=\"" + stage + "\"");
+}
+
+} // namespace metrics
@@ -0,0 +1,176 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "counter.h"
+#include "histogram.h"
+
+namespace metrics {
+
+/**
+ * @brief Kind of metric family
+ */
+enum class Type {
+  kCounter,
+  kGauge,
+  kHistogram
+};
+
+/**
+ * @brief Global registry of named metrics
+ * @details Metrics are grouped in families by name and are distinguished
+ * inside family by labels written as in Prometheus: key="value",key2="value2".
+ * Metrics are created on first request and live until program exit, so callers
+ * may keep references to them and use them without any lookups.
+ * All histograms keep durations in microseconds
+ */
+class Registry {
+ public:
+  /**
+   * @brief Single metric. Only one of the fields is set according to family type
+   */
+  struct Metric {
+    std::unique_ptr<Counter> counter_ptr;
+    std::unique_ptr<Gauge> gauge_ptr;
+    std::unique_ptr<Histogram> histogram_ptr;
+    //! Function to sample value of counter or gauge, that is stored elsewhere
+    std::function<double()> callback;
+  };
+
+  /**
+   * @brief Metrics with the same name
+   */
+  struct Family {
+    Type type;
+    std::string help; //!< Description of family
+    std::map<std::string, Metric> metrics; //!< Labels -> Metric
+  };
+
+  using FamilyVisitor =
+      std::function<void(const std::string &name, const Family &family)>;
+
+  /**
+   * @brief Get global registry
+   *
+   * @return Registry
+   */
+  static Registry &GetInstance();
+
+  Registry(const Registry &) = delete;
+  Registry &operator=(const Registry &) = delete;
+
+  /**
+   * @brief Get counter. Creates it on first call
+   * @throw std::logic_error if family with such name has another type
+   *
+   * @param name Family name
+   * @param help Family description
+   * @param labels Labels of counter inside family
+   * @return Counter
+   */
+  Counter &GetCounter(const std::string &name, const std::string &help,
+                      const std::string &labels = "");
+
+  /**
+   * @brief Get gauge. Creates it on first call
+   * @throw std::logic_error if family with such name has another type
+   *
+   * @param name Family name
+   * @param help Family description
+   * @param labels Labels of gauge inside family
+   * @return Gauge
+   */
+  Gauge &GetGauge(const std::string &name, const std::string &help,
+                  const std::string &labels = "");
+
+  /**
+   * @brief Get histogram with durations in microseconds. Creates it on first call
+   * @throw std::logic_error if family with such name has another type
+   *
+   * @param name Family name
+   * @param help Family description
+   * @param labels Labels of histogram inside family
+   * @return Histogram
+   */
+  Histogram &GetHistogram(const std::string &name, const std::string &help,
+                          const std::string &labels = "");
+
+  /**
+   * @brief Register counter or gauge, which value is sampled on every read
+   * @throw std::logic_error if family with such name has another type
+   *
+   * @param name Family name
+   * @param help Family description
+   * @param type kCounter or kGauge
+   * @param callback Function, that returns current value. Is called under
+   * registry lock, so must not use registry
+   * @param labels Labels of metric inside family
+   */
+  void AddCallback(const std::string &name, const std::string &help, Type type,
+                   std::function<double()> callback,
+                   const std::string &labels = "");
+
+  /**
+   * @brief Call visitor for every family in order of names under registry lock
+   *
+   * @param visitor Visitor to call
+   */
+  void VisitFamilies(const FamilyVisitor &visitor) const;
+
+ private:
+  std::map<std::string, Family> families_; //!< Name -> Family
+  mutable std::mutex mutex_; //!< Mutex for families_
+
+  Registry();
+
+  /**
+   * @brief Get metric, creating it and its family if needed
+   * @details mutex_ must be locked
+   *
+   * @param name Family name
+   * @param help Family description
+   * @param type Family type
+   * @param labels Labels of metric
+   * @return Metric
+   */
+  Metric &GetMetric(const std::string &name, const std::string &help,
+                    Type type, const std::string &labels);
+};
+
+/**
+ * @brief Get histogram of pipeline stage latency
+ *
+ * @param stage Stage name
+ * @return Histogram with latencies in microseconds
+ */
+Histogram &GetStageLatency(const std::string &stage);
+
+} // namespace metrics
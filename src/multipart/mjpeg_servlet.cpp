@@ -0,0 +1,143 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "mjpeg_servlet.h"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+
+namespace multipart {
+
+namespace {
+
+const char kBoundary[] = "frame";
+
+} // namespace
+
+MjpegServlet::MjpegServlet(const std::chrono::milliseconds frame_timeout):
+frame_timeout_(frame_timeout),
+viewers_(),
+viewers_mutex_(),
+viewers_gauge_(metrics::Registry::GetInstance().GetGauge(
+    "mjpeg_viewers", "Number of connected MJPEG stream viewers")),
+dropped_frames_counter_(metrics::Registry::GetInstance().GetCounter(
+    "mjpeg_dropped_frames_total", "Number of frames not sent to MJPEG viewers, "
+    "because they were slower than the source")) {
+}
+
+http::Response MjpegServlet::Handle(const http::Request &request) {
+  using namespace std::string_literals;
+
+  if (request.method != http::Method::kGet) {
+    return {501, "Not Implemented"};
+  }
+  if (!request.url.empty()) {
+    return {404, "Not Found"};
+  }
+
+  auto viewer_ptr = std::make_shared<Viewer>(frame_timeout_, viewers_gauge_,
+                                             dropped_frames_counter_);
+  {
+    std::lock_guard guard(viewers_mutex_);
+    viewers_.push_back(viewer_ptr);
+  }
+
+  http::Response response(200, "OK");
+  response.headers["Content-Type"] =
+      "multipart/x-mixed-replace; boundary="s + kBoundary;
+  response.headers["Cache-Control"] = "no-cache";
+  response.headers["Connection"] = "close";
+  response.body_stream_ptr = std::move(viewer_ptr);
+
+  return response;
+}
+
+void MjpegServlet::Receive(DataPtr frame_ptr) {
+  std::lock_guard guard(viewers_mutex_);
+  auto it = std::remove_if(viewers_.begin(), viewers_.end(),
+                           [&frame_ptr] (const std::weak_ptr<Viewer> &weak_ptr) {
+                             auto viewer_ptr = weak_ptr.lock();
+                             if (!viewer_ptr) {
+                               return true;
+                             }
+                             viewer_ptr->Push(frame_ptr);
+                             return false;
+                           });
+  viewers_.erase(it, viewers_.end());
+}
+
+MjpegServlet::Viewer::Viewer(const std::chrono::milliseconds frame_timeout,
+                             metrics::Gauge &viewers_gauge,
+                             metrics::Counter &dropped_frames_counter):
+frame_timeout_(frame_timeout),
+frame_ptr_(),
+frame_mutex_(),
+frame_cv_(),
+viewers_gauge_(viewers_gauge),
+dropped_frames_counter_(dropped_frames_counter) {
+  viewers_gauge_.Add(1);
+}
+
+MjpegServlet::Viewer::~Viewer() {
+  viewers_gauge_.Add(-1);
+}
+
+void MjpegServlet::Viewer::Push(DataPtr frame_ptr) {
+  {
+    std::lock_guard guard(frame_mutex_);
+    if (frame_ptr_) {
+      dropped_frames_counter_.Add();
+    }
+    frame_ptr_ = std::move(frame_ptr);
+  }
+  frame_cv_.notify_one();
+}
+
+bool MjpegServlet::Viewer::SendNext(sock::Socket &socket) {
+  using namespace std::string_literals;
+
+  DataPtr frame_ptr;
+  {
+    std::unique_lock lock(frame_mutex_);
+    if (!frame_cv_.wait_for(lock, frame_timeout_,
+                            [this] { return frame_ptr_ != nullptr; })) {
+      return false;
+    }
+    frame_ptr = std::move(frame_ptr_);
+  }
+
+  // Leading CRLF belongs to the delimiter, so nothing is sent after the data
+  const types::Bytes &data = frame_ptr->data;
+  socket.Send("\r\n--"s + kBoundary + "\r\n"
+              "Content-Type: image/jpeg\r\n"
+              "Content-Length: " + std::to_string(data.size()) + "\r\n\r\n",
+              true);
+  socket.Send(std::string_view(reinterpret_cast<const char *>(data.data()),
+                               data.size()));
+
+  return true;
+}
+
+} // namespace multipart
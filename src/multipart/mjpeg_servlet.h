@@ -0,0 +1,112 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "servlet.h"
+#include "http/request.h"
+#include "http/response.h"
+#include "http/body_stream.h"
+#include "observer.h"
+#include "types/mjpeg_frame.h"
+#include "metrics/registry.h"
+
+namespace multipart {
+
+/**
+ * @brief Servlet, that streams source JPEG frames as multipart/x-mixed-replace
+ * @details Every frame is shared between all viewers without copying. Each
+ * viewer keeps only the latest frame it hasn't sent yet, so slow viewers skip
+ * frames instead of holding back others or accumulating them in memory
+ */
+class MjpegServlet : public Servlet<http::Request, http::Response>,
+                     public Observer<types::MjpegFrame> {
+ public:
+  /**
+   * @param frame_timeout Max time to wait for a frame before viewer stream is
+   * finished
+   */
+  explicit MjpegServlet(std::chrono::milliseconds frame_timeout);
+
+  [[nodiscard]] http::Response Handle(const http::Request &request) override;
+
+  /**
+   * @param frame_ptr JPEG frame. Shared with all viewers
+   */
+  void Receive(DataPtr frame_ptr) override;
+
+ private:
+  class Viewer;
+
+  const std::chrono::milliseconds frame_timeout_;
+  //! Viewers are owned by their connections and expire on disconnect
+  std::vector<std::weak_ptr<Viewer>> viewers_;
+  std::mutex viewers_mutex_; //!< Mutex for viewers_
+  metrics::Gauge &viewers_gauge_;
+  metrics::Counter &dropped_frames_counter_;
+};
+
+/**
+ * @brief Stream of one viewer with a single frame slot
+ */
+class MjpegServlet::Viewer : public http::BodyStream {
+ public:
+  /**
+   * @param frame_timeout Max time to wait for a frame
+   * @param viewers_gauge Gauge of viewer count
+   * @param dropped_frames_counter Counter of frames replaced before sending
+   */
+  Viewer(std::chrono::milliseconds frame_timeout, metrics::Gauge &viewers_gauge,
+         metrics::Counter &dropped_frames_counter);
+
+  ~Viewer() override;
+
+  Viewer(const Viewer &) = delete;
+  Viewer &operator=(const Viewer &) = delete;
+
+  /**
+   * @brief Replace unsent frame with the new one
+   *
+   * @param frame_ptr JPEG frame
+   */
+  void Push(DataPtr frame_ptr);
+
+  bool SendNext(sock::Socket &socket) override;
+
+ private:
+  const std::chrono::milliseconds frame_timeout_;
+  DataPtr frame_ptr_; //!< Frame to send next. nullptr if there is none
+  std::mutex frame_mutex_; //!< Mutex for frame_ptr_
+  std::condition_variable frame_cv_; //!< Notified on new frame
+  metrics::Gauge &viewers_gauge_;
+  metrics::Counter &dropped_frames_counter_;
+};
+
+} // namespace multipart
@@ -24,17 +24,23 @@ SOFTWARE.
 
 #pragma once
 
+#include <memory>
+
 #include "types/byte.h"
 
 /**
  * @brief Observer class, that can receive data from Providers
+ * @details Data is shared between all observers and must not be modified.
+ * Observer can keep the pointer to use data later without copying it
  *
  * @tparam Data Type of data to receive
  */
 template <typename Data>
 class Observer {
  public:
+  using DataPtr = std::shared_ptr<const Data>;
+
   virtual ~Observer() = default;
 
-  virtual void Receive(const Data &data) = 0;
+  virtual void Receive(DataPtr data_ptr) = 0;
 };
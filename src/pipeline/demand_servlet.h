@@ -0,0 +1,93 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <memory>
+
+#include "servlet.h"
+#include "http/body_stream.h"
+#include "on_demand_pipeline.h"
+
+namespace pipeline {
+
+/**
+ * @brief Servlet decorator, that marks demand for the pipeline on every request
+ *
+ * @tparam RequestType Type of client request
+ * @tparam ResponseType Type of response
+ */
+template <typename RequestType, typename ResponseType>
+class DemandServlet : public Servlet<RequestType, ResponseType> {
+ public:
+  using WrappedServlet = Servlet<RequestType, ResponseType>;
+
+  /**
+   * @param servlet_ptr Servlet to handle requests
+   * @param pipeline Pipeline, that feeds servlet with data
+   */
+  DemandServlet(std::shared_ptr<WrappedServlet> servlet_ptr,
+                OnDemandPipeline &pipeline):
+  servlet_ptr_(std::move(servlet_ptr)),
+  pipeline_(pipeline) {
+  }
+
+  [[nodiscard]] ResponseType Handle(const RequestType &request) override {
+    pipeline_.Touch();
+    ResponseType response = servlet_ptr_->Handle(request);
+    if (response.body_stream_ptr) {
+      response.body_stream_ptr = std::make_shared<DemandBodyStream>(
+          std::move(response.body_stream_ptr), pipeline_);
+    }
+
+    return response;
+  }
+
+ private:
+  /**
+   * @brief Stream, that keeps the pipeline running while it's being sent
+   */
+  class DemandBodyStream : public http::BodyStream {
+   public:
+    DemandBodyStream(std::shared_ptr<http::BodyStream> body_stream_ptr,
+                     OnDemandPipeline &pipeline):
+    body_stream_ptr_(std::move(body_stream_ptr)),
+    pipeline_(pipeline) {
+    }
+
+    bool SendNext(sock::Socket &socket) override {
+      pipeline_.Touch();
+      return body_stream_ptr_->SendNext(socket);
+    }
+
+   private:
+    const std::shared_ptr<http::BodyStream> body_stream_ptr_;
+    OnDemandPipeline &pipeline_;
+  };
+
+  const std::shared_ptr<WrappedServlet> servlet_ptr_;
+  OnDemandPipeline &pipeline_;
+};
+
+} // namespace pipeline
@@ -0,0 +1,183 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "on_demand_pipeline.h"
+
+#include "logging/logger.h"
+
+namespace pipeline {
+
+OnDemandPipeline::OnDemandPipeline(std::string rtsp_stream_url,
+                                   const float chunk_duration,
+                                   const std::chrono::milliseconds idle_timeout,
+                                   const converters::MjpegToH264Options &
+                                       transcoding_options):
+rtsp_stream_url_(std::move(rtsp_stream_url)),
+chunk_duration_(chunk_duration),
+idle_timeout_(idle_timeout),
+transcoding_options_(transcoding_options),
+touched_(false),
+last_touch_time_(0),
+next_start_time_(),
+chunk_observers_(),
+frame_observers_(),
+fragment_observers_(),
+encoded_frame_observers_(),
+stop_callbacks_(),
+rtsp_client_ptr_(),
+mjpeg_to_h264_ptr_(),
+mpeg2ts_packager_ptr_(),
+mpeg2ts_streamer_ptr_(),
+width_(0),
+height_(0),
+fps_(0) {
+}
+
+void OnDemandPipeline::AddObserver(std::shared_ptr<ChunkObserver> observer_ptr) {
+  if (mpeg2ts_packager_ptr_) {
+    mpeg2ts_packager_ptr_->AddObserver(observer_ptr);
+  }
+  chunk_observers_.push_back(std::move(observer_ptr));
+}
+
+void OnDemandPipeline::AddFrameObserver(
+    std::shared_ptr<FrameObserver> observer_ptr) {
+  frame_observers_.push_back(std::move(observer_ptr));
+}
+
+void OnDemandPipeline::AddFragmentObserver(
+    std::shared_ptr<FragmentObserver> observer_ptr) {
+  fragment_observers_.push_back(std::move(observer_ptr));
+}
+
+void OnDemandPipeline::AddEncodedFrameObserver(
+    std::shared_ptr<EncodedFrameObserver> observer_ptr) {
+  encoded_frame_observers_.push_back(std::move(observer_ptr));
+}
+
+void OnDemandPipeline::AddStopCallback(std::function<void()> callback) {
+  stop_callbacks_.push_back(std::move(callback));
+}
+
+void OnDemandPipeline::Touch() {
+  last_touch_time_.store(Clock::now().time_since_epoch().count(),
+                         std::memory_order_relaxed);
+  touched_.store(true, std::memory_order_release);
+}
+
+void OnDemandPipeline::Update() {
+  const Clock::time_point now = Clock::now();
+  const bool demanded = IsDemanded(now);
+
+  if (rtsp_client_ptr_ && !demanded) {
+    Stop();
+  } else if (!rtsp_client_ptr_ && demanded && (now >= next_start_time_)) {
+    try {
+      Start();
+    } catch (const std::exception &ex) {
+      LOG(kWarning) << "Can't start pipeline: " << ex.what();
+      next_start_time_ = now + kRestartDelay;
+    }
+  }
+}
+
+bool OnDemandPipeline::IsRunning() const {
+  return rtsp_client_ptr_ != nullptr;
+}
+
+bool OnDemandPipeline::IsDemanded(const Clock::time_point now) const {
+  if (!touched_.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  const Clock::time_point last_touch_time(
+      Clock::duration(last_touch_time_.load(std::memory_order_relaxed)));
+  return now - last_touch_time <= idle_timeout_;
+}
+
+void OnDemandPipeline::Start() {
+  LOG(kInfo) << "Starting pipeline for " << rtsp_stream_url_;
+
+  auto rtsp_client_ptr = std::make_unique<rtsp::Client>(rtsp_stream_url_);
+  PrepareConverters(rtsp_client_ptr->GetWidth(), rtsp_client_ptr->GetHeight(),
+                    rtsp_client_ptr->GetFps());
+  rtsp_client_ptr->AddObserver(mjpeg_to_h264_ptr_);
+  for (const auto &observer_ptr : frame_observers_) {
+    rtsp_client_ptr->AddObserver(observer_ptr);
+  }
+  rtsp_client_ptr_ = std::move(rtsp_client_ptr);
+}
+
+void OnDemandPipeline::Stop() {
+  LOG(kInfo) << "Stopping idle pipeline for " << rtsp_stream_url_;
+  rtsp_client_ptr_.reset();
+
+  // Frames of this run must not get into chunks of the next one
+  mjpeg_to_h264_ptr_->Flush();
+  mpeg2ts_packager_ptr_->Reset();
+  for (const auto &callback : stop_callbacks_) {
+    callback();
+  }
+}
+
+void OnDemandPipeline::PrepareConverters(const int width, const int height,
+                                         const int fps) {
+  if (mjpeg_to_h264_ptr_ &&
+      (width == width_) && (height == height_) && (fps == fps_)) {
+    return;
+  }
+
+  LOG(kInfo) << "Creating converters for " << width << "x" << height
+             << " at " << fps << " fps with "
+             << transcoding_options_.decoder_count << " decoder threads";
+  // Every chunk starts with a key frame and is cut at the next one
+  converters::MjpegToH264Options transcoding_options = transcoding_options_;
+  transcoding_options.key_frame_interval = static_cast<int64_t>(
+      chunk_duration_ * 90'000);
+  mjpeg_to_h264_ptr_ = std::make_shared<converters::MjpegToH264>(
+      width, height, fps, transcoding_options);
+  mpeg2ts_packager_ptr_ = std::make_shared<converters::Mpeg2TsPackager>(
+      width, height, fps, chunk_duration_);
+  mjpeg_to_h264_ptr_->AddObserver(mpeg2ts_packager_ptr_);
+  for (const auto &observer_ptr : encoded_frame_observers_) {
+    mjpeg_to_h264_ptr_->AddObserver(observer_ptr);
+  }
+  for (const auto &observer_ptr : chunk_observers_) {
+    mpeg2ts_packager_ptr_->AddObserver(observer_ptr);
+  }
+  if (!fragment_observers_.empty()) {
+    mpeg2ts_streamer_ptr_ = std::make_shared<converters::Mpeg2TsStreamer>(
+        width, height);
+    mjpeg_to_h264_ptr_->AddObserver(mpeg2ts_streamer_ptr_);
+    for (const auto &observer_ptr : fragment_observers_) {
+      mpeg2ts_streamer_ptr_->AddObserver(observer_ptr);
+    }
+  }
+
+  width_ = width;
+  height_ = height;
+  fps_ = fps;
+}
+
+} // namespace pipeline
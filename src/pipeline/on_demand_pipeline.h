@@ -0,0 +1,183 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "observer.h"
+#include "rtsp/client.h"
+#include "converters/mjpeg_to_h264.h"
+#include "converters/mpeg2ts_packager.h"
+#include "converters/mpeg2ts_streamer.h"
+#include "types/mpeg2ts_chunk.h"
+
+namespace pipeline {
+
+/**
+ * @brief RTSP ingest and transcoding, that runs only while there is demand
+ * @details Ingest is started by Update() after the first Touch() and is stopped
+ * when nothing touched the pipeline for idle timeout. Converters are kept
+ * between runs, so codec contexts don't have to be recreated on every start
+ */
+class OnDemandPipeline {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using ChunkObserver = Observer<types::Mpeg2TsChunk>;
+  using FrameObserver = Observer<types::MjpegFrame>;
+  using FragmentObserver = Observer<types::Mpeg2TsFragment>;
+  using EncodedFrameObserver = Observer<types::H264Frame>;
+
+  /**
+   * @param rtsp_stream_url Url of the source RTSP stream
+   * @param chunk_duration Max duration of one MPEG2-TS chunk in seconds
+   * @param idle_timeout Time without demand after which pipeline is stopped
+   * @param transcoding_options Options of MJPEG to H.264 transcoding
+   */
+  OnDemandPipeline(std::string rtsp_stream_url, float chunk_duration,
+                   std::chrono::milliseconds idle_timeout,
+                   const converters::MjpegToH264Options &transcoding_options);
+
+  OnDemandPipeline(const OnDemandPipeline &) = delete;
+  OnDemandPipeline &operator=(const OnDemandPipeline &) = delete;
+
+  /**
+   * @brief Subscribe observer to MPEG2-TS chunks. Must be called before Update()
+   *
+   * @param observer_ptr Observer to receive chunks
+   */
+  void AddObserver(std::shared_ptr<ChunkObserver> observer_ptr);
+
+  /**
+   * @brief Subscribe observer to source JPEG frames. Must be called before
+   * Update()
+   *
+   * @param observer_ptr Observer to receive frames
+   */
+  void AddFrameObserver(std::shared_ptr<FrameObserver> observer_ptr);
+
+  /**
+   * @brief Subscribe observer to fragments of continuous MPEG2-TS stream. Must
+   * be called before Update()
+   * @details Stream is packed only if there is at least one such observer
+   *
+   * @param observer_ptr Observer to receive fragments
+   */
+  void AddFragmentObserver(std::shared_ptr<FragmentObserver> observer_ptr);
+
+  /**
+   * @brief Subscribe observer to encoded H.264 frames. Must be called before
+   * Update()
+   *
+   * @param observer_ptr Observer to receive frames
+   */
+  void AddEncodedFrameObserver(std::shared_ptr<EncodedFrameObserver> observer_ptr);
+
+  /**
+   * @brief Add callback, that is called after the pipeline is stopped, so
+   * stale data of the stopped run isn't served as live. Must be called before
+   * Update()
+   *
+   * @param callback Callback. No frames are provided while it runs
+   */
+  void AddStopCallback(std::function<void()> callback);
+
+  /**
+   * @brief Mark demand for the pipeline. Cheap, can be called from any thread
+   */
+  void Touch();
+
+  /**
+   * @brief Start pipeline if it's demanded or stop it if it's idle
+   * @details Can block while connecting to the RTSP server, so should be called
+   * periodically from a single control thread
+   */
+  void Update();
+
+  /**
+   * @return True, if pipeline is running
+   */
+  [[nodiscard]] bool IsRunning() const;
+
+ private:
+  //! Delay before next start attempt if previous one has failed
+  static constexpr std::chrono::seconds kRestartDelay{5};
+
+  const std::string rtsp_stream_url_;
+  const float chunk_duration_;
+  const std::chrono::milliseconds idle_timeout_;
+  const converters::MjpegToH264Options transcoding_options_;
+  //! True, if Touch() was called at least once
+  std::atomic<bool> touched_;
+  //! Time of the last Touch() call in Clock ticks
+  std::atomic<Clock::rep> last_touch_time_;
+  //! Earliest time for the next start attempt
+  Clock::time_point next_start_time_;
+  std::vector<std::shared_ptr<ChunkObserver>> chunk_observers_;
+  std::vector<std::shared_ptr<FrameObserver>> frame_observers_;
+  std::vector<std::shared_ptr<FragmentObserver>> fragment_observers_;
+  std::vector<std::shared_ptr<EncodedFrameObserver>> encoded_frame_observers_;
+  std::vector<std::function<void()>> stop_callbacks_;
+  std::unique_ptr<rtsp::Client> rtsp_client_ptr_; //!< nullptr if not running
+  std::shared_ptr<converters::MjpegToH264> mjpeg_to_h264_ptr_;
+  std::shared_ptr<converters::Mpeg2TsPackager> mpeg2ts_packager_ptr_;
+  //! nullptr if there are no fragment observers
+  std::shared_ptr<converters::Mpeg2TsStreamer> mpeg2ts_streamer_ptr_;
+  int width_; //!< Image width converters were created for
+  int height_; //!< Image height converters were created for
+  int fps_; //!< Video fps converters were created for
+
+  /**
+   * @param now Current time
+   * @return True, if pipeline was touched within idle timeout
+   */
+  [[nodiscard]] bool IsDemanded(Clock::time_point now) const;
+
+  /**
+   * @brief Connect to the RTSP server and subscribe converters to it
+   */
+  void Start();
+
+  /**
+   * @brief Teardown RTSP session. Converters are kept for the next start, but
+   * unfinished chunk is dropped
+   */
+  void Stop();
+
+  /**
+   * @brief Create converters if there are none or stream parameters changed
+   *
+   * @param width Image width
+   * @param height Image height
+   * @param fps Video fps
+   */
+  void PrepareConverters(int width, int height, int fps);
+};
+
+} // namespace pipeline
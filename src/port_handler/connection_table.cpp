@@ -0,0 +1,119 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "connection_table.h"
+
+#include <sys/socket.h>
+
+#include <algorithm>
+
+namespace port_handler {
+
+ConnectionTable::ConnectionTable(const std::size_t max_count,
+                                 const std::chrono::milliseconds idle_timeout,
+                                 const std::chrono::milliseconds tick) :
+max_count_(max_count),
+tick_(std::max(tick, std::chrono::milliseconds(1))),
+timeout_ticks_(std::max<uint64_t>(idle_timeout / tick_, 1)),
+start_time_(Clock::now()),
+slots_(timeout_ticks_ + 1),
+deadlines_(),
+last_expired_tick_(0),
+mutex_() {
+}
+
+bool ConnectionTable::TryAdd(const int descriptor) {
+  std::lock_guard guard(mutex_);
+  if (deadlines_.size() >= max_count_) {
+    return false;
+  }
+
+  Schedule(descriptor, GetCurrentTick() + timeout_ticks_);
+  return true;
+}
+
+void ConnectionTable::Remove(const int descriptor) {
+  std::lock_guard guard(mutex_);
+  auto it = deadlines_.find(descriptor);
+  if (it == deadlines_.end()) {
+    return;
+  }
+
+  slots_[it->second % slots_.size()].erase(descriptor);
+  deadlines_.erase(it);
+}
+
+void ConnectionTable::Touch(const int descriptor) {
+  std::lock_guard guard(mutex_);
+  auto it = deadlines_.find(descriptor);
+  if (it == deadlines_.end()) {
+    return;
+  }
+
+  slots_[it->second % slots_.size()].erase(descriptor);
+  Schedule(descriptor, GetCurrentTick() + timeout_ticks_);
+}
+
+void ConnectionTable::ShutdownIdle() {
+  std::lock_guard guard(mutex_);
+  const uint64_t current_tick = GetCurrentTick();
+
+  // Every slot is checked at most once per wheel turn
+  const uint64_t first_tick = std::max(last_expired_tick_ + 1,
+                                       current_tick - std::min<uint64_t>(
+                                           current_tick, slots_.size() - 1));
+  for (uint64_t tick = first_tick; tick <= current_tick; ++tick) {
+    auto &slot = slots_[tick % slots_.size()];
+    for (auto it = slot.begin(); it != slot.end();) {
+      const int descriptor = *it;
+      if (deadlines_.at(descriptor) > current_tick) {
+        ++it;
+        continue;
+      }
+
+      // Handler thread wakes up, fails to read and removes connection itself
+      shutdown(descriptor, SHUT_RDWR);
+      deadlines_.at(descriptor) = UINT64_MAX;
+      it = slot.erase(it);
+    }
+  }
+  last_expired_tick_ = current_tick;
+}
+
+std::size_t ConnectionTable::GetCount() const {
+  std::lock_guard guard(mutex_);
+  return deadlines_.size();
+}
+
+uint64_t ConnectionTable::GetCurrentTick() const {
+  return (Clock::now() - start_time_) / tick_;
+}
+
+void ConnectionTable::Schedule(const int descriptor,
+                               const uint64_t deadline_tick) {
+  deadlines_[descriptor] = deadline_tick;
+  slots_[deadline_tick % slots_.size()].insert(descriptor);
+}
+
+} // namespace port_handler
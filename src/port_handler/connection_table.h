@@ -0,0 +1,120 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace port_handler {
+
+/**
+ * @brief Table of live client connections with connection limit and idle timeout
+ * @details Idle deadlines are kept in a hashed timer wheel, so touching
+ * connection and expiring deadlines cost O(1) per connection. Expired
+ * connections are shut down, which wakes up their handler threads
+ */
+class ConnectionTable {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @param max_count Max number of simultaneous connections
+   * @param idle_timeout Time without activity after which connection is shut down
+   * @param tick Timer wheel granularity
+   */
+  ConnectionTable(std::size_t max_count, std::chrono::milliseconds idle_timeout,
+                  std::chrono::milliseconds tick = std::chrono::seconds(1));
+
+  ConnectionTable(const ConnectionTable &) = delete;
+  ConnectionTable &operator=(const ConnectionTable &) = delete;
+
+  /**
+   * @brief Add connection if limit isn't reached
+   *
+   * @param descriptor Descriptor of client socket
+   * @return true if connection was added
+   * @return false if there are already max_count connections
+   */
+  bool TryAdd(int descriptor);
+
+  /**
+   * @brief Remove connection. Must be called before socket is closed
+   *
+   * @param descriptor Descriptor of client socket
+   */
+  void Remove(int descriptor);
+
+  /**
+   * @brief Mark activity on connection and postpone its idle deadline
+   *
+   * @param descriptor Descriptor of client socket
+   */
+  void Touch(int descriptor);
+
+  /**
+   * @brief Shut down connections, which idle deadline has passed
+   */
+  void ShutdownIdle();
+
+  /**
+   * @brief Get number of live connections
+   *
+   * @return Number of connections
+   */
+  [[nodiscard]] std::size_t GetCount() const;
+
+ private:
+  const std::size_t max_count_; //!< Max number of connections
+  const std::chrono::milliseconds tick_; //!< Duration of one wheel slot
+  const uint64_t timeout_ticks_; //!< Idle timeout in ticks
+  const Clock::time_point start_time_; //!< Time of tick 0
+  //! Slots of timer wheel with descriptors, which deadline is in that slot
+  std::vector<std::unordered_set<int>> slots_;
+  //! Descriptor -> deadline tick
+  std::unordered_map<int, uint64_t> deadlines_;
+  uint64_t last_expired_tick_; //!< Last tick, which slot was expired
+  mutable std::mutex mutex_; //!< Mutex for all fields above
+
+  /**
+   * @brief Get current tick
+   *
+   * @return Number of ticks since start_time_
+   */
+  [[nodiscard]] uint64_t GetCurrentTick() const;
+
+  /**
+   * @brief Put connection in slot of given deadline
+   *
+   * @param descriptor Descriptor of client socket
+   * @param deadline_tick Tick, after which connection is idle
+   */
+  void Schedule(int descriptor, uint64_t deadline_tick);
+};
+
+} // namespace port_handler
@@ -0,0 +1,51 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <chrono>
+
+#include "sock/server_socket.h"
+
+namespace port_handler {
+
+/**
+ * @brief Options of PortHandler
+ */
+struct Options {
+  //! Number of listening sockets. If greater than 1, sockets are bound with
+  //! SO_REUSEPORT and kernel balances connections across them
+  std::size_t socket_count = 1;
+  //! Max length of pending connections queue of each socket
+  int backlog = sock::ServerSocket::kDefaultBacklog;
+  //! Max number of simultaneous clients. Extra clients get 503 response
+  std::size_t max_connections = 1024;
+  //! Time without complete request, after which client is disconnected
+  std::chrono::milliseconds idle_timeout = std::chrono::seconds(30);
+  //! Max time of one blocking read or write on client socket
+  std::chrono::milliseconds io_timeout = std::chrono::seconds(10);
+};
+
+} // namespace port_handler
@@ -26,12 +26,22 @@ SOFTWARE.
 
 #include "port_handler_base.h"
 
-#include <iostream>
-#include <vector>
+#include <chrono>
+#include <map>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string_view>
 
 #include "sock/exception.h"
+#include "http/body_stream.h"
+#include "types/shared_buffer.h"
+#include "logging/logger.h"
+#include "metrics/registry.h"
 #include "request_dispatcher.h"
+#include "connection_table.h"
+#include "options.h"
 
 namespace port_handler {
 
@@ -47,26 +57,83 @@ class PortHandler : public PortHandlerBase {
 
   /**
    * @param port Port to handle clients on
+   * @param options Listening and connection options
    */
-  explicit PortHandler(int port) :
-  socket_(sock::Type::kTcp, port),
+  explicit PortHandler(int port, const Options &options = Options()) :
+  options_(options),
+  sockets_(),
   request_dispatcher_(),
-  futures_() {
+  connections_(options.max_connections, options.idle_timeout),
+  futures_(),
+  next_connection_id_(0),
+  futures_mutex_(),
+  requests_counter_(metrics::Registry::GetInstance().GetCounter(
+      "requests_total", "Number of handled requests", BuildPortLabel(port))),
+  sent_bytes_counter_(metrics::Registry::GetInstance().GetCounter(
+      "sent_bytes_total", "Number of bytes sent to clients",
+      BuildPortLabel(port))),
+  rejected_connections_counter_(metrics::Registry::GetInstance().GetCounter(
+      "rejected_connections_total",
+      "Number of connections rejected because of connection limit",
+      BuildPortLabel(port))),
+  connections_gauge_(metrics::Registry::GetInstance().GetGauge(
+      "connections", "Number of active client connections",
+      BuildPortLabel(port))),
+  handler_threads_gauge_(metrics::Registry::GetInstance().GetGauge(
+      "handler_threads", "Number of client handling threads, including "
+      "finished but not yet joined ones", BuildPortLabel(port))),
+  request_latency_(metrics::Registry::GetInstance().GetHistogram(
+      "request_latency", "Time from request receiving to response sending",
+      BuildPortLabel(port))) {
+    const bool reuse_port = (options_.socket_count > 1);
+    for (std::size_t i = 0; i < options_.socket_count; ++i) {
+      sockets_.push_back(std::make_unique<sock::ServerSocket>(
+          sock::Type::kTcp, port, options_.backlog, reuse_port));
+    }
   }
 
   PortHandler(const PortHandler &other) = delete;
   PortHandler operator=(const PortHandler &other) = delete;
 
-  const sock::ServerSocket &GetSocket() const override {
-    return socket_;
+  std::size_t GetSocketCount() const override {
+    return sockets_.size();
+  }
+
+  const sock::ServerSocket &GetSocket(const std::size_t index) const override {
+    return *sockets_.at(index);
   }
 
-  void AcceptAndHandleClient() override {
-    sock::Socket client = socket_.Accept();
+  void AcceptAndHandleClient(const std::size_t index) override {
+    auto client_socket_ptr = std::make_unique<sock::Socket>(
+        sockets_.at(index)->Accept());
+    client_socket_ptr->SetTimeouts(options_.io_timeout, options_.io_timeout);
 
-    futures_.push_back(
+    if (!connections_.TryAdd(client_socket_ptr->GetDescriptor())) {
+      rejected_connections_counter_.Add();
+      RejectClient(*client_socket_ptr);
+      return;
+    }
+    connections_gauge_.Add(1);
+
+    std::lock_guard guard(futures_mutex_);
+    RemoveFinishedFutures();
+    futures_.emplace(
+        next_connection_id_++,
         std::async(std::launch::async, &PortHandler::HandleClient, this,
-                   std::make_unique<sock::Socket>(std::move(client))));
+                   std::move(client_socket_ptr)));
+    handler_threads_gauge_.Set(futures_.size());
+  }
+
+  void ReapConnections() override {
+    connections_.ShutdownIdle();
+
+    std::lock_guard guard(futures_mutex_);
+    RemoveFinishedFutures();
+    handler_threads_gauge_.Set(futures_.size());
+  }
+
+  std::size_t GetConnectionCount() const override {
+    return connections_.GetCount();
   }
 
   /**
@@ -81,9 +148,30 @@ class PortHandler : public PortHandlerBase {
   }
 
  private:
-  sock::ServerSocket socket_;
+  const Options options_;
+  std::vector<std::unique_ptr<sock::ServerSocket>> sockets_;
   RequestDispatcher<RequestType, ResponseType> request_dispatcher_;
-  std::vector<std::future<void>> futures_;
+  ConnectionTable connections_; //!< Live client connections
+  //! Connection id -> future of thread, that handles connection
+  std::map<uint64_t, std::future<void>> futures_;
+  uint64_t next_connection_id_; //!< Id for the next connection
+  std::mutex futures_mutex_; //!< Mutex for futures_ and next_connection_id_
+  metrics::Counter &requests_counter_;
+  metrics::Counter &sent_bytes_counter_;
+  metrics::Counter &rejected_connections_counter_;
+  metrics::Gauge &connections_gauge_;
+  metrics::Gauge &handler_threads_gauge_;
+  metrics::Histogram &request_latency_;
+
+  /**
+   * @brief Build metric labels for port
+   *
+   * @param port Port number
+   * @return Labels string
+   */
+  static std::string BuildPortLabel(const int port) {
+    return "port=\"" + std::to_string(port) + "\"";
+  }
 
   /**
    * @brief Handle client requests
@@ -91,28 +179,140 @@ class PortHandler : public PortHandlerBase {
    * @param client_socket_ptr Unique pointer to socket, associated with client
    */
   void HandleClient(std::unique_ptr<sock::Socket> client_socket_ptr) {
+    const int descriptor = client_socket_ptr->GetDescriptor();
+    uint64_t counted_sent_bytes = 0;
+    const std::string peer_name = client_socket_ptr->GetPeerName();
+
     try {
       for (;;) {
         RequestType request;
         (*client_socket_ptr) >> request;
-        std::cout << "\n" << request << "\n" << std::endl;
+        request.remote_address = peer_name;
+        const auto request_time = std::chrono::steady_clock::now();
+        connections_.Touch(descriptor);
+        LOG(kDebug) << "Request on socket " << descriptor << ":\n" << request;
 
         ResponseType response = request_dispatcher_.Dispatch(request);
-        (*client_socket_ptr) << response << std::endl;
+        SendResponse(*client_socket_ptr, response);
+        connections_.Touch(descriptor);
+        request_latency_.RecordDuration(std::chrono::steady_clock::now() -
+                                        request_time);
+        requests_counter_.Add();
+        const uint64_t sent_bytes = client_socket_ptr->GetSentByteCount();
+        sent_bytes_counter_.Add(sent_bytes - counted_sent_bytes);
+        counted_sent_bytes = sent_bytes;
         if (response.body.size() > 200) {
           response.body = "[Body skipped]";
         }
-        std::cout << "\n" << response << "\n" << std::endl;
+        LOG(kDebug) << "Response on socket " << descriptor << ":\n" << response;
+
+        if (response.body_stream_ptr) {
+          SendBodyStream(*client_socket_ptr, *response.body_stream_ptr,
+                         counted_sent_bytes);
+          LOG(kDebug) << "Stream on socket " << descriptor << " finished";
+          break;
+        }
       }
     } catch (const sock::ReadError &) {
-      std::cout << "Client on socket " << client_socket_ptr->GetDescriptor()
-                << " disconnected" << std::endl;
+      LOG(kDebug) << "Client on socket " << descriptor << " disconnected";
+    } catch (const sock::SendError &) {
+      LOG(kDebug) << "Client on socket " << descriptor
+                  << " disconnected while was waiting for response";
+    } catch (const std::runtime_error &ex) {
+      LOG(kWarning) << "Client on socket " << descriptor
+                    << " dropped: " << ex.what();
+    } catch (const std::exception &ex) {
+      // E.g. std::invalid_argument on malformed header value. Connection must
+      // be removed from the table anyway, so nothing escapes the handler
+      LOG(kError) << "Client on socket " << descriptor
+                  << " dropped because of unexpected error: " << ex.what();
+    } catch (...) {
+      LOG(kError) << "Client on socket " << descriptor
+                  << " dropped because of unknown error";
+    }
+
+    sent_bytes_counter_.Add(client_socket_ptr->GetSentByteCount() -
+                            counted_sent_bytes);
+
+    // Must be done before socket is closed, so descriptor can't be reused yet
+    connections_.Remove(descriptor);
+    connections_gauge_.Add(-1);
+    LOG(kDebug) << "Socket " << descriptor << " closed";
+  }
+
+  /**
+   * @brief Send response with shared and file bodies
+   * @details Head is held back while the rest follows, so small responses
+   * aren't split into several TCP segments
+   *
+   * @param client_socket Socket, associated with client
+   * @param response Response to send
+   */
+  static void SendResponse(sock::Socket &client_socket,
+                           const ResponseType &response) {
+    const types::SharedBuffer &body_buffer = response.body_buffer;
+    const bool has_file = static_cast<bool>(response.body_file_ptr);
+    std::ostringstream head;
+    head << response;
+    client_socket.Send(head.str(), !body_buffer.empty() || has_file);
+
+    if (!body_buffer.empty()) {
+      client_socket.Send(
+          std::string_view(reinterpret_cast<const char *>(body_buffer.data()),
+                           body_buffer.size()),
+          has_file);
+    }
+    if (has_file) {
+      client_socket.SendFile(response.body_file_ptr->GetDescriptor(),
+                             response.body_file_ptr->GetSize());
+    }
+  }
+
+  /**
+   * @brief Send streaming body until it's finished
+   * @details Every sent part postpones the idle deadline of connection
+   *
+   * @param client_socket Socket, associated with client
+   * @param body_stream Stream to send
+   * @param counted_sent_bytes Number of sent bytes already added to counter
+   */
+  void SendBodyStream(sock::Socket &client_socket, http::BodyStream &body_stream,
+                      uint64_t &counted_sent_bytes) {
+    const int descriptor = client_socket.GetDescriptor();
+    while (body_stream.SendNext(client_socket)) {
+      connections_.Touch(descriptor);
+      const uint64_t sent_bytes = client_socket.GetSentByteCount();
+      sent_bytes_counter_.Add(sent_bytes - counted_sent_bytes);
+      counted_sent_bytes = sent_bytes;
+    }
+  }
+
+  /**
+   * @brief Send 503 response to client, which exceeds connection limit
+   *
+   * @param client_socket Socket, associated with client
+   */
+  static void RejectClient(sock::Socket &client_socket) {
+    try {
+      client_socket << ResponseType(503, "Service Unavailable") << std::endl;
     } catch (const sock::SendError &) {
-      std::cout << "Client on socket " << client_socket_ptr->GetDescriptor()
-                << " disconnected while was waiting for response" << std::endl;
+      // Client is dropped anyway
+    }
+  }
+
+  /**
+   * @brief Release futures of finished client threads
+   * @details futures_mutex_ must be locked
+   */
+  void RemoveFinishedFutures() {
+    for (auto it = futures_.begin(); it != futures_.end();) {
+      if (it->second.wait_for(std::chrono::seconds(0)) ==
+          std::future_status::ready) {
+        it = futures_.erase(it);
+      } else {
+        ++it;
+      }
     }
-    std::cout << "Socket " << client_socket_ptr->GetDescriptor()
-              << " closed" << std::endl;
   }
 };
 
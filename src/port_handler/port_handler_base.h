@@ -24,6 +24,8 @@ SOFTWARE.
 
 #pragma once
 
+#include <cstddef>
+
 #include "sock/server_socket.h"
 
 namespace port_handler {
@@ -35,17 +37,42 @@ class PortHandlerBase {
  public:
   virtual ~PortHandlerBase() = default;
 
+  /**
+   * @brief Get number of listening sockets
+   *
+   * @return Number of sockets, that can be obtained with GetSocket()
+   */
+  [[nodiscard]] virtual std::size_t GetSocketCount() const = 0;
+
   /**
    * @brief Get socket object
    *
+   * @param index Index of listening socket, less than GetSocketCount()
    * @return ServerSocket, which is ready to accept clients
    */
-  [[nodiscard]] virtual const sock::ServerSocket &GetSocket() const = 0;
+  [[nodiscard]] virtual const sock::ServerSocket &GetSocket(
+      std::size_t index) const = 0;
 
   /**
    * @brief Accept client on socket from GetSocket() and handle it in separate thread
+   * @details Can be called from several threads with different indexes
+   *
+   * @param index Index of listening socket, less than GetSocketCount()
+   */
+  virtual void AcceptAndHandleClient(std::size_t index) = 0;
+
+  /**
+   * @brief Disconnect idle clients and release resources of finished ones
+   * @details Should be called periodically
+   */
+  virtual void ReapConnections() = 0;
+
+  /**
+   * @brief Get number of live client connections
+   *
+   * @return Number of connections
    */
-  virtual void AcceptAndHandleClient() = 0;
+  [[nodiscard]] virtual std::size_t GetConnectionCount() const = 0;
 };
 
 } // namespace port_handler
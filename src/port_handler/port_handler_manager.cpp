@@ -24,12 +24,24 @@ SOFTWARE.
 
 #include "port_handler_manager.h"
 
+#include <algorithm>
+#include <stdexcept>
+
+#include "logging/logger.h"
+
 namespace port_handler {
 
-PortHandlerManager::PortHandlerManager() :
+PortHandlerManager::PortHandlerManager(const std::size_t acceptor_count) :
+acceptor_count_(std::max<std::size_t>(acceptor_count, 1)),
 handlers_(),
-cached_fds_ptr_(nullptr),
-cached_fds_count_(0) {
+cached_poll_set_(),
+cached_handlers_count_(0),
+acceptors_(),
+acceptors_stop_(false) {
+}
+
+PortHandlerManager::~PortHandlerManager() {
+  StopAcceptors();
 }
 
 void PortHandlerManager::RegisterPortHandler(
@@ -38,29 +50,95 @@ void PortHandlerManager::RegisterPortHandler(
 }
 
 void PortHandlerManager::TryAcceptClients(const int timeout_ms) {
-  if (cached_fds_count_ != handlers_.size()) {
-    FillFds();
+  if (cached_handlers_count_ != handlers_.size()) {
+    cached_poll_set_ = BuildPollSet(0, 1);
+    cached_handlers_count_ = handlers_.size();
+  }
+
+  PollAndAccept(cached_poll_set_, timeout_ms);
+  ReapConnections();
+}
+
+void PortHandlerManager::StartAcceptors(const int timeout_ms) {
+  acceptors_stop_ = false;
+  for (std::size_t i = 0; i < acceptor_count_; ++i) {
+    acceptors_.emplace_back(&PortHandlerManager::AcceptorRoutine, this, i,
+                            timeout_ms);
+  }
+}
+
+void PortHandlerManager::StopAcceptors() {
+  acceptors_stop_ = true;
+  for (auto &acceptor : acceptors_) {
+    acceptor.join();
+  }
+  acceptors_.clear();
+}
+
+std::size_t PortHandlerManager::GetConnectionCount() const {
+  std::size_t count = 0;
+  for (const auto &handler_ptr : handlers_) {
+    count += handler_ptr->GetConnectionCount();
   }
 
-  int res = poll(cached_fds_ptr_.get(), cached_fds_count_, timeout_ms);
+  return count;
+}
+
+PortHandlerManager::PollSet PortHandlerManager::BuildPollSet(
+    const std::size_t acceptor_index, const std::size_t acceptor_count) const {
+  PollSet poll_set;
+  for (const auto &handler_ptr : handlers_) {
+    for (std::size_t i = 0; i < handler_ptr->GetSocketCount(); ++i) {
+      if (i % acceptor_count != acceptor_index) {
+        continue;
+      }
+
+      pollfd fd;
+      fd.fd = handler_ptr->GetSocket(i).GetDescriptor();
+      fd.events = POLLIN;
+      fd.revents = 0;
+      poll_set.fds.push_back(fd);
+      poll_set.listeners.emplace_back(handler_ptr.get(), i);
+    }
+  }
+
+  return poll_set;
+}
+
+void PortHandlerManager::PollAndAccept(PollSet &poll_set, const int timeout_ms) {
+  int res = poll(poll_set.fds.data(), poll_set.fds.size(), timeout_ms);
   if (res <= 0) {
     return;
   }
 
-  for (std::size_t i = 0; i < cached_fds_count_; ++i) {
-    if (cached_fds_ptr_[i].revents & POLLIN) {
-      cached_fds_ptr_[i].revents = 0;
-      handlers_[i]->AcceptAndHandleClient();
+  for (std::size_t i = 0; i < poll_set.fds.size(); ++i) {
+    if (poll_set.fds[i].revents & POLLIN) {
+      poll_set.fds[i].revents = 0;
+      auto [handler_ptr, socket_index] = poll_set.listeners[i];
+      handler_ptr->AcceptAndHandleClient(socket_index);
+    }
+  }
+}
+
+void PortHandlerManager::AcceptorRoutine(const std::size_t acceptor_index,
+                                         const int timeout_ms) {
+  PollSet poll_set = BuildPollSet(acceptor_index, acceptor_count_);
+
+  while (!acceptors_stop_) {
+    try {
+      PollAndAccept(poll_set, timeout_ms);
+      if (acceptor_index == 0) {
+        ReapConnections();
+      }
+    } catch (std::runtime_error &ex) {
+      LOG(kWarning) << ex.what();
     }
   }
 }
 
-void PortHandlerManager::FillFds() {
-  cached_fds_count_ = handlers_.size();
-  cached_fds_ptr_ = std::make_unique<pollfd[]>(cached_fds_count_);
-  for (std::size_t i = 0; i < cached_fds_count_; ++i) {
-    cached_fds_ptr_[i].fd = handlers_[i]->GetSocket().GetDescriptor();
-    cached_fds_ptr_[i].events = POLLIN;
+void PortHandlerManager::ReapConnections() {
+  for (const auto &handler_ptr : handlers_) {
+    handler_ptr->ReapConnections();
   }
 }
 
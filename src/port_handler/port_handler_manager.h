@@ -30,20 +30,37 @@ SOFTWARE.
 
 #include <vector>
 #include <memory>
+#include <thread>
+#include <atomic>
+#include <utility>
 
 namespace port_handler {
 
 /**
  * @brief Class, that can accept clients on several port handlers
+ * @details Clients can be accepted either on the calling thread with
+ * TryAcceptClients() or on dedicated acceptor threads with StartAcceptors()
  */
 class PortHandlerManager {
  public:
   using PortHandlerBasePtr = std::unique_ptr<PortHandlerBase>;
 
-  PortHandlerManager();
+  /**
+   * @param acceptor_count Number of acceptor threads, started by StartAcceptors()
+   */
+  explicit PortHandlerManager(std::size_t acceptor_count = 1);
+
+  /**
+   * @brief Stops acceptor threads if they are running
+   */
+  ~PortHandlerManager();
+
+  PortHandlerManager(const PortHandlerManager &) = delete;
+  PortHandlerManager &operator=(const PortHandlerManager &) = delete;
 
   /**
    * @brief Register port handler
+   * @details Must not be called while acceptor threads are running
    *
    * @param handler_ptr Pointer to PortHandlerBase inheritor
    */
@@ -51,21 +68,81 @@ class PortHandlerManager {
 
   /**
    * @brief Try to accept clients on any of port handlers and handle it in separate thread
-   * @details Calls poll() system call
+   * @details Calls poll() system call. Also reaps connections of all handlers
    *
    * @param timeout_ms Timeout to try
    */
   void TryAcceptClients(int timeout_ms);
 
+  /**
+   * @brief Start acceptor threads
+   * @details Acceptor i polls every listening socket with index j, where
+   * j % acceptor_count == i, so each socket is owned by exactly one thread.
+   * Acceptor 0 also reaps connections of all handlers after every poll
+   *
+   * @param timeout_ms Poll timeout, after which acceptor checks if it should stop
+   */
+  void StartAcceptors(int timeout_ms);
+
+  /**
+   * @brief Stop and join acceptor threads
+   */
+  void StopAcceptors();
+
+  /**
+   * @brief Get number of live client connections on all port handlers
+   *
+   * @return Number of connections
+   */
+  [[nodiscard]] std::size_t GetConnectionCount() const;
+
  private:
+  /**
+   * @brief Set of listening sockets to poll
+   */
+  struct PollSet {
+    std::vector<pollfd> fds; //!< Fds for poll()
+    //! Handler and socket index for every fd
+    std::vector<std::pair<PortHandlerBase *, std::size_t>> listeners;
+  };
+
+  const std::size_t acceptor_count_; //!< Number of acceptor threads
   std::vector<PortHandlerBasePtr> handlers_; //!< Collection of registered handlers
-  std::unique_ptr<pollfd[]> cached_fds_ptr_; //!< Cached fds for poll()
-  std::size_t cached_fds_count_; //!< Size of cached fds
+  PollSet cached_poll_set_; //!< Cached poll set for TryAcceptClients()
+  std::size_t cached_handlers_count_; //!< Number of handlers in cached poll set
+  std::vector<std::thread> acceptors_; //!< Acceptor threads
+  std::atomic<bool> acceptors_stop_; //!< True, if acceptors should stop
+
+  /**
+   * @brief Build poll set with sockets owned by given acceptor
+   *
+   * @param acceptor_index Index of acceptor
+   * @param acceptor_count Total number of acceptors
+   * @return Poll set
+   */
+  PollSet BuildPollSet(std::size_t acceptor_index,
+                       std::size_t acceptor_count) const;
+
+  /**
+   * @brief Poll sockets and accept clients on the ready ones
+   *
+   * @param poll_set Sockets to poll
+   * @param timeout_ms Poll timeout
+   */
+  static void PollAndAccept(PollSet &poll_set, int timeout_ms);
+
+  /**
+   * @brief Acceptor thread routine
+   *
+   * @param acceptor_index Index of acceptor
+   * @param timeout_ms Poll timeout
+   */
+  void AcceptorRoutine(std::size_t acceptor_index, int timeout_ms);
 
   /**
-   * @brief Fill cached fds with handlers sockets
+   * @brief Reap connections of all handlers
    */
-  void FillFds();
+  void ReapConnections();
 };
 
 } // namespace port_handler
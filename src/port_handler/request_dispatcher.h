@@ -118,9 +118,10 @@ class RequestDispatcher {
       return it;
     }
 
-    if (it != url_to_servlet_.begin()) {
+    // Prefixes of path are sorted by length, so the nearest one is the longest
+    while (it != url_to_servlet_.begin()) {
       --it;
-      if (path.find(it->first) == 0) {
+      if (path.compare(0, it->first.size(), it->first) == 0) {
         return it;
       }
     }
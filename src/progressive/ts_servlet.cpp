@@ -0,0 +1,176 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ts_servlet.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string_view>
+
+namespace progressive {
+
+TsServlet::TsServlet(const std::size_t queue_size,
+                     const std::size_t max_gop_size,
+                     const std::chrono::milliseconds fragment_timeout):
+queue_size_(queue_size),
+max_gop_size_(max_gop_size),
+fragment_timeout_(fragment_timeout),
+gop_cache_(),
+viewers_(),
+viewers_mutex_(),
+viewers_gauge_(metrics::Registry::GetInstance().GetGauge(
+    "ts_stream_viewers", "Number of connected MPEG2-TS stream viewers")),
+dropped_fragments_counter_(metrics::Registry::GetInstance().GetCounter(
+    "ts_stream_dropped_fragments_total", "Number of frames not sent to "
+    "MPEG2-TS stream viewers, because they were slower than the source")) {
+}
+
+http::Response TsServlet::Handle(const http::Request &request) {
+  if (request.method != http::Method::kGet) {
+    return {501, "Not Implemented"};
+  }
+  if (!request.url.empty()) {
+    return {404, "Not Found"};
+  }
+
+  auto viewer_ptr = std::make_shared<Viewer>(
+      queue_size_, fragment_timeout_, viewers_gauge_,
+      dropped_fragments_counter_);
+  {
+    std::lock_guard guard(viewers_mutex_);
+    for (const auto &fragment_ptr : gop_cache_) {
+      viewer_ptr->Push(fragment_ptr);
+    }
+    viewers_.push_back(viewer_ptr);
+  }
+
+  http::Response response(200, "OK");
+  response.version = 1.1;
+  response.headers["Content-Type"] = "video/mp2t";
+  response.headers["Transfer-Encoding"] = "chunked";
+  response.headers["Cache-Control"] = "no-cache";
+  response.headers["Connection"] = "close";
+  response.body_stream_ptr = std::move(viewer_ptr);
+
+  return response;
+}
+
+void TsServlet::ClearCache() {
+  std::lock_guard guard(viewers_mutex_);
+  gop_cache_.clear();
+}
+
+void TsServlet::Receive(DataPtr fragment_ptr) {
+  std::lock_guard guard(viewers_mutex_);
+  if (fragment_ptr->key_frame) {
+    gop_cache_.clear();
+  }
+  if (!gop_cache_.empty() || fragment_ptr->key_frame) {
+    gop_cache_.push_back(fragment_ptr);
+  }
+  // Too long GOP isn't worth sending to new viewers
+  if (gop_cache_.size() > max_gop_size_) {
+    gop_cache_.clear();
+  }
+
+  auto it = std::remove_if(viewers_.begin(), viewers_.end(),
+                           [&fragment_ptr] (const std::weak_ptr<Viewer> &weak_ptr) {
+                             auto viewer_ptr = weak_ptr.lock();
+                             if (!viewer_ptr) {
+                               return true;
+                             }
+                             viewer_ptr->Push(fragment_ptr);
+                             return false;
+                           });
+  viewers_.erase(it, viewers_.end());
+}
+
+TsServlet::Viewer::Viewer(const std::size_t queue_size,
+                          const std::chrono::milliseconds fragment_timeout,
+                          metrics::Gauge &viewers_gauge,
+                          metrics::Counter &dropped_fragments_counter):
+queue_size_(queue_size),
+fragment_timeout_(fragment_timeout),
+queue_(),
+waiting_for_key_frame_(true),
+queue_mutex_(),
+queue_cv_(),
+viewers_gauge_(viewers_gauge),
+dropped_fragments_counter_(dropped_fragments_counter) {
+  viewers_gauge_.Add(1);
+}
+
+TsServlet::Viewer::~Viewer() {
+  viewers_gauge_.Add(-1);
+}
+
+void TsServlet::Viewer::Push(DataPtr fragment_ptr) {
+  {
+    std::lock_guard guard(queue_mutex_);
+    if (queue_.size() >= queue_size_) {
+      dropped_fragments_counter_.Add(queue_.size());
+      queue_.clear();
+      waiting_for_key_frame_ = true;
+    }
+    if (waiting_for_key_frame_ && !fragment_ptr->key_frame) {
+      dropped_fragments_counter_.Add();
+      return;
+    }
+    waiting_for_key_frame_ = false;
+    queue_.push_back(std::move(fragment_ptr));
+  }
+  queue_cv_.notify_one();
+}
+
+bool TsServlet::Viewer::SendNext(sock::Socket &socket) {
+  std::deque<DataPtr> fragments;
+  {
+    std::unique_lock lock(queue_mutex_);
+    if (!queue_cv_.wait_for(lock, fragment_timeout_,
+                            [this] { return !queue_.empty(); })) {
+      lock.unlock();
+      socket.Send("0\r\n\r\n"); // Last chunk
+      return false;
+    }
+    fragments.swap(queue_);
+  }
+
+  // Every fragment is one HTTP chunk. All but the last are held in kernel, so
+  // the queue is sent with full TCP segments
+  for (std::size_t i = 0; i < fragments.size(); ++i) {
+    const types::SharedBuffer &data = fragments[i]->data;
+    const bool more = (i + 1 < fragments.size());
+    std::ostringstream oss;
+    oss << std::hex << data.size() << "\r\n";
+    socket.Send(oss.str(), true);
+    socket.Send(std::string_view(reinterpret_cast<const char *>(data.data()),
+                                 data.size()),
+                true);
+    socket.Send("\r\n", more);
+  }
+
+  return true;
+}
+
+} // namespace progressive
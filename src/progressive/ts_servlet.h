@@ -0,0 +1,134 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "servlet.h"
+#include "http/request.h"
+#include "http/response.h"
+#include "http/body_stream.h"
+#include "observer.h"
+#include "types/mpeg2ts_fragment.h"
+#include "metrics/registry.h"
+
+namespace progressive {
+
+/**
+ * @brief Servlet, that sends continuous MPEG2-TS stream with chunked transfer
+ * @details Fragments since the last key frame are cached, so a new viewer
+ * starts from a key frame at once. Every viewer has a bounded queue. If it's
+ * full, queued fragments are dropped and the viewer waits for the next key
+ * frame, so a slow viewer neither holds back others nor grows memory
+ */
+class TsServlet : public Servlet<http::Request, http::Response>,
+                  public Observer<types::Mpeg2TsFragment> {
+ public:
+  /**
+   * @param queue_size Max number of fragments queued for one viewer
+   * @param max_gop_size Max number of cached fragments. Cache is dropped if
+   * key frame doesn't come within that number
+   * @param fragment_timeout Max time to wait for a fragment before viewer
+   * stream is finished
+   */
+  TsServlet(std::size_t queue_size, std::size_t max_gop_size,
+            std::chrono::milliseconds fragment_timeout);
+
+  [[nodiscard]] http::Response Handle(const http::Request &request) override;
+
+  /**
+   * @param fragment_ptr Fragment of the stream. Shared with all viewers
+   */
+  void Receive(DataPtr fragment_ptr) override;
+
+  /**
+   * @brief Drop cached GOP, so new viewers don't start from stale frames after
+   * ingest is stopped
+   */
+  void ClearCache();
+
+ private:
+  class Viewer;
+
+  const std::size_t queue_size_;
+  const std::size_t max_gop_size_;
+  const std::chrono::milliseconds fragment_timeout_;
+  //! Fragments since the last key frame. Empty if there was no key frame yet
+  std::vector<DataPtr> gop_cache_;
+  //! Viewers are owned by their connections and expire on disconnect
+  std::vector<std::weak_ptr<Viewer>> viewers_;
+  std::mutex viewers_mutex_; //!< Mutex for gop_cache_ and viewers_
+  metrics::Gauge &viewers_gauge_;
+  metrics::Counter &dropped_fragments_counter_;
+};
+
+/**
+ * @brief Stream of one viewer with bounded queue of fragments
+ */
+class TsServlet::Viewer : public http::BodyStream {
+ public:
+  /**
+   * @param queue_size Max number of queued fragments
+   * @param fragment_timeout Max time to wait for a fragment
+   * @param viewers_gauge Gauge of viewer count
+   * @param dropped_fragments_counter Counter of fragments not sent to viewer
+   */
+  Viewer(std::size_t queue_size, std::chrono::milliseconds fragment_timeout,
+         metrics::Gauge &viewers_gauge,
+         metrics::Counter &dropped_fragments_counter);
+
+  ~Viewer() override;
+
+  Viewer(const Viewer &) = delete;
+  Viewer &operator=(const Viewer &) = delete;
+
+  /**
+   * @brief Queue fragment. If queue is full, drop it with all fragments until
+   * the next key frame
+   *
+   * @param fragment_ptr Fragment of the stream
+   */
+  void Push(DataPtr fragment_ptr);
+
+  bool SendNext(sock::Socket &socket) override;
+
+ private:
+  const std::size_t queue_size_;
+  const std::chrono::milliseconds fragment_timeout_;
+  std::deque<DataPtr> queue_; //!< Fragments to send
+  //! True, if fragments are dropped until the next key frame
+  bool waiting_for_key_frame_;
+  std::mutex queue_mutex_; //!< Mutex for queue_ and waiting_for_key_frame_
+  std::condition_variable queue_cv_; //!< Notified on new fragment
+  metrics::Gauge &viewers_gauge_;
+  metrics::Counter &dropped_fragments_counter_;
+};
+
+} // namespace progressive
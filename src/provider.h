@@ -24,7 +24,10 @@ SOFTWARE.
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "observer.h"
@@ -39,28 +42,78 @@ class Provider {
  public:
   using SameDataObserver = Observer<Data>;
 
+  Provider() :
+  observers_ptr_(std::make_shared<const ObserverList>()),
+  observers_mutex_() {
+  }
+
   virtual ~Provider() = default;
 
   /**
-   * @brief Add new observer
+   * @brief Add new observer. Can be called while data is being provided
    * @param observer_ptr Pointer to observer to be added
    */
   void AddObserver(std::shared_ptr<SameDataObserver> observer_ptr) {
-    observers_.push_back(observer_ptr);
+    std::lock_guard guard(observers_mutex_);
+    auto new_observers_ptr = std::make_shared<ObserverList>(*observers_ptr_);
+    new_observers_ptr->push_back(std::move(observer_ptr));
+    std::atomic_store(&observers_ptr_, ObserverListPtr(new_observers_ptr));
+  }
+
+  /**
+   * @brief Remove observer. Can be called while data is being provided
+   * @details Observer still can receive data that is being provided right now
+   *
+   * @param observer_ptr Pointer to observer to be removed
+   * @return True, if observer was found and removed, else - false
+   */
+  bool RemoveObserver(const std::shared_ptr<SameDataObserver> &observer_ptr) {
+    std::lock_guard guard(observers_mutex_);
+    auto new_observers_ptr = std::make_shared<ObserverList>(*observers_ptr_);
+    auto it = std::find(new_observers_ptr->begin(), new_observers_ptr->end(),
+                        observer_ptr);
+    if (it == new_observers_ptr->end()) {
+      return false;
+    }
+
+    new_observers_ptr->erase(it);
+    std::atomic_store(&observers_ptr_, ObserverListPtr(new_observers_ptr));
+    return true;
   }
 
  protected:
   /**
    * @brief Notify all observers
-   * @param data Data to send to observers
+   * @details Every observer gets the same immutable data, so fan-out to N
+   * observers costs N reference count increments instead of N copies.
+   * Observer list is copy-on-write: a snapshot is taken once per call, so
+   * observers are called without holding observers_mutex_
+   *
+   * @param data_ptr Data to send to observers
    */
-  void ProvideToAll(const Data &data) {
-    for (auto observer_ptr : observers_) {
-      observer_ptr->Receive(data);
+  void ProvideToAll(std::shared_ptr<const Data> data_ptr) {
+    const ObserverListPtr observers_ptr = std::atomic_load(&observers_ptr_);
+    for (const auto &observer_ptr : *observers_ptr) {
+      observer_ptr->Receive(data_ptr);
     }
   }
 
+  /**
+   * @brief Move data to the shared storage and notify all observers
+   *
+   * @param data Data to send to observers
+   */
+  void ProvideToAll(Data &&data) {
+    ProvideToAll(std::make_shared<const Data>(std::move(data)));
+  }
+
  private:
-  //! Vector of all observers
-  std::vector<std::shared_ptr<SameDataObserver>> observers_;
+  using ObserverList = std::vector<std::shared_ptr<SameDataObserver>>;
+  using ObserverListPtr = std::shared_ptr<const ObserverList>;
+
+  //! Snapshot of all observers. Copied and replaced on every change, never
+  //! modified. Accessed with std::atomic_load/store, which may lock internally
+  ObserverListPtr observers_ptr_;
+  //! Serializes writers of observers_ptr_
+  std::mutex observers_mutex_;
 };
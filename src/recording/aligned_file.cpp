@@ -0,0 +1,192 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "aligned_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include "logging/logger.h"
+
+namespace recording {
+
+AlignedFile::AlignedFile(const std::string &path, const std::size_t block_size,
+                         const std::size_t preallocate_size,
+                         const bool direct_io) :
+path_(path),
+block_size_(block_size),
+preallocate_size_(preallocate_size),
+descriptor_(-1),
+direct_io_(false),
+buffer_ptr_(),
+buffered_size_(0),
+written_size_(0),
+allocated_size_(0) {
+  if ((block_size_ == 0) || (block_size_ % kAlignment != 0)) {
+    throw std::invalid_argument("Block size must be multiple of " +
+                                std::to_string(kAlignment));
+  }
+
+  void *buffer = nullptr;
+  if (posix_memalign(&buffer, kAlignment, block_size_) != 0) {
+    throw std::runtime_error("Can't allocate write buffer");
+  }
+  buffer_ptr_.reset(static_cast<types::Byte *>(buffer));
+
+  descriptor_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                     0644);
+  if (descriptor_ < 0) {
+    throw std::runtime_error("Can't create " + path_ + ": " + strerror(errno));
+  }
+
+  // Flag is set after creation, as some file systems (e.g. tmpfs) reject it
+  if (direct_io) {
+    const int flags = fcntl(descriptor_, F_GETFL);
+    if ((flags >= 0) && (fcntl(descriptor_, F_SETFL, flags | O_DIRECT) == 0)) {
+      direct_io_ = true;
+    } else {
+      LOG(kWarning) << "Direct I/O isn't supported for " << path_ << ": "
+                    << strerror(errno);
+    }
+  }
+}
+
+AlignedFile::~AlignedFile() {
+  try {
+    Close();
+  } catch (const std::exception &ex) {
+    LOG(kError) << ex.what();
+  }
+}
+
+std::size_t AlignedFile::Append(const types::Byte *data,
+                                const std::size_t size) {
+  std::size_t written = 0;
+  std::size_t offset = 0;
+  while (offset < size) {
+    const std::size_t part_size = std::min(size - offset,
+                                           block_size_ - buffered_size_);
+    memcpy(buffer_ptr_.get() + buffered_size_, data + offset, part_size);
+    buffered_size_ += part_size;
+    offset += part_size;
+
+    if (buffered_size_ == block_size_) {
+      WriteBuffer(block_size_);
+      written += block_size_;
+    }
+  }
+
+  return written;
+}
+
+std::size_t AlignedFile::Close() {
+  if (descriptor_ < 0) {
+    return 0;
+  }
+
+  const std::size_t written = buffered_size_;
+  try {
+    if (buffered_size_ > 0) {
+      // The last block is partial, so it can't be written directly
+      if (direct_io_) {
+        fcntl(descriptor_, F_SETFL, fcntl(descriptor_, F_GETFL) & ~O_DIRECT);
+        direct_io_ = false;
+      }
+      WriteBuffer(buffered_size_);
+    }
+  } catch (const std::runtime_error &) {
+    close(descriptor_);
+    descriptor_ = -1;
+    throw;
+  }
+
+  // Space after the end of file stays allocated until file is truncated
+  if ((allocated_size_ > written_size_) &&
+      (ftruncate(descriptor_, written_size_) < 0)) {
+    LOG(kDebug) << "Can't release preallocated space of " << path_ << ": "
+                << strerror(errno);
+  }
+  close(descriptor_);
+  descriptor_ = -1;
+
+  return written;
+}
+
+uint64_t AlignedFile::GetSize() const {
+  return written_size_ + buffered_size_;
+}
+
+uint64_t AlignedFile::GetWrittenSize() const {
+  return written_size_;
+}
+
+void AlignedFile::BufferDeleter::operator()(types::Byte *buffer) const {
+  free(buffer);
+}
+
+void AlignedFile::WriteBuffer(const std::size_t size) {
+  Preallocate();
+
+  std::size_t written = 0;
+  while (written < size) {
+    ssize_t res = write(descriptor_, buffer_ptr_.get() + written,
+                        size - written);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error("Can't write " + path_ + ": " +
+                               strerror(errno));
+    }
+    written += res;
+  }
+
+  written_size_ += size;
+  buffered_size_ = 0;
+}
+
+void AlignedFile::Preallocate() {
+  if ((preallocate_size_ == 0) ||
+      (written_size_ + block_size_ <= allocated_size_)) {
+    return;
+  }
+
+  // File size isn't changed, so readers see only written data
+  const std::size_t size = std::max(preallocate_size_, block_size_);
+  if (fallocate(descriptor_, FALLOC_FL_KEEP_SIZE, allocated_size_, size) < 0) {
+    LOG(kDebug) << "Can't preallocate space for " << path_ << ": "
+                << strerror(errno);
+    preallocate_size_ = 0;
+    return;
+  }
+  allocated_size_ += size;
+}
+
+} // namespace recording
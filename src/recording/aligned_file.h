@@ -0,0 +1,127 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "types/byte.h"
+
+namespace recording {
+
+/**
+ * @brief File, that is written sequentially with large aligned blocks
+ * @details Data is gathered in an aligned buffer and written only by full
+ * blocks, so the disk sees few large writes. With direct I/O the page cache is
+ * bypassed. Space is preallocated ahead of writes to keep the file contiguous.
+ * The file format isn't known to the class, so any container can be written
+ */
+class AlignedFile {
+ public:
+  //! Alignment of buffer, file offsets and block size required by direct I/O
+  static constexpr std::size_t kAlignment = 4096;
+
+  /**
+   * @throw std::runtime_error if can't create file
+   * @throw std::invalid_argument if block size isn't multiple of kAlignment
+   *
+   * @param path Path of the new file. Existing file is never overwritten
+   * @param block_size Size of one disk write
+   * @param preallocate_size Size of space allocated at once. 0 to disable
+   * @param direct_io Bypass page cache. Falls back to buffered I/O, if file
+   * system doesn't support it
+   */
+  AlignedFile(const std::string &path, std::size_t block_size,
+              std::size_t preallocate_size, bool direct_io);
+
+  /**
+   * @brief Write buffered data and close file. Errors are only logged
+   */
+  ~AlignedFile();
+
+  AlignedFile(const AlignedFile &) = delete;
+  AlignedFile &operator=(const AlignedFile &) = delete;
+
+  /**
+   * @brief Append data to file. Only full blocks are written at once
+   * @throw std::runtime_error if write failed
+   *
+   * @param data Data to append
+   * @param size Size of data
+   * @return Number of bytes written to disk
+   */
+  std::size_t Append(const types::Byte *data, std::size_t size);
+
+  /**
+   * @brief Write buffered data, release unused preallocated space and close file
+   * @throw std::runtime_error if write failed
+   *
+   * @return Number of bytes written to disk
+   */
+  std::size_t Close();
+
+  /**
+   * @return Size of appended data including buffered one
+   */
+  [[nodiscard]] uint64_t GetSize() const;
+
+  /**
+   * @return Size of data, that is already written to disk
+   */
+  [[nodiscard]] uint64_t GetWrittenSize() const;
+
+ private:
+  //! Frees aligned buffer
+  struct BufferDeleter {
+    void operator()(types::Byte *buffer) const;
+  };
+
+  const std::string path_;
+  const std::size_t block_size_;
+  std::size_t preallocate_size_; //!< 0 if preallocation is unsupported
+  int descriptor_;
+  bool direct_io_;
+  std::unique_ptr<types::Byte, BufferDeleter> buffer_ptr_;
+  std::size_t buffered_size_; //!< Size of data in buffer
+  uint64_t written_size_; //!< Size of data written to disk
+  uint64_t allocated_size_; //!< Size of preallocated space
+
+  /**
+   * @brief Write whole buffer at the end of file
+   * @throw std::runtime_error if write failed
+   *
+   * @param size Size of data to write. Must be multiple of kAlignment while
+   * direct I/O is used
+   */
+  void WriteBuffer(std::size_t size);
+
+  /**
+   * @brief Preallocate space, so at least the next block fits in it
+   */
+  void Preallocate();
+};
+
+} // namespace recording
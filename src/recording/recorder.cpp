@@ -0,0 +1,245 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "recorder.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+#include "logging/logger.h"
+
+namespace {
+
+/**
+ * @brief Append text to file
+ * @throw std::runtime_error if write failed
+ *
+ * @param path Path of file. Created if doesn't exist
+ * @param text Text to append
+ */
+void AppendToFile(const std::string &path, const std::string &text) {
+  int descriptor = open(path.c_str(),
+                        O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (descriptor < 0) {
+    throw std::runtime_error("Can't open " + path + ": " + strerror(errno));
+  }
+
+  std::size_t written = 0;
+  while (written < text.size()) {
+    ssize_t res = write(descriptor, text.data() + written,
+                        text.size() - written);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      close(descriptor);
+      throw std::runtime_error("Can't write " + path + ": " + strerror(errno));
+    }
+    written += res;
+  }
+  close(descriptor);
+}
+
+} // namespace
+
+namespace recording {
+
+Recorder::Recorder(RecorderOptions options):
+options_(std::move(options)),
+queue_(),
+stop_(false),
+queue_mutex_(),
+queue_condition_(),
+file_ptr_(),
+index_path_(),
+file_start_time_(),
+pending_index_lines_(),
+written_bytes_(metrics::Registry::GetInstance().GetCounter(
+    "recording_written_bytes_total", "Total size of data written to disk by "
+    "recorder", "stream=\"" + options_.stream_name + "\"")),
+recorded_chunks_(metrics::Registry::GetInstance().GetCounter(
+    "recording_chunks_total", "Number of recorded chunks",
+    "stream=\"" + options_.stream_name + "\"")),
+dropped_chunks_(metrics::Registry::GetInstance().GetCounter(
+    "recording_dropped_chunks_total", "Number of chunks dropped because of "
+    "full write queue", "stream=\"" + options_.stream_name + "\"")),
+errors_(metrics::Registry::GetInstance().GetCounter(
+    "recording_errors_total", "Number of failed writes",
+    "stream=\"" + options_.stream_name + "\"")),
+write_duration_(metrics::Registry::GetInstance().GetHistogram(
+    "recording_write_duration", "Duration of writing one chunk",
+    "stream=\"" + options_.stream_name + "\"")),
+writer_() {
+  if ((mkdir(options_.directory.c_str(), 0755) < 0) && (errno != EEXIST)) {
+    throw std::runtime_error("Can't create directory " + options_.directory +
+                             ": " + strerror(errno));
+  }
+  writer_ = std::thread(&Recorder::WriterRoutine, this);
+}
+
+Recorder::~Recorder() {
+  {
+    std::lock_guard guard(queue_mutex_);
+    stop_ = true;
+  }
+  queue_condition_.notify_one();
+  writer_.join();
+}
+
+void Recorder::Receive(DataPtr chunk_ptr) {
+  // Ingest time is monotonic, so it's converted to wall time for index
+  const types::Timestamp now = types::Clock::now();
+  const types::Timestamp last_frame_time =
+      (chunk_ptr->ingest_time == types::Timestamp()) ? now :
+                                                       chunk_ptr->ingest_time;
+  const WallClock::time_point start_time =
+      WallClock::now() -
+      std::chrono::duration_cast<WallClock::duration>(
+          (now - last_frame_time) +
+          std::chrono::duration<float>(chunk_ptr->duration));
+
+  {
+    std::lock_guard guard(queue_mutex_);
+    if (queue_.size() >= options_.queue_size) {
+      dropped_chunks_.Add();
+      LOG(kWarning) << "Recorder: Chunk " << chunk_ptr->media_sequence_number
+                    << " is dropped, disk is too slow";
+      return;
+    }
+    queue_.push_back({std::move(chunk_ptr), start_time});
+  }
+  queue_condition_.notify_one();
+}
+
+void Recorder::WriterRoutine() {
+  std::unique_lock lock(queue_mutex_);
+  while (true) {
+    queue_condition_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      break;
+    }
+
+    QueuedChunk queued_chunk = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    try {
+      Write(queued_chunk);
+      recorded_chunks_.Add();
+    } catch (const std::exception &ex) {
+      // The next chunk is written to a new file
+      errors_.Add();
+      LOG(kError) << "Recorder: " << ex.what();
+      file_ptr_.reset();
+      pending_index_lines_.clear();
+    }
+    lock.lock();
+  }
+  lock.unlock();
+
+  try {
+    CloseFile();
+  } catch (const std::exception &ex) {
+    errors_.Add();
+    LOG(kError) << "Recorder: " << ex.what();
+  }
+}
+
+void Recorder::Write(const QueuedChunk &queued_chunk) {
+  metrics::ScopedTimer timer(write_duration_);
+  if (file_ptr_ &&
+      (queued_chunk.start_time - file_start_time_ >= options_.file_duration)) {
+    CloseFile();
+  }
+  if (!file_ptr_) {
+    OpenFile(queued_chunk.start_time);
+  }
+
+  const types::Mpeg2TsChunk &chunk = *queued_chunk.chunk_ptr;
+  const uint64_t offset = file_ptr_->GetSize();
+  const auto start_time_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          queued_chunk.start_time.time_since_epoch()).count();
+  pending_index_lines_.emplace_back(
+      offset + chunk.data.size(),
+      std::to_string(start_time_ms) + " " + std::to_string(offset) + " " +
+      std::to_string(chunk.data.size()) + " " +
+      std::to_string(chunk.duration) + " " +
+      std::to_string(chunk.media_sequence_number) + "\n");
+
+  written_bytes_.Add(file_ptr_->Append(chunk.data.data(), chunk.data.size()));
+  WriteIndexLines(file_ptr_->GetWrittenSize());
+}
+
+void Recorder::OpenFile(const WallClock::time_point start_time) {
+  const std::string base_path = BuildBasePath(start_time);
+  file_ptr_ = std::make_unique<AlignedFile>(base_path + ".ts",
+                                            options_.write_size,
+                                            options_.preallocate_size,
+                                            options_.direct_io);
+  index_path_ = base_path + ".idx";
+  file_start_time_ = start_time;
+  LOG(kInfo) << "Recorder: Started " << base_path << ".ts";
+}
+
+void Recorder::CloseFile() {
+  if (!file_ptr_) {
+    return;
+  }
+
+  written_bytes_.Add(file_ptr_->Close());
+  WriteIndexLines(file_ptr_->GetWrittenSize());
+  file_ptr_.reset();
+}
+
+void Recorder::WriteIndexLines(const uint64_t written_size) {
+  std::string text;
+  while (!pending_index_lines_.empty() &&
+         (pending_index_lines_.front().first <= written_size)) {
+    text += pending_index_lines_.front().second;
+    pending_index_lines_.pop_front();
+  }
+
+  if (!text.empty()) {
+    AppendToFile(index_path_, text);
+  }
+}
+
+std::string Recorder::BuildBasePath(
+    const WallClock::time_point start_time) const {
+  const std::time_t time = WallClock::to_time_t(start_time);
+  std::tm tm{};
+  gmtime_r(&time, &tm);
+  char time_string[32];
+  strftime(time_string, sizeof(time_string), "%Y%m%dT%H%M%SZ", &tm);
+
+  return options_.directory + "/" + options_.stream_name + "-" + time_string;
+}
+
+} // namespace recording
@@ -0,0 +1,165 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "observer.h"
+#include "types/mpeg2ts_chunk.h"
+#include "aligned_file.h"
+#include "metrics/registry.h"
+
+namespace recording {
+
+/**
+ * @brief Options of stream recording
+ */
+struct RecorderOptions {
+  std::string directory; //!< Directory for recordings. Created if missing
+  //! Name of the stream. Used as file name prefix and metric label
+  std::string stream_name = "stream";
+  //! Duration of media in one file, after which the next file is started
+  std::chrono::seconds file_duration{600};
+  std::size_t write_size = 1 << 20; //!< Size of one disk write
+  std::size_t preallocate_size = 64 << 20; //!< 0 to disable preallocation
+  bool direct_io = false; //!< Bypass page cache
+  //! Max number of chunks waiting for write. New chunks are dropped beyond it
+  std::size_t queue_size = 16;
+};
+
+/**
+ * @brief Records MPEG2-TS chunks to rolling files
+ * @details Chunks are queued without copying and written by a dedicated
+ * thread, so the packager never waits for disk. Every file
+ * <stream>-<UTC start time>.ts has a sidecar index .idx with a line per chunk:
+ * "<start unix time ms> <offset> <size> <duration> <media sequence number>".
+ * An index line is written only after the chunk data is on disk
+ */
+class Recorder : public Observer<types::Mpeg2TsChunk> {
+ public:
+  /**
+   * @throw std::runtime_error if can't create directory
+   *
+   * @param options Recording options
+   */
+  explicit Recorder(RecorderOptions options);
+
+  /**
+   * @brief Write queued chunks and close the current file
+   */
+  ~Recorder() override;
+
+  Recorder(const Recorder &) = delete;
+  Recorder &operator=(const Recorder &) = delete;
+
+  /**
+   * @param chunk_ptr Chunk to record. Dropped if write queue is full
+   */
+  void Receive(DataPtr chunk_ptr) override;
+
+ private:
+  using WallClock = std::chrono::system_clock;
+
+  /**
+   * @brief Chunk waiting for write
+   */
+  struct QueuedChunk {
+    DataPtr chunk_ptr;
+    WallClock::time_point start_time; //!< Wall time of the first frame
+  };
+
+  const RecorderOptions options_;
+  std::deque<QueuedChunk> queue_;
+  bool stop_; //!< Writer thread should finish after writing queued chunks
+  std::mutex queue_mutex_; //!< Mutex for queue_ and stop_
+  std::condition_variable queue_condition_;
+
+  // Fields below are used only by writer thread
+  std::unique_ptr<AlignedFile> file_ptr_;
+  std::string index_path_;
+  WallClock::time_point file_start_time_;
+  //! Index lines of chunks, which data is still buffered, with end offsets
+  std::deque<std::pair<uint64_t, std::string>> pending_index_lines_;
+
+  metrics::Counter &written_bytes_;
+  metrics::Counter &recorded_chunks_;
+  metrics::Counter &dropped_chunks_;
+  metrics::Counter &errors_;
+  metrics::Histogram &write_duration_;
+  std::thread writer_;
+
+  /**
+   * @brief Write queued chunks until stop
+   */
+  void WriterRoutine();
+
+  /**
+   * @brief Append chunk to the current file, rolling it if needed
+   * @throw std::runtime_error if write failed
+   *
+   * @param queued_chunk Chunk to write
+   */
+  void Write(const QueuedChunk &queued_chunk);
+
+  /**
+   * @brief Create the next file
+   * @throw std::runtime_error if can't create file
+   *
+   * @param start_time Wall time of the first chunk in file
+   */
+  void OpenFile(WallClock::time_point start_time);
+
+  /**
+   * @brief Write remaining data and index of the current file and close it
+   * @throw std::runtime_error if write failed
+   */
+  void CloseFile();
+
+  /**
+   * @brief Append index lines of chunks, which data is already on disk
+   * @throw std::runtime_error if write failed
+   *
+   * @param written_size Size of file data written to disk
+   */
+  void WriteIndexLines(uint64_t written_size);
+
+  /**
+   * @brief Build file path without extension
+   *
+   * @param start_time Wall time of the first chunk in file
+   * @return Path
+   */
+  [[nodiscard]] std::string BuildBasePath(WallClock::time_point start_time) const;
+};
+
+} // namespace recording
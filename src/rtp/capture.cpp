@@ -0,0 +1,152 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "capture.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+using namespace std::string_literals;
+
+const char kMagic[8] = {'M', 'S', 'R', 'T', 'P', 'C', 'A', 'P'};
+const uint16_t kVersion = 1;
+//! Capture files are written and read in big chunks
+const std::size_t kFileBufferSize = 1 << 20;
+
+/**
+ * @brief Write big-endian integer
+ *
+ * @param os Output stream
+ * @param value Value to write
+ * @param size Number of bytes to write
+ */
+void WriteInteger(std::ostream &os, const uint64_t value, const int size) {
+  for (int i = size - 1; i >= 0; --i) {
+    os.put(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+/**
+ * @brief Read big-endian integer
+ *
+ * @param is Input stream
+ * @param size Number of bytes to read
+ * @return Value
+ */
+uint64_t ReadInteger(std::istream &is, const int size) {
+  uint64_t value = 0;
+  for (int i = 0; i < size; ++i) {
+    value = (value << 8) | static_cast<uint8_t>(is.get());
+  }
+
+  return value;
+}
+
+} // namespace
+
+namespace rtp {
+
+CaptureWriter::CaptureWriter(const std::string &path,
+                             const StreamInfo &stream_info) :
+file_(),
+start_time_(),
+is_started_(false) {
+  file_.rdbuf()->pubsetbuf(nullptr, kFileBufferSize);
+  file_.open(path, std::ios::binary | std::ios::trunc);
+  if (!file_) {
+    throw std::runtime_error("Can't create capture file "s + path);
+  }
+
+  file_.write(kMagic, sizeof(kMagic));
+  WriteInteger(file_, kVersion, 2);
+  WriteInteger(file_, stream_info.width, 2);
+  WriteInteger(file_, stream_info.height, 2);
+  WriteInteger(file_, stream_info.fps, 2);
+}
+
+void CaptureWriter::Write(const types::Timestamp receive_time,
+                          const types::Bytes &datagram) {
+  if (!is_started_) {
+    start_time_ = receive_time;
+    is_started_ = true;
+  }
+
+  const std::chrono::nanoseconds offset = receive_time - start_time_;
+  WriteInteger(file_, offset.count(), 8);
+  WriteInteger(file_, datagram.size(), 2);
+  file_.write(reinterpret_cast<const char *>(datagram.data()),
+              datagram.size());
+  if (!file_) {
+    throw std::runtime_error("Can't write capture file");
+  }
+}
+
+CaptureReader::CaptureReader(const std::string &path) :
+file_(),
+stream_info_() {
+  file_.rdbuf()->pubsetbuf(nullptr, kFileBufferSize);
+  file_.open(path, std::ios::binary);
+  if (!file_) {
+    throw std::runtime_error("Can't open capture file "s + path);
+  }
+
+  char magic[sizeof(kMagic)] = {};
+  file_.read(magic, sizeof(magic));
+  if (!file_ || !std::equal(magic, magic + sizeof(magic), kMagic)) {
+    throw std::runtime_error(path + " isn't a capture file");
+  }
+  if (ReadInteger(file_, 2) != kVersion) {
+    throw std::runtime_error(path + " has unsupported capture version");
+  }
+  stream_info_.width = ReadInteger(file_, 2);
+  stream_info_.height = ReadInteger(file_, 2);
+  stream_info_.fps = ReadInteger(file_, 2);
+  if (!file_) {
+    throw std::runtime_error(path + " is truncated");
+  }
+}
+
+const StreamInfo &CaptureReader::GetStreamInfo() const {
+  return stream_info_;
+}
+
+bool CaptureReader::Read(CaptureRecord &record) {
+  if (file_.peek() == std::ifstream::traits_type::eof()) {
+    return false;
+  }
+
+  record.offset = std::chrono::nanoseconds(ReadInteger(file_, 8));
+  record.datagram.resize(ReadInteger(file_, 2));
+  file_.read(reinterpret_cast<char *>(record.datagram.data()),
+             record.datagram.size());
+  if (!file_) {
+    throw std::runtime_error("Capture file is truncated");
+  }
+
+  return true;
+}
+
+} // namespace rtp
@@ -0,0 +1,117 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "types/byte.h"
+#include "types/timestamp.h"
+
+namespace rtp {
+
+/**
+ * @brief Parameters of captured stream, that are needed to replay it
+ */
+struct StreamInfo {
+  int width = 0; //!< Image width
+  int height = 0; //!< Image height
+  int fps = 0; //!< Video fps
+};
+
+/**
+ * @brief Captured RTP datagram
+ */
+struct CaptureRecord {
+  std::chrono::nanoseconds offset; //!< Arrival time since capture start
+  types::Bytes datagram;
+};
+
+/**
+ * @brief Writer of raw RTP datagrams with arrival times
+ * @details File starts with "MSRTPCAP" magic, format version, width, height
+ * and fps. Each record is 8-byte arrival offset in nanoseconds, 2-byte
+ * datagram size and datagram itself. All integers are big-endian
+ */
+class CaptureWriter {
+ public:
+  /**
+   * @throw std::runtime_error if file can't be created
+   *
+   * @param path Path of capture file
+   * @param stream_info Parameters of captured stream
+   */
+  CaptureWriter(const std::string &path, const StreamInfo &stream_info);
+
+  /**
+   * @brief Append datagram to capture
+   * @throw std::runtime_error if writing failed
+   *
+   * @param receive_time Arrival time of datagram
+   * @param datagram RTP datagram
+   */
+  void Write(types::Timestamp receive_time, const types::Bytes &datagram);
+
+ private:
+  std::ofstream file_;
+  //! Arrival time of the first datagram. Offsets are counted from it
+  types::Timestamp start_time_;
+  bool is_started_; //!< True, if at least one datagram was written
+};
+
+/**
+ * @brief Reader of files, written by CaptureWriter
+ */
+class CaptureReader {
+ public:
+  /**
+   * @throw std::runtime_error if file can't be opened or isn't a capture
+   *
+   * @param path Path of capture file
+   */
+  explicit CaptureReader(const std::string &path);
+
+  /**
+   * @return Parameters of captured stream
+   */
+  [[nodiscard]] const StreamInfo &GetStreamInfo() const;
+
+  /**
+   * @brief Read next record
+   * @throw std::runtime_error if file is truncated
+   *
+   * @param record Record to read into
+   * @return false if there are no more records
+   */
+  bool Read(CaptureRecord &record);
+
+ private:
+  std::ifstream file_;
+  StreamInfo stream_info_;
+};
+
+} // namespace rtp
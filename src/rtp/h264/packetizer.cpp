@@ -0,0 +1,198 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "packetizer.h"
+
+#include <algorithm>
+#include <random>
+
+namespace {
+
+const std::size_t kHeaderSize = 12; //!< RTP header without CSRC
+const uint8_t kNalTypeMask = 0x1f;
+const uint8_t kSpsNalType = 7;
+const uint8_t kPpsNalType = 8;
+const uint8_t kFuANalType = 28;
+const uint8_t kFuStartBit = 0x80;
+const uint8_t kFuEndBit = 0x40;
+
+/**
+ * @brief Find the next Annex B start code
+ *
+ * @param begin Start of data
+ * @param end End of data
+ * @return Pointer to the first zero byte of start code
+ * @return end, if there is no start code
+ */
+const types::Byte *FindStartCode(const types::Byte *begin,
+                                 const types::Byte *end) {
+  for (const types::Byte *it = begin; it + 3 <= end; ++it) {
+    if ((it[0] == 0) && (it[1] == 0) && (it[2] == 1)) {
+      return it;
+    }
+  }
+
+  return end;
+}
+
+/**
+ * @brief Encode bytes with Base64
+ *
+ * @param bytes Bytes to encode
+ * @return Encoded string
+ */
+std::string EncodeBase64(const types::Bytes &bytes) {
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  std::string result;
+  result.reserve((bytes.size() + 2) / 3 * 4);
+  for (std::size_t i = 0; i < bytes.size(); i += 3) {
+    const std::size_t count = std::min<std::size_t>(3, bytes.size() - i);
+    uint32_t triple = bytes[i] << 16;
+    if (count > 1) {
+      triple |= bytes[i + 1] << 8;
+    }
+    if (count > 2) {
+      triple |= bytes[i + 2];
+    }
+
+    result += kAlphabet[(triple >> 18) & 0x3f];
+    result += kAlphabet[(triple >> 12) & 0x3f];
+    result += (count > 1) ? kAlphabet[(triple >> 6) & 0x3f] : '=';
+    result += (count > 2) ? kAlphabet[triple & 0x3f] : '=';
+  }
+
+  return result;
+}
+
+} // namespace
+
+namespace rtp::h264 {
+
+Packetizer::Packetizer():
+synchronization_source_(std::random_device()()),
+timestamp_offset_(std::random_device()()),
+sequence_number_(static_cast<uint16_t>(std::random_device()())),
+sps_(),
+pps_() {
+}
+
+PacketSet Packetizer::Packetize(const types::H264Frame &frame) {
+  PacketSet packet_set;
+  packet_set.key_frame = frame.key_frame;
+  const uint32_t timestamp = static_cast<uint32_t>(frame.pts) +
+                             timestamp_offset_;
+
+  const types::Byte *const end = frame.data.data() + frame.data.size();
+  const types::Byte *nal_begin = FindStartCode(frame.data.data(), end);
+  while (nal_begin != end) {
+    nal_begin += 3;
+    const types::Byte *nal_end = FindStartCode(nal_begin, end);
+    const types::Byte *next_begin = nal_end;
+    // Zero before start code is a part of 4-byte start code
+    while ((nal_end > nal_begin) && (nal_end[-1] == 0)) {
+      --nal_end;
+    }
+
+    if (nal_end > nal_begin) {
+      const uint8_t nal_type = nal_begin[0] & kNalTypeMask;
+      if (nal_type == kSpsNalType) {
+        sps_.assign(nal_begin, nal_end);
+      } else if (nal_type == kPpsNalType) {
+        pps_.assign(nal_begin, nal_end);
+      }
+      PacketizeNalUnit(nal_begin, nal_end - nal_begin, timestamp,
+                       next_begin == end, packet_set.packets);
+    }
+    nal_begin = next_begin;
+  }
+
+  return packet_set;
+}
+
+uint32_t Packetizer::GetSynchronizationSource() const {
+  return synchronization_source_;
+}
+
+std::string Packetizer::GetParameterSets() const {
+  if (sps_.empty() || pps_.empty()) {
+    return "";
+  }
+
+  return EncodeBase64(sps_) + "," + EncodeBase64(pps_);
+}
+
+void Packetizer::PacketizeNalUnit(const types::Byte *nal_unit,
+                                  const std::size_t size,
+                                  const uint32_t timestamp, const bool last,
+                                  std::vector<types::Bytes> &packets) {
+  if (size <= kMaxPayloadSize) {
+    types::Bytes packet = MakePacket(timestamp, last, size);
+    packet.insert(packet.end(), nal_unit, nal_unit + size);
+    packets.push_back(std::move(packet));
+    return;
+  }
+
+  // NAL header is replaced with FU indicator and FU header in every fragment
+  const uint8_t fu_indicator = (nal_unit[0] & ~kNalTypeMask) | kFuANalType;
+  const uint8_t nal_type = nal_unit[0] & kNalTypeMask;
+  const std::size_t kMaxFragmentSize = kMaxPayloadSize - 2;
+  for (std::size_t offset = 1; offset < size; offset += kMaxFragmentSize) {
+    const std::size_t fragment_size = std::min(kMaxFragmentSize, size - offset);
+    const bool first_fragment = (offset == 1);
+    const bool last_fragment = (offset + fragment_size == size);
+
+    types::Bytes packet = MakePacket(timestamp, last && last_fragment,
+                                     fragment_size + 2);
+    packet.push_back(fu_indicator);
+    packet.push_back((first_fragment ? kFuStartBit : 0) |
+                     (last_fragment ? kFuEndBit : 0) | nal_type);
+    packet.insert(packet.end(), nal_unit + offset,
+                  nal_unit + offset + fragment_size);
+    packets.push_back(std::move(packet));
+  }
+}
+
+types::Bytes Packetizer::MakePacket(const uint32_t timestamp, const bool marker,
+                                    const std::size_t payload_size) {
+  const uint16_t sequence_number = sequence_number_++;
+
+  types::Bytes packet;
+  packet.reserve(kHeaderSize + payload_size);
+  packet.push_back(0x80); // Version 2 without padding, extension and CSRC
+  packet.push_back((marker ? 0x80 : 0) | kPayloadType);
+  packet.push_back(sequence_number >> 8);
+  packet.push_back(sequence_number & 0xff);
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    packet.push_back((timestamp >> shift) & 0xff);
+  }
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    packet.push_back((synchronization_source_ >> shift) & 0xff);
+  }
+
+  return packet;
+}
+
+} // namespace rtp::h264
@@ -0,0 +1,115 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "types/byte.h"
+#include "types/h264_frame.h"
+
+namespace rtp::h264 {
+
+/**
+ * @brief RTP packets of one H.264 frame
+ */
+struct PacketSet {
+  std::vector<types::Bytes> packets; //!< Serialized RTP packets
+  bool key_frame = false; //!< True, if decoding can start from this frame
+};
+
+/**
+ * @brief Splits H.264 frames into RTP packets according to RFC 6184
+ * @details NAL units, that fit into one packet, are sent as is (single NAL unit
+ * mode), longer ones are fragmented into FU-A packets. Packets are made once
+ * and can be sent to any number of clients
+ */
+class Packetizer {
+ public:
+  static constexpr uint8_t kPayloadType = 96; //!< Dynamic payload type
+  //! Max RTP payload size, so packet fits into Ethernet MTU with IP and UDP
+  static constexpr std::size_t kMaxPayloadSize = 1400;
+
+  /**
+   * @details Synchronization source, first sequence number and timestamp
+   * offset are random
+   */
+  Packetizer();
+
+  /**
+   * @brief Make RTP packets of frame
+   *
+   * @param frame H.264 frame in Annex B format with 90 kHz pts
+   * @return Packets of frame. The last one has marker bit set
+   */
+  [[nodiscard]] PacketSet Packetize(const types::H264Frame &frame);
+
+  /**
+   * @return Synchronization source of all packets
+   */
+  [[nodiscard]] uint32_t GetSynchronizationSource() const;
+
+  /**
+   * @brief Get SPS and PPS for SDP "sprop-parameter-sets" parameter
+   *
+   * @return Base64 encoded SPS and PPS, separated by comma
+   * @return "" if they weren't met yet
+   */
+  [[nodiscard]] std::string GetParameterSets() const;
+
+ private:
+  const uint32_t synchronization_source_;
+  const uint32_t timestamp_offset_;
+  uint16_t sequence_number_; //!< Sequence number of the next packet
+  types::Bytes sps_; //!< The last sequence parameter set
+  types::Bytes pps_; //!< The last picture parameter set
+
+  /**
+   * @brief Add packets of one NAL unit
+   *
+   * @param nal_unit NAL unit without start code
+   * @param size Size of NAL unit
+   * @param timestamp RTP timestamp of frame
+   * @param last True, if it's the last NAL unit of frame
+   * @param packets Packets to add to
+   */
+  void PacketizeNalUnit(const types::Byte *nal_unit, std::size_t size,
+                        uint32_t timestamp, bool last,
+                        std::vector<types::Bytes> &packets);
+
+  /**
+   * @brief Make packet with RTP header and reserve space for payload
+   *
+   * @param timestamp RTP timestamp
+   * @param marker Marker bit. Set on the last packet of frame
+   * @param payload_size Size of payload to be appended
+   * @return Packet with header only
+   */
+  types::Bytes MakePacket(uint32_t timestamp, bool marker,
+                          std::size_t payload_size);
+};
+
+} // namespace rtp::h264
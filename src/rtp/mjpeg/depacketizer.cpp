@@ -0,0 +1,133 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "depacketizer.h"
+
+#include <stdexcept>
+
+#include "rtp/packet.h"
+#include "logging/logger.h"
+#include "metrics/registry.h"
+
+namespace rtp::mjpeg {
+
+Depacketizer::Depacketizer() :
+packets_(),
+frame_timestamp_(0),
+frame_ingest_time_(),
+has_timestamp_(false),
+last_timestamp_(0),
+extended_timestamp_(0),
+has_sequence_number_(false),
+expected_sequence_number_(0),
+packets_counter_(metrics::Registry::GetInstance().GetCounter(
+    "rtp_packets_received_total", "Number of received RTP packets")),
+bytes_counter_(metrics::Registry::GetInstance().GetCounter(
+    "rtp_bytes_received_total", "Number of received RTP bytes")),
+lost_packets_counter_(metrics::Registry::GetInstance().GetCounter(
+    "rtp_packets_lost_total",
+    "Number of RTP packets missed according to sequence numbers")),
+invalid_packets_counter_(metrics::Registry::GetInstance().GetCounter(
+    "rtp_packets_invalid_total", "Number of RTP packets, that can't be parsed")),
+frames_counter_(metrics::Registry::GetInstance().GetCounter(
+    "frames_received_total", "Number of assembled JPEG frames")),
+dropped_frames_counter_(metrics::Registry::GetInstance().GetCounter(
+    "frames_dropped_total", "Number of frames dropped because of errors")),
+depacketize_latency_(metrics::GetStageLatency("depacketize")) {
+}
+
+std::optional<types::MjpegFrame> Depacketizer::Push(
+    const types::Bytes &datagram, const types::Timestamp receive_time) {
+  packets_counter_.Add();
+  bytes_counter_.Add(datagram.size());
+
+  rtp::Packet rtp_packet;
+  Packet mjpeg_packet;
+  try {
+    rtp_packet.Deserialize(datagram);
+    mjpeg_packet.Deserialize(rtp_packet.payload);
+  } catch (const std::invalid_argument &ex) {
+    invalid_packets_counter_.Add();
+    LOG_EVERY_N(kWarning, 100) << "Invalid RTP packet: " << ex.what();
+    return std::nullopt;
+  }
+  CountLostPackets(rtp_packet.header.sequence_number);
+
+  // Frame, which last packet was lost, can't be completed
+  if (!packets_.empty() &&
+      (rtp_packet.header.timestamp != frame_timestamp_)) {
+    dropped_frames_counter_.Add();
+    packets_.clear();
+  }
+  if (packets_.empty()) {
+    frame_timestamp_ = rtp_packet.header.timestamp;
+    frame_ingest_time_ = receive_time;
+  }
+  packets_.push_back(std::move(mjpeg_packet));
+  if (rtp_packet.header.marker != 1U) {
+    return std::nullopt;
+  }
+
+  std::optional<types::MjpegFrame> frame;
+  try {
+    frame.emplace(UnpackJpeg(packets_));
+    frame->ingest_time = frame_ingest_time_;
+    frame->timestamp = ExtendTimestamp(frame_timestamp_);
+    depacketize_latency_.RecordDuration(types::Clock::now() -
+                                        frame_ingest_time_);
+    frames_counter_.Add();
+  } catch (const std::runtime_error &ex) {
+    dropped_frames_counter_.Add();
+    LOG_EVERY_N(kWarning, 100) << ex.what();
+  }
+  packets_.clear();
+
+  return frame;
+}
+
+void Depacketizer::CountLostPackets(const uint16_t sequence_number) {
+  const uint16_t gap = sequence_number - expected_sequence_number_;
+  // Gaps "from the past" are late or duplicated packets, not losses
+  if (!has_sequence_number_ || (gap < 0x8000)) {
+    if (has_sequence_number_) {
+      lost_packets_counter_.Add(gap);
+    }
+    has_sequence_number_ = true;
+    expected_sequence_number_ = sequence_number + 1;
+  }
+}
+
+int64_t Depacketizer::ExtendTimestamp(const uint32_t timestamp) {
+  if (has_timestamp_) {
+    extended_timestamp_ += static_cast<int32_t>(timestamp - last_timestamp_);
+  } else {
+    has_timestamp_ = true;
+    extended_timestamp_ = timestamp;
+  }
+  last_timestamp_ = timestamp;
+
+  return extended_timestamp_;
+}
+
+} // namespace rtp::mjpeg
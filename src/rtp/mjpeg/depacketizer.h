@@ -0,0 +1,96 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "packet.h"
+#include "types/byte.h"
+#include "types/mjpeg_frame.h"
+#include "types/timestamp.h"
+#include "metrics/counter.h"
+#include "metrics/histogram.h"
+
+namespace rtp::mjpeg {
+
+/**
+ * @brief Assembles JPEG frames from RTP datagrams
+ * @details Doesn't depend on sockets, so the same code is used for network
+ * receiving and capture replaying
+ */
+class Depacketizer {
+ public:
+  Depacketizer();
+
+  /**
+   * @brief Process one RTP datagram
+   * @details Invalid datagrams and incomplete frames are dropped and counted
+   *
+   * @param datagram RTP datagram
+   * @param receive_time Arrival time of datagram
+   * @return Frame, if datagram completes it
+   */
+  std::optional<types::MjpegFrame> Push(const types::Bytes &datagram,
+                                        types::Timestamp receive_time);
+
+ private:
+  std::vector<Packet> packets_; //!< Packets of the current frame
+  uint32_t frame_timestamp_; //!< RTP timestamp of the current frame
+  types::Timestamp frame_ingest_time_; //!< Arrival time of its first packet
+  bool has_timestamp_; //!< True, if a frame was completed
+  uint32_t last_timestamp_; //!< RTP timestamp of the last completed frame
+  //! Last completed frame timestamp extended to 64 bits
+  int64_t extended_timestamp_;
+  bool has_sequence_number_;
+  uint16_t expected_sequence_number_;
+  metrics::Counter &packets_counter_;
+  metrics::Counter &bytes_counter_;
+  metrics::Counter &lost_packets_counter_;
+  metrics::Counter &invalid_packets_counter_;
+  metrics::Counter &frames_counter_;
+  metrics::Counter &dropped_frames_counter_;
+  metrics::Histogram &depacketize_latency_;
+
+  /**
+   * @brief Count lost packets according to sequence number
+   *
+   * @param sequence_number Sequence number of received packet
+   */
+  void CountLostPackets(uint16_t sequence_number);
+
+  /**
+   * @brief Extend 32-bit RTP timestamp, so it doesn't wrap around every 13 hours
+   * @details Difference from the previous timestamp is taken as signed, so
+   * frames may be slightly reordered
+   *
+   * @param timestamp RTP timestamp of completed frame
+   * @return 64-bit timestamp
+   */
+  int64_t ExtendTimestamp(uint32_t timestamp);
+};
+
+} // namespace rtp::mjpeg
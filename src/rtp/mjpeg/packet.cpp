@@ -25,6 +25,7 @@ SOFTWARE.
 #include "packet.h"
 
 #include <algorithm>
+#include <stdexcept>
 
 namespace {
 
@@ -303,16 +304,21 @@ void Packet::Deserialize(const types::Bytes &bytes) {
     payload_begin_it += 4;
     header.restart_marker_header = Deserialize32({bytes.begin() + 8, payload_begin_it});
   }
-  if (header.quality >= 128) {
+  // Quantization tables are sent only in the first packet of the frame
+  if ((header.quality >= 128) && (header.fragment_offset == 0)) {
+    ValidateBytesSize(bytes, (payload_begin_it - bytes.begin()) + 4);
     auto it = payload_begin_it;
     header.quantization_table_header.mbz = *(it++);
     header.quantization_table_header.precision = *(it++);
-    header.quantization_table_header.length = *(it++);
+    header.quantization_table_header.length = Deserialize16({it, it + 2});
+    it += 2;
+    ValidateBytesSize(bytes, (it - bytes.begin()) +
+                             header.quantization_table_header.length);
     header.quantization_table_header.data.insert(
         header.quantization_table_header.data.end(),
         it,
         it + header.quantization_table_header.length);
-    payload_begin_it += 3 + header.quantization_table_header.length;
+    payload_begin_it = it + header.quantization_table_header.length;
   }
   payload.insert(payload.end(), payload_begin_it, bytes.end());
 }
@@ -323,12 +329,15 @@ types::Bytes UnpackJpeg(const std::vector<Packet> &packets) {
 
   const uint8_t quality = packets[0].header.quality;
   if (quality > 127) {
-   const types::Bytes &data = packets[0].header.quantization_table_header.data;
-   luma_quantization_table.insert(luma_quantization_table.end(), data.begin(),
-                                  data.begin() + kQuantizationTableSize);
-   chroma_quantization_table.insert(chroma_quantization_table.end(),
-                                    data.begin() + kQuantizationTableSize,
-                                    data.begin() + 2 * kQuantizationTableSize);
+    const types::Bytes &data = packets[0].header.quantization_table_header.data;
+    if (data.size() < 2 * kQuantizationTableSize) {
+      throw std::runtime_error("Quantization tables are missing in frame");
+    }
+    std::copy(data.begin(), data.begin() + kQuantizationTableSize,
+              luma_quantization_table.begin());
+    std::copy(data.begin() + kQuantizationTableSize,
+              data.begin() + 2 * kQuantizationTableSize,
+              chroma_quantization_table.begin());
   } else {
     WriteTables(quality, luma_quantization_table, chroma_quantization_table);
   }
@@ -340,6 +349,13 @@ types::Bytes UnpackJpeg(const std::vector<Packet> &packets) {
     jpeg_image.insert(jpeg_image.end(), it->payload.begin(), it->payload.end());
   }
 
+  // Payload is entropy-coded data only, but some senders keep EOI in it
+  const std::size_t size = jpeg_image.size();
+  if ((jpeg_image[size - 2] != 0xff) || (jpeg_image[size - 1] != 0xd9)) {
+    jpeg_image.push_back(0xff);
+    jpeg_image.push_back(0xd9);
+  }
+
   return jpeg_image;
 }
 } // namespace rtp::mjpeg
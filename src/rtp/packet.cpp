@@ -24,6 +24,8 @@ SOFTWARE.
 
 #include "packet.h"
 
+#include <stdexcept>
+
 namespace rtp {
 
 void Packet::Deserialize(const types::Bytes &bytes) {
@@ -39,6 +41,7 @@ void Packet::Deserialize(const types::Bytes &bytes) {
   header.timestamp = Deserialize32({bytes.begin() + 4, bytes.begin() + 8});
   header.synchronization_source = Deserialize32({bytes.begin() + 8,
                                                  bytes.begin() + 12});
+  ValidateBytesSize(bytes, 12 + 4 * header.csrc_count);
   const auto contributing_sources_begin_it = bytes.begin() + 12;
   for (uint32_t i = 0;
       (i < header.csrc_count) && (i < Header::kContributingSourcesMaxCount);
@@ -49,19 +52,35 @@ void Packet::Deserialize(const types::Bytes &bytes) {
   }
   auto payload_begin_it = contributing_sources_begin_it + 4 * header.csrc_count;
   if (header.extension == 1) {
+    ValidateBytesSize(bytes, (payload_begin_it - bytes.begin()) + 4);
     const auto extension_header_begin_it = payload_begin_it;
     header.extension_header.id = Deserialize16({extension_header_begin_it,
                                                 extension_header_begin_it + 2});
     header.extension_header.length = Deserialize16(
         {extension_header_begin_it + 2, extension_header_begin_it + 4});
     const auto extension_content_begin_it = extension_header_begin_it + 4;
-    payload_begin_it = extension_content_begin_it + header.extension_header.length;
+    // Length is counted in 32-bit words
+    const std::size_t extension_content_size =
+        4 * header.extension_header.length;
+    ValidateBytesSize(bytes, (extension_content_begin_it - bytes.begin()) +
+                             extension_content_size);
+    payload_begin_it = extension_content_begin_it + extension_content_size;
     header.extension_header.content.insert(
         header.extension_header.content.end(),
         extension_content_begin_it,
         payload_begin_it);
   }
-  payload.insert(payload.end(), payload_begin_it, bytes.end());
+  auto payload_end_it = bytes.end();
+  if (header.padding == 1) {
+    // The last byte is the number of padding bytes, including itself
+    const std::size_t padding_size = bytes.back();
+    if ((padding_size == 0) ||
+        (padding_size > static_cast<std::size_t>(bytes.end() - payload_begin_it))) {
+      throw std::invalid_argument("Invalid RTP padding");
+    }
+    payload_end_it -= padding_size;
+  }
+  payload.insert(payload.end(), payload_begin_it, payload_end_it);
 }
 
 sock::Socket &operator>>(sock::Socket &socket, Packet &packet) {
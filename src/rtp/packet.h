@@ -56,7 +56,7 @@ struct Header {
   std::array<uint32_t, kContributingSourcesMaxCount> contributing_sources;
   struct {
     uint16_t id; //!< The id of extension header. Defined by a profile
-    uint16_t length; //!< Length of the extension header. Equals to content.size()
+    uint16_t length; //!< Length of the extension in 32-bit words. Equals to content.size() / 4
     types::Bytes content; //!< The actual header represented in bytes
   } extension_header; //!< Extension header. Used then extension bit is set
 };
@@ -28,13 +28,13 @@ SOFTWARE.
 #include <arpa/inet.h>
 
 #include <algorithm>
-#include <iostream>
 
 #include "request.h"
 #include "sdp/session_description.h"
 #include "split.h"
-#include "rtp/packet.h"
-#include "rtp/mjpeg/packet.h"
+#include "rtp/mjpeg/depacketizer.h"
+#include "logging/logger.h"
+#include "metrics/registry.h"
 
 namespace {
 
@@ -98,7 +98,7 @@ namespace rtsp {
 
 using namespace std::string_literals;
 
-Client::Client(std::string url):
+Client::Client(std::string url, const std::string &capture_path):
 url_(std::move(url)),
 rtsp_socket_(sock::Type::kTcp),
 rtp_socket_(sock::Type::kUdp, 4577),
@@ -107,12 +107,13 @@ width_(0),
 height_(0),
 fps_(0),
 session_id_(0),
+capture_writer_ptr_(),
 rtp_data_receiving_worker_(),
 worker_stop_(false),
 worker_mutex_() {
   auto [hostname, port] = GetHostnameAndPort(url_, 554);
   std::string server_ip = GetIp(hostname);
-  std::cout << "Connecting to " << server_ip << ":" << port << std::endl;
+  LOG(kInfo) << "Connecting to " << server_ip << ":" << port;
   if (!rtsp_socket_.Connect(server_ip, port)) {
     throw std::runtime_error("Can't connect to the RTSP server "s +
                              server_ip + ':' + std::to_string(port));
@@ -122,12 +123,23 @@ worker_mutex_() {
   HandleDescribeResponse(SendDescribeRequest());
   HandleSetupResponse(SendSetupRequest());
 
+  if (!capture_path.empty()) {
+    LOG(kInfo) << "Capturing RTP to " << capture_path;
+    capture_writer_ptr_ = std::make_unique<rtp::CaptureWriter>(
+        capture_path, rtp::StreamInfo{width_, height_, fps_});
+  }
+
+  rtp_socket_.SetTimeouts(kRtpReceiveTimeout, kRtpReceiveTimeout);
   (void)SendPlayRequest();
   rtp_data_receiving_worker_ = std::thread(&Client::RtpDataReceiving, this);
 }
 
 Client::~Client() {
-  (void)SendTeardownRequest();
+  try {
+    (void)SendTeardownRequest();
+  } catch (const std::exception &ex) {
+    LOG(kWarning) << "Can't teardown RTSP session: " << ex.what();
+  }
 
   {
     std::lock_guard lock(worker_mutex_);
@@ -238,28 +250,34 @@ Request Client::BuildRequestSkeleton(const Method method) {
   request.method = method;
   request.url = url_;
   request.version = 1.0;
-  request.headers["Cseq"] = std::to_string(++cseq_counter);
+  request.headers["CSeq"] = std::to_string(++cseq_counter);
   request.headers["User-Agent"] = "Arjentix Media Server";
 
   return request;
 }
 
 void Client::SendRequest(const Request &request) {
-  std::cout << "\nRequest:\n" << request << std::endl;
+  LOG(kDebug) << "RTSP request:\n" << request;
   rtsp_socket_ << request << std::endl;
 }
 
 Response Client::ReceiveResponse() {
   Response response;
   rtsp_socket_ >> response;
-  std::cout << "\nResponse:\n" << response << std::endl;
+  LOG(kDebug) << "RTSP response:\n" << response;
   VerifyResponseIsOk(response);
 
   return response;
 }
 
 void Client::RtpDataReceiving() {
-  std::vector<rtp::mjpeg::Packet> mjpeg_packets;
+  rtp::mjpeg::Depacketizer depacketizer;
+  sock::DatagramBatch batch(kRtpBatchSize, kRtpMaxPacketSize);
+  metrics::Registry &registry = metrics::Registry::GetInstance();
+  metrics::Counter &truncated_packets_counter = registry.GetCounter(
+      "rtp_packets_truncated_total", "Number of truncated RTP packets");
+  metrics::Counter &dropped_frames_counter = registry.GetCounter(
+      "frames_dropped_total", "Number of frames dropped because of errors");
 
   for (;;) {
     {
@@ -269,19 +287,37 @@ void Client::RtpDataReceiving() {
       }
     }
 
-    rtp::Packet rtp_packet;
-    rtp_socket_ >> rtp_packet;
-    rtp::mjpeg::Packet mjpeg_packet;
-    mjpeg_packet.Deserialize(rtp_packet.payload);
-    mjpeg_packets.push_back(std::move(mjpeg_packet));
-    if (rtp_packet.header.marker == 1U) {
-      types::Bytes frame = rtp::mjpeg::UnpackJpeg(mjpeg_packets);
+    const std::size_t count = rtp_socket_.Receive(batch);
+    const types::Timestamp receive_time = types::Clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+      const types::Bytes &datagram = batch.GetDatagram(i);
+      if (batch.IsTruncated(i)) {
+        truncated_packets_counter.Add();
+        LOG_EVERY_N(kWarning, 100) << "RTP packet is longer than "
+                                   << kRtpMaxPacketSize
+                                   << " bytes and was truncated";
+      }
+
+      if (capture_writer_ptr_) {
+        try {
+          capture_writer_ptr_->Write(receive_time, datagram);
+        } catch (const std::runtime_error &ex) {
+          LOG(kError) << ex.what() << ", capture is stopped";
+          capture_writer_ptr_.reset();
+        }
+      }
+
+      std::optional<types::MjpegFrame> frame =
+          depacketizer.Push(datagram, receive_time);
+      if (!frame) {
+        continue;
+      }
       try {
-        ProvideToAll(types::MjpegFrame(frame));
+        ProvideToAll(std::move(*frame));
       } catch (std::runtime_error &ex) {
-        std::cout << "Warning: " << ex.what() << std::endl;
+        dropped_frames_counter.Add();
+        LOG_EVERY_N(kWarning, 100) << ex.what();
       }
-      mjpeg_packets.clear();
     }
   }
 }
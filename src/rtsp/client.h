@@ -24,6 +24,8 @@ SOFTWARE.
 
 #pragma once
 
+#include <chrono>
+#include <memory>
 #include <string>
 #include <thread>
 #include <mutex>
@@ -35,6 +37,7 @@ SOFTWARE.
 #include "request.h"
 #include "response.h"
 #include "sdp/session_description.h"
+#include "rtp/capture.h"
 
 namespace rtsp {
 
@@ -47,11 +50,13 @@ namespace rtsp {
    * @details Blocks until connection is established
    *
    * @param url RTSP stream url
+   * @param capture_path If not empty, received RTP datagrams are also written
+   * to this file, so they can be replayed later
    */
-  explicit Client(std::string url);
+  explicit Client(std::string url, const std::string &capture_path = "");
 
   /**
-   * @brief Sends TEARDOWN request
+   * @brief Sends TEARDOWN request and stops receiving RTP data
    */
   ~Client();
 
@@ -77,6 +82,13 @@ namespace rtsp {
   int GetFps() const;
 
  private:
+  //! Max number of RTP packets to receive with one system call
+  static constexpr std::size_t kRtpBatchSize = 32;
+  //! Max size of RTP packet. Longer packets are truncated
+  static constexpr std::size_t kRtpMaxPacketSize = 4096;
+  //! Max time to wait for RTP packets before checking for worker stop
+  static constexpr std::chrono::milliseconds kRtpReceiveTimeout{500};
+
   std::string url_; //!< RTSP stream url
   sock::ClientSocket rtsp_socket_; //!< Socket for RTSP TCP connection
   sock::ServerSocket rtp_socket_; //!< Socket for RTP UDP data receiving
@@ -86,6 +98,8 @@ namespace rtsp {
   int height_; //!< Image height
   int fps_; //!< Video fps
   uint32_t session_id_; //!< Session identifier
+  //! Writer of received datagrams. nullptr if capture is off
+  std::unique_ptr<rtp::CaptureWriter> capture_writer_ptr_;
   //! Worker that receives data on rtp_socket_ and provide it to all observers
   std::thread rtp_data_receiving_worker_;
   bool worker_stop_; //!< True, if rtp_data_receiving_worker_ should stop
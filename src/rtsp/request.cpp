@@ -24,6 +24,37 @@ SOFTWARE.
 
 #include "request.h"
 
+template <>
+rtsp::Method http::ParseMethod<rtsp::Method>(const std::string &method_str) {
+  rtsp::Method method;
+
+  if (method_str == "DESCRIBE") {
+    method = rtsp::Method::kDescribe;
+  } else if (method_str == "ANNOUNCE") {
+    method = rtsp::Method::kAnnounce;
+  } else if (method_str == "GET_PARAMETER") {
+    method = rtsp::Method::kGetParameter;
+  } else if (method_str == "OPTIONS") {
+    method = rtsp::Method::kOptions;
+  } else if (method_str == "PAUSE") {
+    method = rtsp::Method::kPause;
+  } else if (method_str == "PLAY") {
+    method = rtsp::Method::kPlay;
+  } else if (method_str == "RECORD") {
+    method = rtsp::Method::kRecord;
+  } else if (method_str == "SETUP") {
+    method = rtsp::Method::kSetup;
+  } else if (method_str == "SET_PARAMETER") {
+    method = rtsp::Method::kSetParameter;
+  } else if (method_str == "TEARDOWN") {
+    method = rtsp::Method::kTeardown;
+  } else {
+    throw ParseError("Unknown method " + method_str);
+  }
+
+  return method;
+}
+
 template <>
 std::string http::MethodToString<rtsp::Method>(rtsp::Method method) {
   std::string method_str;
@@ -49,5 +49,8 @@ using Request = http::BaseRequest<Method, kProtocolName>;
 
 } // namespace rtsp
 
+template <>
+rtsp::Method http::ParseMethod<rtsp::Method>(const std::string &method_str);
+
 template <>
 std::string http::MethodToString<rtsp::Method>(rtsp::Method method);
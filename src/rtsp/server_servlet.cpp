@@ -0,0 +1,514 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "server_servlet.h"
+
+#include <arpa/inet.h>
+
+#include <iomanip>
+#include <sstream>
+
+#include "split.h"
+#include "logging/logger.h"
+
+namespace {
+
+const char kCSeqHeaderName[] = "CSeq";
+const char kSessionHeaderName[] = "Session";
+const char kTransportHeaderName[] = "Transport";
+const char kContentLengthHeaderName[] = "Content-Length";
+const char kTrackControl[] = "track1";
+const char kInterleavedMagic = '$';
+const std::size_t kInterleavedHeaderSize = 4;
+
+/**
+ * @brief Parse pair of ports or channels like "5000-5001"
+ *
+ * @param str String to parse
+ * @return The first number of pair
+ */
+int ParseFirstOfPair(const std::string &str) {
+  return std::stoi(str.substr(0, str.find('-')));
+}
+
+} // namespace
+
+namespace rtsp {
+
+using namespace std::string_literals;
+
+ServerServlet::ServerServlet(const ServerOptions &options):
+options_(options),
+packetizer_(),
+rtp_socket_(sock::Type::kUdp, options.rtp_port),
+send_batch_(),
+sessions_(),
+parameter_sets_(),
+session_id_generator_(std::random_device()()),
+sessions_mutex_(),
+sessions_gauge_(metrics::Registry::GetInstance().GetGauge(
+    "rtsp_sessions", "Number of RTSP server sessions")),
+sent_packets_counter_(metrics::Registry::GetInstance().GetCounter(
+    "rtsp_rtp_packets_sent_total", "Number of RTP packets sent to RTSP "
+    "clients over UDP")),
+dropped_frames_counter_(metrics::Registry::GetInstance().GetCounter(
+    "rtsp_dropped_frames_total", "Number of frames not sent to interleaved "
+    "RTSP sessions, because they were slower than the source")),
+send_latency_(metrics::GetStageLatency("rtsp_send")) {
+}
+
+Response ServerServlet::Handle(const Request &request) {
+  Response response;
+  switch (request.method) {
+    case Method::kOptions:
+      response = HandleOptions(request);
+      break;
+    case Method::kDescribe:
+      response = HandleDescribe();
+      break;
+    case Method::kSetup:
+      response = HandleSetup(request);
+      break;
+    case Method::kPlay:
+      response = HandlePlay(request);
+      break;
+    case Method::kTeardown:
+      response = HandleTeardown(request);
+      break;
+    case Method::kGetParameter:
+      response = HandleGetParameter(request);
+      break;
+    default:
+      response = Response(501, "Not Implemented");
+      break;
+  }
+
+  if (request.headers.count(kCSeqHeaderName)) {
+    response.headers[kCSeqHeaderName] = request.headers.at(kCSeqHeaderName);
+  }
+  if (!response.headers.count(kContentLengthHeaderName)) {
+    response.headers[kContentLengthHeaderName] =
+        std::to_string(response.body.size());
+  }
+
+  return response;
+}
+
+void ServerServlet::Receive(DataPtr frame_ptr) {
+  metrics::ScopedTimer timer(send_latency_);
+  auto packet_set_ptr = std::make_shared<const rtp::h264::PacketSet>(
+      packetizer_.Packetize(*frame_ptr));
+
+  send_batch_.Clear();
+  {
+    std::lock_guard guard(sessions_mutex_);
+    if (packet_set_ptr->key_frame) {
+      parameter_sets_ = packetizer_.GetParameterSets();
+    }
+
+    const Clock::time_point now = Clock::now();
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+      Session &session = it->second;
+      if (IsExpired(session, now)) {
+        LOG(kInfo) << "RTSP: Session " << it->first << " expired";
+        it = sessions_.erase(it);
+        continue;
+      }
+      ++it;
+
+      if (!session.playing ||
+          (session.waiting_for_key_frame && !packet_set_ptr->key_frame)) {
+        continue;
+      }
+      session.waiting_for_key_frame = false;
+
+      if (auto stream_ptr = session.stream_ptr.lock()) {
+        stream_ptr->Push(packet_set_ptr);
+      } else if (session.destination) {
+        for (const types::Bytes &packet : packet_set_ptr->packets) {
+          send_batch_.Add(packet, *session.destination);
+        }
+      }
+    }
+    sessions_gauge_.Set(sessions_.size());
+  }
+
+  // Destinations are copied into batch, so sessions can be changed meanwhile
+  if (send_batch_.GetSize() > 0) {
+    sent_packets_counter_.Add(rtp_socket_.Send(send_batch_));
+  }
+}
+
+bool ServerServlet::HasPlayingSessions() const {
+  std::lock_guard guard(sessions_mutex_);
+  for (const auto &[id, session] : sessions_) {
+    if (session.playing) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+Response ServerServlet::HandleOptions(const Request &request) {
+  // Used by clients as keep-alive too
+  {
+    std::lock_guard guard(sessions_mutex_);
+    (void)FindSession(request);
+  }
+
+  Response response(200, "OK");
+  response.headers["Public"] =
+      "OPTIONS, DESCRIBE, SETUP, PLAY, TEARDOWN, GET_PARAMETER";
+
+  return response;
+}
+
+Response ServerServlet::HandleDescribe() const {
+  std::string parameter_sets;
+  {
+    std::lock_guard guard(sessions_mutex_);
+    parameter_sets = parameter_sets_;
+  }
+
+  std::ostringstream oss;
+  oss << "v=0\r\n"
+      << "o=- " << packetizer_.GetSynchronizationSource()
+      << " 1 IN IP4 0.0.0.0\r\n"
+      << "s=Media Server\r\n"
+      << "t=0 0\r\n"
+      << "a=control:*\r\n"
+      << "m=video 0 RTP/AVP " << +rtp::h264::Packetizer::kPayloadType << "\r\n"
+      << "c=IN IP4 0.0.0.0\r\n"
+      << "a=rtpmap:" << +rtp::h264::Packetizer::kPayloadType
+      << " H264/90000\r\n"
+      << "a=fmtp:" << +rtp::h264::Packetizer::kPayloadType
+      << " packetization-mode=1";
+  // Without them client takes parameter sets from the first key frame
+  if (!parameter_sets.empty()) {
+    oss << ";sprop-parameter-sets=" << parameter_sets;
+  }
+  oss << "\r\n"
+      << "a=control:" << kTrackControl << "\r\n";
+
+  Response response(200, "OK");
+  response.headers["Content-Type"] = "application/sdp";
+  response.body = oss.str();
+
+  return response;
+}
+
+Response ServerServlet::HandleSetup(const Request &request) {
+  if (!request.headers.count(kTransportHeaderName)) {
+    return {400, "Bad Request"};
+  }
+
+  Session session;
+  session.last_request_time = Clock::now();
+  std::string transport;
+  std::ostringstream ssrc_oss;
+  ssrc_oss << std::hex << std::setw(8) << std::setfill('0')
+           << packetizer_.GetSynchronizationSource();
+  try {
+    const std::vector<std::string> parameters =
+        Split(request.headers.at(kTransportHeaderName), ";");
+    const bool interleaved = (parameters.front() == "RTP/AVP/TCP");
+    if (!interleaved && (parameters.front() != "RTP/AVP") &&
+        (parameters.front() != "RTP/AVP/UDP")) {
+      return {461, "Unsupported Transport"};
+    }
+
+    std::optional<int> first_value;
+    const std::string value_name = interleaved ? "interleaved=" : "client_port=";
+    for (const std::string &parameter : parameters) {
+      if (parameter == "multicast") {
+        return {461, "Unsupported Transport"};
+      }
+      if (parameter.compare(0, value_name.size(), value_name) == 0) {
+        first_value = ParseFirstOfPair(parameter.substr(value_name.size()));
+      }
+    }
+
+    if (interleaved) {
+      session.channel = first_value.value_or(0);
+      transport = "RTP/AVP/TCP;unicast;interleaved="s +
+                  std::to_string(session.channel) + "-" +
+                  std::to_string(session.channel + 1);
+    } else {
+      if (!first_value) {
+        return {461, "Unsupported Transport"};
+      }
+      sockaddr_in destination = {};
+      destination.sin_family = AF_INET;
+      destination.sin_port = htons(*first_value);
+      if (inet_pton(AF_INET, request.remote_address.c_str(),
+                    &destination.sin_addr) != 1) {
+        return {400, "Bad Request"};
+      }
+      session.destination = destination;
+      transport = "RTP/AVP;unicast;client_port="s +
+                  std::to_string(*first_value) + "-" +
+                  std::to_string(*first_value + 1) + ";server_port=" +
+                  std::to_string(options_.rtp_port) + "-" +
+                  std::to_string(options_.rtp_port + 1);
+    }
+  } catch (const std::logic_error &) {
+    return {400, "Bad Request"};
+  }
+
+  uint32_t session_id = 0;
+  {
+    std::lock_guard guard(sessions_mutex_);
+    do {
+      session_id = session_id_generator_();
+    } while ((session_id == 0) || sessions_.count(session_id));
+    sessions_.emplace(session_id, std::move(session));
+    sessions_gauge_.Set(sessions_.size());
+  }
+  LOG(kInfo) << "RTSP: Session " << session_id << " is set up for "
+             << request.remote_address;
+
+  Response response(200, "OK");
+  response.headers[kTransportHeaderName] = transport + ";ssrc=" +
+                                           ssrc_oss.str();
+  response.headers[kSessionHeaderName] =
+      std::to_string(session_id) + ";timeout=" +
+      std::to_string(options_.session_timeout.count());
+
+  return response;
+}
+
+Response ServerServlet::HandlePlay(const Request &request) {
+  std::shared_ptr<InterleavedStream> stream_ptr;
+  {
+    std::lock_guard guard(sessions_mutex_);
+    auto it = FindSession(request);
+    if (it == sessions_.end()) {
+      return {454, "Session Not Found"};
+    }
+
+    Session &session = it->second;
+    if (!session.destination && !session.stream_ptr.lock()) {
+      stream_ptr = std::make_shared<InterleavedStream>(
+          *this, session.channel, options_.queue_size, options_.frame_timeout,
+          dropped_frames_counter_);
+      session.stream_ptr = stream_ptr;
+    }
+    session.playing = true;
+  }
+
+  Response response(200, "OK");
+  response.headers[kSessionHeaderName] = request.headers.at(kSessionHeaderName);
+  response.headers["Range"] = "npt=0.000-";
+  // Interleaved packets are sent by the connection thread after response
+  response.body_stream_ptr = std::move(stream_ptr);
+
+  return response;
+}
+
+Response ServerServlet::HandleTeardown(const Request &request) {
+  std::lock_guard guard(sessions_mutex_);
+  auto it = FindSession(request);
+  if (it == sessions_.end()) {
+    return {454, "Session Not Found"};
+  }
+
+  LOG(kInfo) << "RTSP: Session " << it->first << " is torn down";
+  sessions_.erase(it);
+  sessions_gauge_.Set(sessions_.size());
+
+  return {200, "OK"};
+}
+
+Response ServerServlet::HandleGetParameter(const Request &request) {
+  // Used by clients as keep-alive
+  if (request.headers.count(kSessionHeaderName)) {
+    std::lock_guard guard(sessions_mutex_);
+    if (FindSession(request) == sessions_.end()) {
+      return {454, "Session Not Found"};
+    }
+  }
+
+  return {200, "OK"};
+}
+
+std::unordered_map<uint32_t, ServerServlet::Session>::iterator
+ServerServlet::FindSession(const Request &request) {
+  if (!request.headers.count(kSessionHeaderName)) {
+    return sessions_.end();
+  }
+
+  uint32_t session_id = 0;
+  try {
+    session_id = std::stoul(request.headers.at(kSessionHeaderName));
+  } catch (const std::logic_error &) {
+    return sessions_.end();
+  }
+
+  auto it = sessions_.find(session_id);
+  if (it != sessions_.end()) {
+    it->second.last_request_time = Clock::now();
+  }
+
+  return it;
+}
+
+bool ServerServlet::IsExpired(const Session &session,
+                              const Clock::time_point now) const {
+  // Interleaved session lives as long as its connection
+  if (session.playing && !session.destination) {
+    return session.stream_ptr.expired();
+  }
+
+  return now - session.last_request_time > options_.session_timeout;
+}
+
+ServerServlet::InterleavedStream::InterleavedStream(
+    ServerServlet &servlet, const uint8_t channel, const std::size_t queue_size,
+    const std::chrono::milliseconds frame_timeout,
+    metrics::Counter &dropped_frames_counter):
+servlet_(servlet),
+channel_(channel),
+queue_size_(queue_size),
+frame_timeout_(frame_timeout),
+queue_(),
+waiting_for_key_frame_(true),
+queue_mutex_(),
+queue_cv_(),
+last_frame_time_(Clock::now()),
+input_(),
+dropped_frames_counter_(dropped_frames_counter) {
+}
+
+void ServerServlet::InterleavedStream::Push(PacketSetPtr packet_set_ptr) {
+  {
+    std::lock_guard guard(queue_mutex_);
+    if (queue_.size() >= queue_size_) {
+      dropped_frames_counter_.Add(queue_.size());
+      queue_.clear();
+      waiting_for_key_frame_ = true;
+    }
+    if (waiting_for_key_frame_ && !packet_set_ptr->key_frame) {
+      dropped_frames_counter_.Add();
+      return;
+    }
+    waiting_for_key_frame_ = false;
+    queue_.push_back(std::move(packet_set_ptr));
+  }
+  queue_cv_.notify_one();
+}
+
+bool ServerServlet::InterleavedStream::SendNext(sock::Socket &socket) {
+  if (socket.IsReadable() && !HandleInput(socket)) {
+    return false;
+  }
+
+  std::deque<PacketSetPtr> packet_sets;
+  {
+    std::unique_lock lock(queue_mutex_);
+    if (queue_cv_.wait_for(lock, kPollInterval,
+                           [this] { return !queue_.empty(); })) {
+      packet_sets.swap(queue_);
+    }
+  }
+
+  const Clock::time_point now = Clock::now();
+  if (packet_sets.empty()) {
+    return (now - last_frame_time_ <= frame_timeout_);
+  }
+
+  last_frame_time_ = now;
+  SendPackets(socket, packet_sets);
+
+  return true;
+}
+
+bool ServerServlet::InterleavedStream::HandleInput(sock::Socket &socket) {
+  constexpr int kReadSize = 4096;
+  input_ += socket.Read(kReadSize);
+
+  while (!input_.empty()) {
+    // RTCP reports of client aren't used
+    if (input_.front() == kInterleavedMagic) {
+      if (input_.size() < kInterleavedHeaderSize) {
+        break;
+      }
+      const std::size_t size = (static_cast<uint8_t>(input_[2]) << 8) |
+                               static_cast<uint8_t>(input_[3]);
+      if (input_.size() < kInterleavedHeaderSize + size) {
+        break;
+      }
+      input_.erase(0, kInterleavedHeaderSize + size);
+      continue;
+    }
+
+    const std::size_t headers_end = input_.find("\r\n\r\n");
+    if (headers_end == std::string::npos) {
+      break;
+    }
+    Request request = http::ParseRequest<Method, kProtocolName>(
+        input_.substr(0, headers_end + 4));
+    const std::size_t request_size =
+        headers_end + 4 + std::max(http::ExtractContentLength(request.headers),
+                                   0);
+    if (input_.size() < request_size) {
+      break;
+    }
+    request.body = input_.substr(headers_end + 4, request_size - headers_end - 4);
+    request.remote_address = socket.GetPeerName();
+    input_.erase(0, request_size);
+
+    LOG(kDebug) << "RTSP request inside stream:\n" << request;
+    socket << servlet_.Handle(request) << std::endl;
+    if (request.method == Method::kTeardown) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void ServerServlet::InterleavedStream::SendPackets(
+    sock::Socket &socket, const std::deque<PacketSetPtr> &packet_sets) {
+  // All but the last packet are held in kernel, so small packets share TCP
+  // segments
+  for (std::size_t i = 0; i < packet_sets.size(); ++i) {
+    const std::vector<types::Bytes> &packets = packet_sets[i]->packets;
+    for (std::size_t j = 0; j < packets.size(); ++j) {
+      const types::Bytes &packet = packets[j];
+      const bool more = (i + 1 < packet_sets.size()) || (j + 1 < packets.size());
+      const char header[kInterleavedHeaderSize] = {
+          kInterleavedMagic, static_cast<char>(channel_),
+          static_cast<char>(packet.size() >> 8),
+          static_cast<char>(packet.size() & 0xff)};
+      socket.Send(std::string_view(header, sizeof(header)), true);
+      socket.Send(std::string_view(
+                      reinterpret_cast<const char *>(packet.data()),
+                      packet.size()),
+                  more);
+    }
+  }
+}
+
+} // namespace rtsp
@@ -0,0 +1,225 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <netinet/in.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "servlet.h"
+#include "observer.h"
+#include "request.h"
+#include "response.h"
+#include "http/body_stream.h"
+#include "sock/server_socket.h"
+#include "types/h264_frame.h"
+#include "rtp/h264/packetizer.h"
+#include "metrics/registry.h"
+
+namespace rtsp {
+
+/**
+ * @brief Options of RTSP server
+ */
+struct ServerOptions {
+  int rtp_port = 6970; //!< Port to send RTP over UDP from
+  //! UDP session is closed if there are no requests with its id for that time
+  std::chrono::seconds session_timeout{60};
+  //! Max number of frames queued for interleaved session
+  std::size_t queue_size = 90;
+  //! Interleaved session is closed if there are no frames for that time
+  std::chrono::milliseconds frame_timeout{15'000};
+};
+
+/**
+ * @brief Servlet, that re-streams encoded video to RTSP clients
+ * @details Supports DESCRIBE, SETUP, PLAY, TEARDOWN, OPTIONS and GET_PARAMETER
+ * methods. Every frame is packetized once and the same packets are sent to
+ * all sessions: with one sendmmsg(2) call to all UDP sessions and through the
+ * RTSP connection to interleaved TCP sessions. Sessions start from a key frame
+ */
+class ServerServlet : public ::Servlet<Request, Response>,
+                      public Observer<types::H264Frame> {
+ public:
+  /**
+   * @param options Server options
+   */
+  explicit ServerServlet(const ServerOptions &options = ServerOptions());
+
+  [[nodiscard]] Response Handle(const Request &request) override;
+
+  /**
+   * @param frame_ptr H.264 frame to send to all playing sessions
+   */
+  void Receive(DataPtr frame_ptr) override;
+
+  /**
+   * @return True, if at least one session is playing
+   */
+  [[nodiscard]] bool HasPlayingSessions() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  using PacketSetPtr = std::shared_ptr<const rtp::h264::PacketSet>;
+
+  class InterleavedStream;
+
+  /**
+   * @brief State of one client session
+   */
+  struct Session {
+    bool playing = false;
+    bool waiting_for_key_frame = true;
+    //! RTP destination. Empty for interleaved session
+    std::optional<sockaddr_in> destination;
+    uint8_t channel = 0; //!< RTP channel of interleaved session
+    //! Stream of interleaved session. Expires when connection is closed
+    std::weak_ptr<InterleavedStream> stream_ptr;
+    Clock::time_point last_request_time;
+  };
+
+  const ServerOptions options_;
+  rtp::h264::Packetizer packetizer_; //!< Used only by Receive()
+  sock::ServerSocket rtp_socket_;
+  sock::DatagramSendBatch send_batch_; //!< Used only by Receive()
+  std::unordered_map<uint32_t, Session> sessions_;
+  std::string parameter_sets_; //!< SPS and PPS for SDP
+  std::mt19937 session_id_generator_;
+  mutable std::mutex sessions_mutex_; //!< Mutex for all fields above
+  metrics::Gauge &sessions_gauge_;
+  metrics::Counter &sent_packets_counter_;
+  metrics::Counter &dropped_frames_counter_;
+  metrics::Histogram &send_latency_;
+
+  [[nodiscard]] Response HandleOptions(const Request &request);
+
+  [[nodiscard]] Response HandleDescribe() const;
+
+  [[nodiscard]] Response HandleSetup(const Request &request);
+
+  [[nodiscard]] Response HandlePlay(const Request &request);
+
+  [[nodiscard]] Response HandleTeardown(const Request &request);
+
+  [[nodiscard]] Response HandleGetParameter(const Request &request);
+
+  /**
+   * @brief Find session by "Session" header and postpone its expiration
+   * @details sessions_mutex_ must be locked
+   *
+   * @param request Request with "Session" header
+   * @return Iterator to session
+   * @return sessions_.end() if there is no such session
+   */
+  std::unordered_map<uint32_t, Session>::iterator FindSession(
+      const Request &request);
+
+  /**
+   * @brief Check if session should be closed
+   *
+   * @param session Session to check
+   * @param now Current time
+   * @return True, if session is expired
+   */
+  [[nodiscard]] bool IsExpired(const Session &session,
+                               Clock::time_point now) const;
+};
+
+/**
+ * @brief Interleaved RTP stream inside RTSP connection
+ * @details Packets are sent by the connection thread, so it also answers
+ * requests, that come through the connection while stream is sent
+ */
+class ServerServlet::InterleavedStream : public http::BodyStream {
+ public:
+  /**
+   * @param servlet Servlet to handle requests
+   * @param channel RTP channel
+   * @param queue_size Max number of queued frames
+   * @param frame_timeout Max time without frames before stream is finished
+   * @param dropped_frames_counter Counter of frames not sent because of queue
+   * overflow
+   */
+  InterleavedStream(ServerServlet &servlet, uint8_t channel,
+                    std::size_t queue_size,
+                    std::chrono::milliseconds frame_timeout,
+                    metrics::Counter &dropped_frames_counter);
+
+  InterleavedStream(const InterleavedStream &) = delete;
+  InterleavedStream &operator=(const InterleavedStream &) = delete;
+
+  /**
+   * @brief Queue frame packets. If queue is full, drop it with all frames
+   * until the next key frame
+   *
+   * @param packet_set_ptr Packets of frame
+   */
+  void Push(PacketSetPtr packet_set_ptr);
+
+  bool SendNext(sock::Socket &socket) override;
+
+ private:
+  //! Max time to wait for frames before checking for client requests
+  static constexpr std::chrono::milliseconds kPollInterval{100};
+
+  ServerServlet &servlet_;
+  const uint8_t channel_;
+  const std::size_t queue_size_;
+  const std::chrono::milliseconds frame_timeout_;
+  std::deque<PacketSetPtr> queue_; //!< Frames to send
+  bool waiting_for_key_frame_; //!< True, if frames are dropped until key frame
+  std::mutex queue_mutex_; //!< Mutex for queue_ and waiting_for_key_frame_
+  std::condition_variable queue_cv_; //!< Notified on new frame
+  Clock::time_point last_frame_time_; //!< Time, when frame was last sent
+  std::string input_; //!< Received data, that isn't processed yet
+  metrics::Counter &dropped_frames_counter_;
+
+  /**
+   * @brief Read data from client, skip RTCP packets and answer requests
+   *
+   * @param socket Client socket
+   * @return False, if session was torn down
+   */
+  bool HandleInput(sock::Socket &socket);
+
+  /**
+   * @brief Send packets as interleaved binary data
+   *
+   * @param socket Client socket
+   * @param packet_sets Frames to send
+   */
+  void SendPackets(sock::Socket &socket,
+                   const std::deque<PacketSetPtr> &packet_sets);
+};
+
+} // namespace rtsp
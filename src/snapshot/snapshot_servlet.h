@@ -0,0 +1,226 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+
+#include "servlet.h"
+#include "http/request.h"
+#include "http/response.h"
+#include "observer.h"
+#include "split.h"
+#include "types/mjpeg_frame.h"
+#include "metrics/registry.h"
+
+namespace snapshot {
+
+const char kContentLengthHeaderName[] = "Content-Length";
+const char kContentTypeHeaderName[] = "Content-Type";
+const char kETagHeaderName[] = "ETag";
+const char kIfNoneMatchHeaderName[] = "If-None-Match";
+const std::regex kHistoryPathRegex("^/(\\d+)\\.jpg$");
+
+/**
+ * @brief Servlet, that serves the latest received JPEG frame as is
+ * @details Frames are kept by pointer, so no decoding, encoding or copying is
+ * done on receive. Empty url returns the latest frame, "/<sequence>.jpg" -
+ * one of the last frames by its sequence number. Sequence number is a part of
+ * ETag, so unchanged frames are answered with 304
+ */
+class Servlet : public ::Servlet<http::Request, http::Response>,
+                public Observer<types::MjpegFrame> {
+  using FramePtr = Observer<types::MjpegFrame>::DataPtr;
+
+ public:
+  /**
+   * @param history_size Number of last frames, available by sequence number
+   * @param max_age Max time since the frame ingest to serve it as the latest
+   */
+  Servlet(std::size_t history_size, std::chrono::milliseconds max_age):
+  history_size_(history_size),
+  max_age_(max_age),
+  latest_snapshot_ptr_(),
+  history_(),
+  history_mutex_(),
+  next_sequence_number_(0),
+  served_counter_(metrics::Registry::GetInstance().GetCounter(
+      "snapshots_served_total", "Number of snapshots sent to clients")),
+  not_modified_counter_(metrics::Registry::GetInstance().GetCounter(
+      "snapshots_not_modified_total", "Number of snapshot requests answered "
+      "with 304 Not Modified")) {
+  }
+
+  [[nodiscard]] http::Response Handle(const http::Request &request) override {
+    if (request.method != http::Method::kGet) {
+      return {501, "Not Implemented"};
+    }
+
+    if (request.url.empty()) {
+      return GetLatest(request);
+    }
+
+    std::smatch matches;
+    if (std::regex_match(request.url, matches, kHistoryPathRegex)) {
+      return GetFromHistory(request, std::stoull(matches[1].str()));
+    }
+
+    return {404, "Not Found"};
+  }
+
+  /**
+   * @param frame_ptr JPEG frame. Kept without copying
+   */
+  void Receive(FramePtr frame_ptr) override {
+    auto snapshot_ptr = std::make_shared<const Snapshot>(
+        Snapshot{next_sequence_number_++, std::move(frame_ptr)});
+
+    {
+      std::lock_guard guard(history_mutex_);
+      history_.push_back(snapshot_ptr);
+      if (history_.size() > history_size_) {
+        history_.pop_front();
+      }
+    }
+
+    std::atomic_store(&latest_snapshot_ptr_, std::move(snapshot_ptr));
+  }
+
+ private:
+  struct Snapshot {
+    uint64_t sequence_number;
+    FramePtr frame_ptr;
+  };
+  using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+  const std::size_t history_size_;
+  const std::chrono::milliseconds max_age_;
+  //! Latest frame. Swapped atomically, so requests don't wait for Receive()
+  SnapshotPtr latest_snapshot_ptr_;
+  std::deque<SnapshotPtr> history_;
+  mutable std::mutex history_mutex_;
+  //! Only Receive() changes it, and frames are received from one thread
+  uint64_t next_sequence_number_;
+  metrics::Counter &served_counter_;
+  metrics::Counter &not_modified_counter_;
+
+  [[nodiscard]] http::Response GetLatest(const http::Request &request) {
+    const SnapshotPtr snapshot_ptr = std::atomic_load(&latest_snapshot_ptr_);
+    // Frame left from the previous pipeline run isn't a snapshot anymore
+    if (!snapshot_ptr ||
+        (types::Clock::now() - snapshot_ptr->frame_ptr->ingest_time > max_age_)) {
+      http::Response response(503, "Service Unavailable");
+      response.headers["Retry-After"] = "1";
+      response.headers[kContentLengthHeaderName] = "0";
+      return response;
+    }
+
+    return MakeResponse(request, *snapshot_ptr);
+  }
+
+  [[nodiscard]] http::Response GetFromHistory(const http::Request &request,
+                                              const uint64_t sequence_number) {
+    SnapshotPtr snapshot_ptr;
+    {
+      std::lock_guard guard(history_mutex_);
+      for (const auto &history_snapshot_ptr : history_) {
+        if (history_snapshot_ptr->sequence_number == sequence_number) {
+          snapshot_ptr = history_snapshot_ptr;
+          break;
+        }
+      }
+    }
+
+    if (!snapshot_ptr) {
+      return {404, "Not Found"};
+    }
+
+    return MakeResponse(request, *snapshot_ptr);
+  }
+
+  [[nodiscard]] http::Response MakeResponse(const http::Request &request,
+                                            const Snapshot &snapshot) {
+    const std::string etag = MakeETag(snapshot);
+
+    http::Response response;
+    response.headers[kETagHeaderName] = etag;
+    response.headers["Cache-Control"] = "no-cache";
+    if (IsETagMatched(request, etag)) {
+      not_modified_counter_.Add();
+      response.code = 304;
+      response.description = "Not Modified";
+      return response;
+    }
+
+    // Frame is sent from the shared data without copying
+    const types::Bytes &data = snapshot.frame_ptr->data;
+    served_counter_.Add();
+    response.code = 200;
+    response.description = "OK";
+    response.headers[kContentTypeHeaderName] = "image/jpeg";
+    response.body_buffer = types::SharedBuffer(snapshot.frame_ptr, data.data(),
+                                               data.size());
+    response.headers[kContentLengthHeaderName] =
+        std::to_string(data.size());
+
+    return response;
+  }
+
+  /**
+   * @brief RTP timestamp is random for every session, so ETag stays unique if
+   * the sequence numbers start over after the server restart
+   */
+  [[nodiscard]] static std::string MakeETag(const Snapshot &snapshot) {
+    return "\"" + std::to_string(snapshot.sequence_number) + "-" +
+           std::to_string(snapshot.frame_ptr->timestamp) + "\"";
+  }
+
+  [[nodiscard]] static bool IsETagMatched(const http::Request &request,
+                                          const std::string &etag) {
+    auto it = request.headers.find(kIfNoneMatchHeaderName);
+    if (it == request.headers.end()) {
+      return false;
+    }
+
+    for (std::string tag : Split(it->second, ",")) {
+      tag.erase(0, tag.find_first_not_of(' '));
+      tag.erase(tag.find_last_not_of(' ') + 1);
+      if (tag.compare(0, 2, "W/") == 0) {
+        tag.erase(0, 2);
+      }
+      if ((tag == "*") || (tag == etag)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+};
+
+} // namespace snapshot
@@ -0,0 +1,112 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "datagram_batch.h"
+
+#include <algorithm>
+
+namespace sock {
+
+DatagramBatch::DatagramBatch(const std::size_t capacity,
+                             const std::size_t max_datagram_size) :
+max_datagram_size_(max_datagram_size),
+buffers_(capacity, types::Bytes(max_datagram_size)),
+iovecs_(capacity),
+headers_(capacity),
+size_(0) {
+  for (std::size_t i = 0; i < capacity; ++i) {
+    iovecs_[i].iov_base = buffers_[i].data();
+    iovecs_[i].iov_len = max_datagram_size_;
+  }
+  Reset();
+}
+
+std::size_t DatagramBatch::GetCapacity() const {
+  return buffers_.size();
+}
+
+std::size_t DatagramBatch::GetSize() const {
+  return size_;
+}
+
+const types::Bytes &DatagramBatch::GetDatagram(const std::size_t index) const {
+  return buffers_.at(index);
+}
+
+bool DatagramBatch::IsTruncated(const std::size_t index) const {
+  return headers_.at(index).msg_hdr.msg_flags & MSG_TRUNC;
+}
+
+void DatagramBatch::Reset() {
+  for (std::size_t i = 0; i < size_; ++i) {
+    // Capacity isn't changed, so iovecs_ stay valid
+    buffers_[i].resize(max_datagram_size_);
+  }
+  for (std::size_t i = 0; i < headers_.size(); ++i) {
+    headers_[i] = {};
+    headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+    headers_[i].msg_hdr.msg_iovlen = 1;
+  }
+  size_ = 0;
+}
+
+void DatagramBatch::Commit(const std::size_t size) {
+  size_ = size;
+  for (std::size_t i = 0; i < size_; ++i) {
+    buffers_[i].resize(std::min<std::size_t>(headers_[i].msg_len,
+                                             max_datagram_size_));
+  }
+}
+
+void DatagramSendBatch::Add(const types::Bytes &datagram,
+                            const sockaddr_in &destination) {
+  iovec vec;
+  vec.iov_base = const_cast<types::Byte *>(datagram.data());
+  vec.iov_len = datagram.size();
+  iovecs_.push_back(vec);
+  destinations_.push_back(destination);
+}
+
+void DatagramSendBatch::Clear() {
+  iovecs_.clear();
+  destinations_.clear();
+}
+
+std::size_t DatagramSendBatch::GetSize() const {
+  return iovecs_.size();
+}
+
+void DatagramSendBatch::Prepare() {
+  // Vectors could be reallocated by Add(), so pointers are set only here
+  headers_.resize(iovecs_.size());
+  for (std::size_t i = 0; i < headers_.size(); ++i) {
+    headers_[i] = {};
+    headers_[i].msg_hdr.msg_name = &destinations_[i];
+    headers_[i].msg_hdr.msg_namelen = sizeof(destinations_[i]);
+    headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+    headers_[i].msg_hdr.msg_iovlen = 1;
+  }
+}
+
+} // namespace sock
@@ -0,0 +1,151 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "types/byte.h"
+
+namespace sock {
+
+/**
+ * @brief Preallocated set of buffers to receive several datagrams with one
+ * recvmmsg(2) call
+ * @details Buffers are allocated once and reused between calls, so receiving
+ * doesn't allocate memory
+ */
+class DatagramBatch {
+ public:
+  /**
+   * @param capacity Max number of datagrams to receive with one call
+   * @param max_datagram_size Max size of one datagram. Longer datagrams are truncated
+   */
+  DatagramBatch(std::size_t capacity, std::size_t max_datagram_size);
+
+  DatagramBatch(const DatagramBatch &) = delete;
+  DatagramBatch &operator=(const DatagramBatch &) = delete;
+
+  /**
+   * @brief Get max number of datagrams to receive with one call
+   *
+   * @return Capacity
+   */
+  [[nodiscard]] std::size_t GetCapacity() const;
+
+  /**
+   * @brief Get number of datagrams received by the last call
+   *
+   * @return Number of datagrams
+   */
+  [[nodiscard]] std::size_t GetSize() const;
+
+  /**
+   * @brief Get received datagram
+   *
+   * @param index Index of datagram, less than GetSize()
+   * @return Bytes of datagram
+   */
+  [[nodiscard]] const types::Bytes &GetDatagram(std::size_t index) const;
+
+  /**
+   * @brief Check if datagram was longer than buffer and was truncated
+   *
+   * @param index Index of datagram, less than GetSize()
+   * @return true if datagram was truncated
+   */
+  [[nodiscard]] bool IsTruncated(std::size_t index) const;
+
+ private:
+  friend class Socket;
+
+  const std::size_t max_datagram_size_; //!< Size of each buffer
+  std::vector<types::Bytes> buffers_; //!< Buffers for datagrams
+  std::vector<iovec> iovecs_; //!< I/O vectors pointing to buffers_
+  std::vector<mmsghdr> headers_; //!< Headers for recvmmsg()
+  std::size_t size_; //!< Number of received datagrams
+
+  /**
+   * @brief Restore buffers size and headers before the next receiving
+   */
+  void Reset();
+
+  /**
+   * @brief Shrink buffers to the size of received datagrams
+   *
+   * @param size Number of received datagrams
+   */
+  void Commit(std::size_t size);
+};
+
+/**
+ * @brief Set of datagrams to send with one sendmmsg(2) call
+ * @details Datagrams aren't copied, so they must live until batch is sent.
+ * Buffers are reused between calls after Clear()
+ */
+class DatagramSendBatch {
+ public:
+  DatagramSendBatch() = default;
+
+  DatagramSendBatch(const DatagramSendBatch &) = delete;
+  DatagramSendBatch &operator=(const DatagramSendBatch &) = delete;
+
+  /**
+   * @brief Add datagram to send
+   *
+   * @param datagram Bytes of datagram
+   * @param destination Address to send datagram to
+   */
+  void Add(const types::Bytes &datagram, const sockaddr_in &destination);
+
+  /**
+   * @brief Remove all datagrams
+   */
+  void Clear();
+
+  /**
+   * @brief Get number of datagrams to send
+   *
+   * @return Number of datagrams
+   */
+  [[nodiscard]] std::size_t GetSize() const;
+
+ private:
+  friend class Socket;
+
+  std::vector<iovec> iovecs_; //!< I/O vectors pointing to datagrams
+  std::vector<sockaddr_in> destinations_; //!< Destination of every datagram
+  std::vector<mmsghdr> headers_; //!< Headers for sendmmsg()
+
+  /**
+   * @brief Point headers to iovecs_ and destinations_ before sending
+   */
+  void Prepare();
+};
+
+} // namespace sock
@@ -35,7 +35,8 @@ SOFTWARE.
 
 namespace sock {
 
-ServerSocket::ServerSocket(Type type, int port_number) :
+ServerSocket::ServerSocket(Type type, int port_number, const int backlog,
+                           const bool reuse_port) :
 Socket(type),
 port_number_(port_number) {
   if (GetType() == Type::kTcp) {
@@ -52,12 +53,17 @@ port_number_(port_number) {
 
   int opt = 1;
   setsockopt(descriptor_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+  if (reuse_port &&
+      setsockopt(descriptor_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+    throw ServerSocketException(std::string("Can't set SO_REUSEPORT: ") +
+                                strerror(errno));
+  }
 
   if (bind(descriptor_, reinterpret_cast<sockaddr *>(&server_addr), sizeof(server_addr)) < 0) {
     throw BindError(std::string("Can't bind socket: ") + strerror(errno));
   }
 
-  if ((GetType() == Type::kTcp) && listen(descriptor_, 1) < 0) {
+  if ((GetType() == Type::kTcp) && listen(descriptor_, backlog) < 0) {
     throw ListenError(std::string("Listen: ") + strerror(errno));
   }
 }
@@ -67,7 +73,7 @@ int ServerSocket::GetPortNumber() const {
 }
 
 Socket ServerSocket::Accept() const {
-  int client_descriptor = accept(descriptor_, nullptr, nullptr);
+  int client_descriptor = accept4(descriptor_, nullptr, nullptr, SOCK_CLOEXEC);
   if (client_descriptor < 0) {
     throw AcceptError(std::string("Can't accept client: ") + strerror(errno));
   }
@@ -36,14 +36,21 @@ namespace sock {
  */
 class ServerSocket : public Socket {
  public:
+  //! Default size of pending connections queue
+  static constexpr int kDefaultBacklog = 128;
+
   /**
    * @brief Construct a new ServerSocket object
    * @details Invoke system calls to bind() and listen()
    *
    * @param type Type of the ServerSocket
    * @param port_number Port of the ServerSocket
+   * @param backlog Max length of pending connections queue. Used only for TCP
+   * @param reuse_port If true, several sockets can be bound to the same port
+   * with SO_REUSEPORT. Kernel load-balances new connections across them
    */
-  ServerSocket(Type type, int port_number);
+  ServerSocket(Type type, int port_number, int backlog = kDefaultBacklog,
+               bool reuse_port = false);
 
   /**
    * @brief Get port number
@@ -54,6 +61,7 @@ class ServerSocket : public Socket {
 
   /**
    * @brief Accept client
+   * @details Client socket is created with close-on-exec flag
    *
    * @return Socket associated with client
    */
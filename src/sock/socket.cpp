@@ -24,8 +24,11 @@ SOFTWARE.
 
 #include "socket.h"
 
+#include <cerrno>
 #include <cstring>
 #include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <poll.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -39,7 +42,8 @@ namespace sock {
 Socket::Socket(Type type):
 descriptor_(0),
 type_(type),
-is_moved_(false) {
+is_moved_(false),
+sent_byte_count_(0) {
   int real_type = 0;
   switch (type) {
     case Type::kTcp:
@@ -52,7 +56,7 @@ is_moved_(false) {
       real_type = 0;
   }
 
-  descriptor_ = socket(AF_INET, real_type, 0);
+  descriptor_ = socket(AF_INET, real_type | SOCK_CLOEXEC, 0);
   if (descriptor_ == -1) {
     throw SocketException("Can't create socket");
   }
@@ -60,7 +64,8 @@ is_moved_(false) {
 
 Socket::Socket(int descriptor) :
 descriptor_(descriptor),
-is_moved_(false) {
+is_moved_(false),
+sent_byte_count_(0) {
   int type;
   socklen_t length = sizeof(type);
   getsockopt(descriptor_, SOL_SOCKET, SO_TYPE, &type, &length);
@@ -70,7 +75,8 @@ is_moved_(false) {
 Socket::Socket(Socket &&other) :
 descriptor_(other.descriptor_),
 type_(other.type_),
-is_moved_(false) {
+is_moved_(false),
+sent_byte_count_(other.sent_byte_count_) {
   other.is_moved_ = true;
 }
 
@@ -100,6 +106,30 @@ std::string Socket::GetPeerName() const {
   return inet_ntoa(peer_addr.sin_addr);
 }
 
+uint64_t Socket::GetSentByteCount() const {
+  return sent_byte_count_;
+}
+
+void Socket::SetTimeouts(const std::chrono::milliseconds read_timeout,
+                         const std::chrono::milliseconds write_timeout) {
+  const auto to_timeval = [] (const std::chrono::milliseconds timeout) {
+    timeval tv;
+    tv.tv_sec = timeout.count() / 1000;
+    tv.tv_usec = (timeout.count() % 1000) * 1000;
+    return tv;
+  };
+
+  const timeval read_tv = to_timeval(read_timeout);
+  const timeval write_tv = to_timeval(write_timeout);
+  if ((setsockopt(descriptor_, SOL_SOCKET, SO_RCVTIMEO, &read_tv,
+                  sizeof(read_tv)) < 0) ||
+      (setsockopt(descriptor_, SOL_SOCKET, SO_SNDTIMEO, &write_tv,
+                  sizeof(write_tv)) < 0)) {
+    throw SocketException(std::string("Can't set socket timeouts: ") +
+                          strerror(errno));
+  }
+}
+
 std::string Socket::Read(int n) {
   auto buf_ptr = std::make_unique<char[]>(n);
   sockaddr_in their_addr;
@@ -119,13 +149,67 @@ std::string Socket::Read(int n) {
   return {buf_ptr.get(), buf_ptr.get() + res};
 }
 
+std::size_t Socket::Receive(DatagramBatch &batch) {
+  batch.Reset();
 
-void Socket::Send(std::string_view str) {
-  if (send(descriptor_, str.data(), str.length(), 0) < 0) {
-    throw SendError(strerror(errno));
+  int res = recvmmsg(descriptor_, batch.headers_.data(), batch.headers_.size(),
+                     MSG_WAITFORONE, nullptr);
+  if (res < 0) {
+    if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
+      return 0;
+    }
+    throw ReadError(strerror(errno));
+  }
+
+  batch.Commit(res);
+  return res;
+}
+
+void Socket::Send(std::string_view str, const bool more) {
+  const int flags = more ? MSG_MORE : 0;
+  while (!str.empty()) {
+    ssize_t res = send(descriptor_, str.data(), str.length(), flags);
+    if (res < 0) {
+      throw SendError(strerror(errno));
+    }
+    sent_byte_count_ += res;
+    str.remove_prefix(res);
   }
 }
 
+std::size_t Socket::Send(DatagramSendBatch &batch) {
+  batch.Prepare();
+
+  std::size_t sent_count = 0;
+  std::size_t index = 0;
+  while (index < batch.headers_.size()) {
+    int res = sendmmsg(descriptor_, &batch.headers_[index],
+                       batch.headers_.size() - index, 0);
+    if (res < 0) {
+      if (errno != EINTR) {
+        ++index; // sendmmsg() fails on the first datagram only
+      }
+      continue;
+    }
+
+    for (int i = 0; i < res; ++i) {
+      sent_byte_count_ += batch.headers_[index + i].msg_len;
+    }
+    index += res;
+    sent_count += res;
+  }
+
+  return sent_count;
+}
+
+bool Socket::IsReadable() const {
+  pollfd poll_fd = {};
+  poll_fd.fd = descriptor_;
+  poll_fd.events = POLLIN;
+
+  return (poll(&poll_fd, 1, 0) > 0);
+}
+
 void Socket::SendTo(const types::Bytes &bytes, const std::string &ip, int port) {
   sockaddr_in their_addr;
   their_addr.sin_family = AF_INET;
@@ -139,11 +223,31 @@ void Socket::SendTo(const types::Bytes &bytes, const std::string &ip, int port)
   if (res < 0) {
     throw SendError(strerror(errno));
   }
+  sent_byte_count_ += res;
+}
+
+void Socket::SendFile(const int file_descriptor, const std::size_t count) {
+  off_t offset = 0;
+  while (static_cast<std::size_t>(offset) < count) {
+    ssize_t res = sendfile(descriptor_, file_descriptor, &offset,
+                           count - offset);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw SendError(strerror(errno));
+    }
+    if (res == 0) {
+      throw SendError("File is shorter than expected");
+    }
+    sent_byte_count_ += res;
+  }
 }
 
 Socket &Socket::operator=(Socket &&other) {
   descriptor_ = other.descriptor_;
   type_ = other.type_;
+  sent_byte_count_ = other.sent_byte_count_;
   other.is_moved_ = true;
 
   return *this;
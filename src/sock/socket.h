@@ -24,12 +24,14 @@ SOFTWARE.
 
 #pragma once
 
+#include <chrono>
 #include <string>
 #include <string_view>
 #include <sstream>
 #include <ostream>
 
 #include "types/byte.h"
+#include "datagram_batch.h"
 
 namespace sock {
 
@@ -85,6 +87,23 @@ class Socket {
    */
   std::string GetPeerName() const;
 
+  /**
+   * @brief Get number of bytes sent through this socket
+   *
+   * @return Number of sent bytes
+   */
+  uint64_t GetSentByteCount() const;
+
+  /**
+   * @brief Set timeouts for blocking read and write operations
+   * @details Operation, that doesn't complete in time, throws ReadError or SendError
+   *
+   * @param read_timeout Read timeout. Zero means no timeout
+   * @param write_timeout Write timeout. Zero means no timeout
+   */
+  void SetTimeouts(std::chrono::milliseconds read_timeout,
+                   std::chrono::milliseconds write_timeout);
+
   /**
    * @brief Read n chars
    *
@@ -93,12 +112,44 @@ class Socket {
    */
   std::string Read(int n = 256);
 
+  /**
+   * @brief Receive several datagrams with one recvmmsg(2) system call
+   * @details Blocks until at least one datagram is available, then takes all
+   * already queued datagrams without blocking
+   * @throw ReadError if receiving failed
+   *
+   * @param batch Batch to receive datagrams into
+   * @return Number of received datagrams
+   * @return 0 if read timeout expired or call was interrupted
+   */
+  std::size_t Receive(DatagramBatch &batch);
+
   /**
    * @brief Send string
+   * @details Blocks until the whole string is sent
    *
    * @param str string to be sent
+   * @param more If true, data is held in kernel to be sent together with the
+   * next call, like with MSG_MORE. Saves a small TCP segment for headers
    */
-  void Send(std::string_view str);
+  void Send(std::string_view str, bool more = false);
+
+  /**
+   * @brief Send several datagrams with one sendmmsg(2) system call
+   * @details Datagram, that can't be sent, is skipped, so one bad destination
+   * doesn't prevent sending to others
+   *
+   * @param batch Batch of datagrams to send
+   * @return Number of sent datagrams
+   */
+  std::size_t Send(DatagramSendBatch &batch);
+
+  /**
+   * @brief Check if there is data to read without blocking
+   *
+   * @return True, if read wouldn't block
+   */
+  [[nodiscard]] bool IsReadable() const;
 
   /**
    * @brief Send bytes
@@ -109,6 +160,14 @@ class Socket {
    */
   void SendTo(const types::Bytes &bytes, const std::string &ip, int port);
 
+  /**
+   * @brief Send file content with sendfile(2) without copying it to user space
+   *
+   * @param file_descriptor Descriptor of file opened for reading
+   * @param count Number of bytes to send from the beginning of file
+   */
+  void SendFile(int file_descriptor, std::size_t count);
+
   Socket &operator=(Socket &&other);
 
  protected:
@@ -122,6 +181,7 @@ class Socket {
 
   Type type_; //!< Socket type
   bool is_moved_; //!< True, if Socket was moved
+  uint64_t sent_byte_count_; //!< Number of bytes sent through socket
   std::ostringstream ss_buffer_; //!< Buffer for operator<<
 };
 
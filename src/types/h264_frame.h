@@ -24,7 +24,8 @@ SOFTWARE.
 
 #pragma once
 
-#include "byte.h"
+#include "shared_buffer.h"
+#include "timestamp.h"
 
 namespace types {
 
@@ -34,7 +35,10 @@ namespace types {
 struct H264Frame {
   int64_t pts = 0;
   int64_t dts = 0;
-  Bytes data;
+  bool key_frame = false; //!< True, if frame is IDR and decoding can start on it
+  //! Encoded data. Shared by all observers, so it must not be modified
+  SharedBuffer data;
+  Timestamp ingest_time; //!< Ingest time of the source frame
 };
 
 } // namespace types
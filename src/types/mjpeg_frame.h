@@ -25,6 +25,7 @@ SOFTWARE.
 #pragma once
 
 #include "byte.h"
+#include "timestamp.h"
 
 namespace types {
 
@@ -37,6 +38,9 @@ struct MjpegFrame {
   }
 
   Bytes data;
+  //! RTP timestamp in 90 kHz units, extended to 64 bits to survive wraparound
+  int64_t timestamp = 0;
+  Timestamp ingest_time; //!< Arrival time of the first RTP packet of frame
 };
 
 } // namespace types
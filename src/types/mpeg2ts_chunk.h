@@ -25,6 +25,7 @@ SOFTWARE.
 #pragma once
 
 #include "byte.h"
+#include "timestamp.h"
 
 namespace types {
 
@@ -36,6 +37,7 @@ struct Mpeg2TsChunk {
   uint64_t media_sequence_number = 0;
   float duration = 0;
   Bytes data;
+  Timestamp ingest_time; //!< Ingest time of the last frame in chunk
 };
 
 } // namespace types
@@ -0,0 +1,45 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "shared_buffer.h"
+#include "timestamp.h"
+
+namespace types {
+
+/**
+ * @brief Struct representing MPEG2-TS packets of one frame of a continuous
+ * stream to use with Observer and Provider classes
+ */
+struct Mpeg2TsFragment {
+  //! TS packets. Shared by all observers, so it must not be modified
+  SharedBuffer data;
+  //! True, if fragment starts with PAT, PMT and IDR frame, so playback can
+  //! start from it
+  bool key_frame = false;
+  Timestamp ingest_time; //!< Ingest time of the source frame
+};
+
+} // namespace types
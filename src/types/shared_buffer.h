@@ -0,0 +1,91 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <memory>
+
+#include "byte.h"
+
+namespace types {
+
+/**
+ * @brief Read-only bytes kept alive by a shared reference-counted owner
+ * @details Copying only increments reference count, so data produced by a
+ * library (e.g. encoded AVPacket) can be passed to several observers without
+ * copying it into Bytes
+ */
+class SharedBuffer {
+ public:
+  SharedBuffer() = default;
+
+  /**
+   * @param owner_ptr Object, that owns data
+   * @param data Pointer to data inside owner
+   * @param size Size of data
+   */
+  SharedBuffer(std::shared_ptr<const void> owner_ptr, const Byte *data,
+               const std::size_t size):
+  owner_ptr_(std::move(owner_ptr)),
+  data_(data),
+  size_(size) {
+  }
+
+  /**
+   * @param bytes Bytes to take ownership of
+   */
+  explicit SharedBuffer(Bytes bytes) {
+    auto bytes_ptr = std::make_shared<const Bytes>(std::move(bytes));
+    data_ = bytes_ptr->data();
+    size_ = bytes_ptr->size();
+    owner_ptr_ = std::move(bytes_ptr);
+  }
+
+  [[nodiscard]] const Byte *data() const {
+    return data_;
+  }
+
+  [[nodiscard]] std::size_t size() const {
+    return size_;
+  }
+
+  [[nodiscard]] bool empty() const {
+    return size_ == 0;
+  }
+
+  [[nodiscard]] const Byte *begin() const {
+    return data_;
+  }
+
+  [[nodiscard]] const Byte *end() const {
+    return data_ + size_;
+  }
+
+ private:
+  std::shared_ptr<const void> owner_ptr_;
+  const Byte *data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+} // namespace types
@@ -0,0 +1,80 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "http_client.h"
+
+namespace load_generator {
+
+using namespace std::string_literals;
+
+HttpClient::HttpClient(std::string ip, const int port,
+                       const std::chrono::milliseconds timeout) :
+ip_(std::move(ip)),
+port_(port),
+timeout_(timeout),
+socket_ptr_(),
+connection_count_(0) {
+}
+
+http::Response HttpClient::Get(const std::string &path) {
+  if (!socket_ptr_) {
+    Connect();
+  }
+
+  http::Request request;
+  request.method = http::Method::kGet;
+  request.url = path;
+  request.version = 1.1;
+  request.headers["Host"] = ip_ + ":" + std::to_string(port_);
+  request.headers["Connection"] = "keep-alive";
+
+  http::Response response;
+  try {
+    (*socket_ptr_) << request << std::endl;
+    (*socket_ptr_) >> response;
+  } catch (const std::runtime_error &) {
+    socket_ptr_.reset();
+    throw;
+  }
+
+  return response;
+}
+
+uint64_t HttpClient::GetConnectionCount() const {
+  return connection_count_;
+}
+
+void HttpClient::Connect() {
+  auto socket_ptr = std::make_unique<sock::ClientSocket>(sock::Type::kTcp);
+  if (!socket_ptr->Connect(ip_, port_)) {
+    throw std::runtime_error("Can't connect to "s + ip_ + ":" +
+                             std::to_string(port_));
+  }
+  socket_ptr->SetTimeouts(timeout_, timeout_);
+
+  socket_ptr_ = std::move(socket_ptr);
+  ++connection_count_;
+}
+
+} // namespace load_generator
@@ -0,0 +1,78 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "sock/client_socket.h"
+#include "http/request.h"
+#include "http/response.h"
+
+namespace load_generator {
+
+/**
+ * @brief HTTP client, that keeps connection alive between requests
+ */
+class HttpClient {
+ public:
+  /**
+   * @param ip Server ip address
+   * @param port Server port
+   * @param timeout Max time of one read or write
+   */
+  HttpClient(std::string ip, int port, std::chrono::milliseconds timeout);
+
+  /**
+   * @brief Send GET request. Connects to the server if needed
+   * @details Connection is closed after error and reopened by the next request
+   * @throw std::runtime_error if connection failed or server closed it
+   *
+   * @param path Path to request
+   * @return Server response with any code
+   */
+  http::Response Get(const std::string &path);
+
+  /**
+   * @return Number of connections established since creation
+   */
+  [[nodiscard]] uint64_t GetConnectionCount() const;
+
+ private:
+  const std::string ip_;
+  const int port_;
+  const std::chrono::milliseconds timeout_;
+  std::unique_ptr<sock::ClientSocket> socket_ptr_; //!< nullptr if not connected
+  uint64_t connection_count_;
+
+  /**
+   * @brief Open new connection
+   * @throw std::runtime_error if server is unreachable
+   */
+  void Connect();
+};
+
+} // namespace load_generator
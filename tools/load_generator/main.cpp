@@ -0,0 +1,276 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <getopt.h>
+
+#include <csignal>
+#include <cstdlib>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logging/logger.h"
+#include "http_client.h"
+#include "statistics.h"
+#include "viewer.h"
+
+namespace {
+
+volatile bool stop_flag = false;
+
+const char kDefaultIp[] = "127.0.0.1";
+const int kDefaultPort = 8080;
+const int kDefaultViewerCount = 10;
+const int kDefaultDurationSec = 60;
+const int kDefaultRampUpSec = 10;
+const int kDefaultTimeoutSec = 10;
+const char kDefaultPlaylistPath[] = "/playlist.m3u";
+const char kDefaultMetricsPath[] = "/metrics";
+const char kCpuMetricName[] = "media_server_process_cpu_seconds_total ";
+
+void SignalHandler(int) {
+  stop_flag = true;
+}
+
+void PrintUsage(const char *program_name) {
+  std::cerr << "Usage: " << program_name << " [options]\n"
+            << "Simulates HLS viewers and reports server performance\n"
+            << "  -a, --address <ip>      Server ip (default " << kDefaultIp
+            << ")\n"
+            << "  -p, --port <port>       Server port (default " << kDefaultPort
+            << ")\n"
+            << "  -n, --viewers <count>   Number of viewers (default "
+            << kDefaultViewerCount << ")\n"
+            << "  -d, --duration <sec>    Test duration, including ramp up "
+               "(default " << kDefaultDurationSec << ")\n"
+            << "  -r, --ramp-up <sec>     Time to start all viewers (default "
+            << kDefaultRampUpSec << ")\n"
+            << "  -t, --timeout <sec>     Socket read and write timeout "
+               "(default " << kDefaultTimeoutSec << ")\n"
+            << "      --playlist <path>   Playlist path (default "
+            << kDefaultPlaylistPath << ")\n"
+            << "      --metrics <path>    Prometheus metrics path, used to get "
+               "server CPU time (default " << kDefaultMetricsPath << ")\n";
+}
+
+/**
+ * @brief Get CPU time of server from its Prometheus metrics
+ *
+ * @param ip Server ip address
+ * @param port Server port
+ * @param timeout Max time of one read or write
+ * @param path Metrics path
+ * @return CPU time in seconds if server exports it
+ */
+std::optional<double> ScrapeCpuSeconds(const std::string &ip, const int port,
+                                       const std::chrono::seconds timeout,
+                                       const std::string &path) {
+  try {
+    load_generator::HttpClient client(ip, port, timeout);
+    const http::Response response = client.Get(path);
+    std::istringstream iss(response.body);
+    std::string line;
+    while (std::getline(iss, line)) {
+      if (line.rfind(kCpuMetricName, 0) == 0) {
+        return std::stod(line.substr(sizeof(kCpuMetricName) - 1));
+      }
+    }
+  } catch (const std::exception &ex) {
+    LOG(kWarning) << "Can't get server metrics: " << ex.what();
+  }
+
+  return std::nullopt;
+}
+
+/**
+ * @brief Print statistics of one request type
+ *
+ * @param name Request type name
+ * @param statistics Statistics to print
+ * @param duration_sec Test duration in seconds
+ */
+void PrintRequestStatistics(const std::string &name,
+                            const load_generator::RequestStatistics &statistics,
+                            const double duration_sec) {
+  const uint64_t request_count = statistics.request_count.Get();
+  const uint64_t error_count = statistics.error_count.Get();
+  const double error_rate =
+      (request_count == 0) ? 0.0 : 100.0 * error_count / request_count;
+  const auto to_ms = [] (const uint64_t us) {
+    return us / 1000.0;
+  };
+
+  std::cout << name << ":\n"
+            << "  requests:   " << request_count << " ("
+            << request_count / duration_sec << " per second)\n"
+            << "  errors:     " << error_count << " (" << error_rate << "%)\n"
+            << "  throughput: "
+            << statistics.byte_count.Get() * 8 / duration_sec / 1e6
+            << " Mbit/s\n"
+            << "  latency:    p50 "
+            << to_ms(statistics.latency.GetQuantile(0.5)) << " ms, p99 "
+            << to_ms(statistics.latency.GetQuantile(0.99)) << " ms, max "
+            << to_ms(statistics.latency.GetMax()) << " ms\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    signal(SIGINT, SignalHandler);
+    signal(SIGTERM, SignalHandler);
+
+    if (const char *log_level = std::getenv("MEDIA_SERVER_LOG_LEVEL")) {
+      logging::Logger::GetInstance().SetLevel(logging::ParseLevel(log_level));
+    }
+
+    std::string ip = kDefaultIp;
+    int port = kDefaultPort;
+    int viewer_count = kDefaultViewerCount;
+    int duration_sec = kDefaultDurationSec;
+    int ramp_up_sec = kDefaultRampUpSec;
+    int timeout_sec = kDefaultTimeoutSec;
+    std::string playlist_path = kDefaultPlaylistPath;
+    std::string metrics_path = kDefaultMetricsPath;
+
+    enum LongOnlyOption {
+      kPlaylistOption = 256,
+      kMetricsOption
+    };
+    const option long_options[] = {
+        {"address", required_argument, nullptr, 'a'},
+        {"port", required_argument, nullptr, 'p'},
+        {"viewers", required_argument, nullptr, 'n'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"ramp-up", required_argument, nullptr, 'r'},
+        {"timeout", required_argument, nullptr, 't'},
+        {"playlist", required_argument, nullptr, kPlaylistOption},
+        {"metrics", required_argument, nullptr, kMetricsOption},
+        {nullptr, 0, nullptr, 0}
+    };
+    int opt = 0;
+    while ((opt = getopt_long(argc, argv, "a:p:n:d:r:t:", long_options,
+                              nullptr)) != -1) {
+      switch (opt) {
+        case 'a':
+          ip = optarg;
+          break;
+        case 'p':
+          port = std::stoi(optarg);
+          break;
+        case 'n':
+          viewer_count = std::stoi(optarg);
+          break;
+        case 'd':
+          duration_sec = std::stoi(optarg);
+          break;
+        case 'r':
+          ramp_up_sec = std::stoi(optarg);
+          break;
+        case 't':
+          timeout_sec = std::stoi(optarg);
+          break;
+        case kPlaylistOption:
+          playlist_path = optarg;
+          break;
+        case kMetricsOption:
+          metrics_path = optarg;
+          break;
+        default:
+          PrintUsage(argv[0]);
+          return EXIT_FAILURE;
+      }
+    }
+    if ((optind != argc) || (viewer_count <= 0) || (duration_sec <= 0) ||
+        (ramp_up_sec < 0) || (ramp_up_sec > duration_sec) ||
+        (timeout_sec <= 0)) {
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+    const std::chrono::seconds timeout(timeout_sec);
+    const std::optional<double> start_cpu_seconds =
+        ScrapeCpuSeconds(ip, port, timeout, metrics_path);
+
+    load_generator::Statistics statistics;
+    std::vector<std::unique_ptr<load_generator::Viewer>> viewers;
+    const auto start_time = std::chrono::steady_clock::now();
+    const auto end_time = start_time + std::chrono::seconds(duration_sec);
+    const auto ramp_up_step = std::chrono::duration_cast<
+        std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(ramp_up_sec) /
+                                          viewer_count));
+    LOG(kInfo) << "Starting " << viewer_count << " viewers of http://" << ip
+               << ":" << port << playlist_path;
+
+    // Viewers are started evenly, so their requests aren't synchronized
+    while (!stop_flag && (std::chrono::steady_clock::now() < end_time)) {
+      const auto now = std::chrono::steady_clock::now();
+      while ((viewers.size() < static_cast<std::size_t>(viewer_count)) &&
+             (start_time + viewers.size() * ramp_up_step <= now)) {
+        viewers.push_back(std::make_unique<load_generator::Viewer>(
+            ip, port, timeout, playlist_path, statistics));
+        viewers.back()->Start();
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    const double elapsed_sec = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start_time).count();
+    const std::optional<double> end_cpu_seconds =
+        ScrapeCpuSeconds(ip, port, timeout, metrics_path);
+    LOG(kInfo) << "Stopping viewers";
+    viewers.clear();
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "Viewers: " << viewer_count << ", duration: " << elapsed_sec
+              << " s, connections: " << statistics.connection_count.Get()
+              << ", skipped segments: "
+              << statistics.skipped_segment_count.Get() << "\n";
+    PrintRequestStatistics("Playlist", statistics.playlist, elapsed_sec);
+    PrintRequestStatistics("Segment", statistics.segment, elapsed_sec);
+    std::cout << "Server CPU: ";
+    if (start_cpu_seconds && end_cpu_seconds) {
+      std::cout << 100.0 * (*end_cpu_seconds - *start_cpu_seconds) /
+                   elapsed_sec << "% of one core";
+    } else {
+      std::cout << "unknown";
+    }
+    std::cout << std::endl;
+  } catch (const std::exception &ex) {
+    LOG(kError) << ex.what();
+    return EXIT_FAILURE;
+  } catch (...) {
+    LOG(kError) << "Unknown error occurred";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
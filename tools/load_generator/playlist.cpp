@@ -0,0 +1,104 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "playlist.h"
+
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+using namespace std::string_literals;
+
+const char kHeaderTag[] = "#EXTM3U";
+const char kTargetDurationTag[] = "#EXT-X-TARGETDURATION:";
+const char kMediaSequenceTag[] = "#EXT-X-MEDIA-SEQUENCE:";
+const char kSegmentInfoTag[] = "#EXTINF:";
+
+/**
+ * @brief Check if line starts with tag and get the rest of it
+ *
+ * @param line Playlist line
+ * @param tag Tag with trailing ':'
+ * @param value Value after tag
+ * @return true if line has tag
+ */
+template <std::size_t N>
+bool ExtractTagValue(const std::string &line, const char (&tag)[N],
+                     std::string &value) {
+  if (line.compare(0, N - 1, tag) != 0) {
+    return false;
+  }
+  value = line.substr(N - 1);
+  return true;
+}
+
+} // namespace
+
+namespace load_generator {
+
+Playlist ParsePlaylist(const std::string &content) {
+  std::istringstream iss(content);
+  std::string line;
+  if (!std::getline(iss, line) || (line.rfind(kHeaderTag, 0) != 0)) {
+    throw std::runtime_error("Playlist doesn't start with #EXTM3U");
+  }
+
+  Playlist playlist;
+  uint64_t media_sequence_number = 0;
+  double segment_duration = -1;
+  try {
+    while (std::getline(iss, line)) {
+      if (!line.empty() && (line.back() == '\r')) {
+        line.pop_back();
+      }
+
+      std::string value;
+      if (ExtractTagValue(line, kTargetDurationTag, value)) {
+        playlist.target_duration = std::stod(value);
+      } else if (ExtractTagValue(line, kMediaSequenceTag, value)) {
+        media_sequence_number = std::stoull(value);
+      } else if (ExtractTagValue(line, kSegmentInfoTag, value)) {
+        segment_duration = std::stod(value);
+      } else if (!line.empty() && (line[0] != '#')) {
+        if (segment_duration < 0) {
+          throw std::runtime_error("Segment " + line + " has no #EXTINF");
+        }
+        playlist.segments.push_back(
+            {media_sequence_number++, segment_duration, line});
+        segment_duration = -1;
+      }
+    }
+  } catch (const std::logic_error &ex) {
+    throw std::runtime_error("Invalid playlist value: "s + ex.what());
+  }
+
+  if (playlist.target_duration <= 0) {
+    throw std::runtime_error("Playlist has no valid #EXT-X-TARGETDURATION");
+  }
+
+  return playlist;
+}
+
+} // namespace load_generator
@@ -0,0 +1,59 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace load_generator {
+
+/**
+ * @brief Media segment from HLS playlist
+ */
+struct Segment {
+  uint64_t media_sequence_number = 0;
+  double duration = 0; //!< Duration in seconds
+  std::string uri;
+};
+
+/**
+ * @brief HLS media playlist
+ */
+struct Playlist {
+  double target_duration = 0; //!< Max segment duration in seconds
+  std::vector<Segment> segments;
+};
+
+/**
+ * @brief Parse HLS media playlist
+ * @throw std::runtime_error if playlist is invalid
+ *
+ * @param content Playlist content
+ * @return Parsed playlist
+ */
+Playlist ParsePlaylist(const std::string &content);
+
+} // namespace load_generator
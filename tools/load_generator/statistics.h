@@ -0,0 +1,53 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "metrics/counter.h"
+#include "metrics/histogram.h"
+
+namespace load_generator {
+
+/**
+ * @brief Statistics of one request type, shared by all viewers
+ */
+struct RequestStatistics {
+  metrics::Histogram latency; //!< Latency of successful requests in microseconds
+  metrics::Counter request_count; //!< Number of sent requests
+  metrics::Counter error_count; //!< Number of failed requests and non-200 responses
+  metrics::Counter byte_count; //!< Number of received body bytes
+};
+
+/**
+ * @brief Statistics of all viewers
+ */
+struct Statistics {
+  RequestStatistics playlist;
+  RequestStatistics segment;
+  metrics::Counter connection_count; //!< Number of opened connections
+  //! Number of segments, that disappeared from playlist before being fetched
+  metrics::Counter skipped_segment_count;
+};
+
+} // namespace load_generator
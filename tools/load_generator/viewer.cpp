@@ -0,0 +1,163 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "viewer.h"
+
+#include "logging/logger.h"
+
+namespace load_generator {
+
+Viewer::Viewer(const std::string &ip, const int port,
+               const std::chrono::milliseconds timeout,
+               std::string playlist_path, Statistics &statistics) :
+client_(ip, port, timeout),
+playlist_path_(std::move(playlist_path)),
+statistics_(statistics),
+next_segment_number_(),
+worker_(),
+worker_stop_(false),
+worker_mutex_(),
+worker_condition_() {
+}
+
+Viewer::~Viewer() {
+  {
+    std::lock_guard lock(worker_mutex_);
+    worker_stop_ = true;
+  }
+  worker_condition_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+void Viewer::Start() {
+  worker_ = std::thread(&Viewer::Playing, this);
+}
+
+void Viewer::Playing() {
+  while (!WaitForStop(Update())) {
+  }
+}
+
+std::chrono::milliseconds Viewer::Update() {
+  const std::optional<std::string> content =
+      Fetch(playlist_path_, statistics_.playlist);
+  if (!content) {
+    return kRetryDelay;
+  }
+
+  Playlist playlist;
+  try {
+    playlist = ParsePlaylist(*content);
+  } catch (const std::runtime_error &ex) {
+    statistics_.playlist.error_count.Add();
+    LOG_EVERY_N(kWarning, 100) << ex.what();
+    return kRetryDelay;
+  }
+
+  const auto target_duration = std::chrono::duration_cast<
+      std::chrono::milliseconds>(
+          std::chrono::duration<double>(playlist.target_duration));
+  const std::vector<Segment> &segments = playlist.segments;
+  if (segments.empty()) {
+    return target_duration / 2;
+  }
+
+  if (!next_segment_number_) {
+    const std::size_t start_index =
+        segments.size() - std::min(segments.size(), kStartSegmentCount);
+    next_segment_number_ = segments[start_index].media_sequence_number;
+  }
+
+  // Player reloads playlist sooner, if it hasn't changed since last time
+  if (segments.back().media_sequence_number < *next_segment_number_) {
+    return target_duration / 2;
+  }
+
+  if (segments.front().media_sequence_number > *next_segment_number_) {
+    statistics_.skipped_segment_count.Add(
+        segments.front().media_sequence_number - *next_segment_number_);
+    next_segment_number_ = segments.front().media_sequence_number;
+  }
+  for (const Segment &segment : segments) {
+    if (segment.media_sequence_number < *next_segment_number_) {
+      continue;
+    }
+    {
+      std::lock_guard lock(worker_mutex_);
+      if (worker_stop_) {
+        break;
+      }
+    }
+    // Failed segment isn't retried, as player would skip it too
+    (void)Fetch(segment.uri, statistics_.segment);
+    next_segment_number_ = segment.media_sequence_number + 1;
+  }
+
+  return target_duration;
+}
+
+std::optional<std::string> Viewer::Fetch(const std::string &path,
+                                         RequestStatistics &statistics) {
+  statistics.request_count.Add();
+  const uint64_t connection_count = client_.GetConnectionCount();
+  const auto start_time = std::chrono::steady_clock::now();
+
+  std::optional<http::Response> response;
+  try {
+    response = client_.Get(path);
+  } catch (const std::runtime_error &ex) {
+    LOG_EVERY_N(kWarning, 100) << "Request " << path << " failed: "
+                               << ex.what();
+  }
+
+  statistics_.connection_count.Add(client_.GetConnectionCount() -
+                                   connection_count);
+  if (!response) {
+    statistics.error_count.Add();
+    return std::nullopt;
+  }
+  if (response->code != 200) {
+    statistics.error_count.Add();
+    LOG_EVERY_N(kWarning, 100) << "Request " << path << " failed: "
+                               << response->code << " "
+                               << response->description;
+    return std::nullopt;
+  }
+
+  statistics.latency.RecordDuration(std::chrono::steady_clock::now() -
+                                    start_time);
+  statistics.byte_count.Add(response->body.size());
+  return std::move(response->body);
+}
+
+bool Viewer::WaitForStop(const std::chrono::milliseconds delay) {
+  std::unique_lock lock(worker_mutex_);
+  return worker_condition_.wait_for(lock, delay, [this] {
+    return worker_stop_;
+  });
+}
+
+} // namespace load_generator
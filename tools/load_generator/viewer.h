@@ -0,0 +1,117 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "http_client.h"
+#include "playlist.h"
+#include "statistics.h"
+
+namespace load_generator {
+
+/**
+ * @brief Simulated HLS player
+ * @details Polls playlist like players do (RFC 8216, section 6.3.4) and
+ * fetches every new segment over one keep-alive connection
+ */
+class Viewer {
+ public:
+  /**
+   * @param ip Server ip address
+   * @param port Server port
+   * @param timeout Max time of one read or write
+   * @param playlist_path Path of playlist on server
+   * @param statistics Statistics to record to
+   */
+  Viewer(const std::string &ip, int port, std::chrono::milliseconds timeout,
+         std::string playlist_path, Statistics &statistics);
+
+  /**
+   * @brief Stop playing
+   */
+  ~Viewer();
+
+  Viewer(const Viewer &) = delete;
+  Viewer &operator=(const Viewer &) = delete;
+
+  /**
+   * @brief Start playing in a separate thread
+   */
+  void Start();
+
+ private:
+  //! Number of segments from the end of playlist, that player starts with
+  static constexpr std::size_t kStartSegmentCount = 3;
+  //! Delay before retry after failed request
+  static constexpr std::chrono::seconds kRetryDelay{1};
+
+  HttpClient client_;
+  const std::string playlist_path_;
+  Statistics &statistics_;
+  //! Number of the next segment to fetch. Empty before the first playlist
+  std::optional<uint64_t> next_segment_number_;
+  std::thread worker_;
+  bool worker_stop_;
+  std::mutex worker_mutex_;
+  std::condition_variable worker_condition_;
+
+  /**
+   * @brief Play until stop is requested
+   */
+  void Playing();
+
+  /**
+   * @brief Fetch playlist and all new segments from it
+   *
+   * @return Delay before the next playlist reload
+   */
+  std::chrono::milliseconds Update();
+
+  /**
+   * @brief Send request and record statistics
+   *
+   * @param path Path to request
+   * @param statistics Statistics of request type
+   * @return Response body if request succeeded
+   */
+  std::optional<std::string> Fetch(const std::string &path,
+                                   RequestStatistics &statistics);
+
+  /**
+   * @brief Wait for stop request
+   *
+   * @param delay Max time to wait
+   * @return true if stop is requested
+   */
+  bool WaitForStop(std::chrono::milliseconds delay);
+};
+
+} // namespace load_generator
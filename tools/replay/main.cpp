@@ -0,0 +1,320 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <getopt.h>
+#include <sys/resource.h>
+
+#include <csignal>
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "observer.h"
+#include "split.h"
+#include "rtsp/client.h"
+#include "converters/mjpeg_to_h264.h"
+#include "converters/mpeg2ts_packager.h"
+#include "logging/logger.h"
+#include "metrics/registry.h"
+#include "replay_source.h"
+
+namespace {
+
+volatile bool stop_flag = false;
+
+const float kChunkDurationSec = 8.0;
+const char *const kStages[] = {"depacketize", "decode", "motion", "scale",
+                               "encode", "mux"};
+
+void SignalHandler(int) {
+  stop_flag = true;
+}
+
+void PrintUsage(const char *program_name) {
+  std::cerr << "Usage:\n"
+            << "  " << program_name << " record [-d <sec>] <rtsp-url> <file>\n"
+            << "    Capture RTP stream to file. Stops after duration or on "
+               "signal\n"
+            << "  " << program_name << " play [-s <speed>] [-n <loops>] "
+               "[-j <threads>[,<threads>...]] [-m <threshold>] <file>\n"
+            << "    Replay capture through transcoding pipeline and report "
+               "throughput.\n"
+            << "    Speed 0 means unthrottled (default 0), loops default is 1.\n"
+            << "    Several decoder thread counts are replayed one after "
+               "another to compare\n"
+            << "    decoder pool scaling, default is 1.\n"
+            << "    Motion threshold enables skipping frames of static scene"
+            << std::endl;
+}
+
+/**
+ * @brief Observer, that counts frames at the end of the pipeline
+ */
+template <typename Data>
+class FrameCounter : public Observer<Data> {
+ public:
+  using typename Observer<Data>::DataPtr;
+
+  void Receive(DataPtr) override {
+    count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] uint64_t GetCount() const {
+    return count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<uint64_t> count_{0};
+};
+
+/**
+ * @return User and system CPU time of process in seconds
+ */
+double GetProcessCpuSeconds() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  const auto to_seconds = [] (const timeval &time) {
+    return time.tv_sec + time.tv_usec / 1e6;
+  };
+
+  return to_seconds(usage.ru_utime) + to_seconds(usage.ru_stime);
+}
+
+int Record(const std::string &url, const std::string &path,
+           const int duration_sec) {
+  rtsp::Client client(url, path);
+  const auto end_time = std::chrono::steady_clock::now() +
+                        std::chrono::seconds(duration_sec);
+  while (!stop_flag && ((duration_sec == 0) ||
+                        (std::chrono::steady_clock::now() < end_time))) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  metrics::Registry &registry = metrics::Registry::GetInstance();
+  std::cout << "Captured "
+            << registry.GetCounter("rtp_packets_received_total", "").Get()
+            << " datagrams, "
+            << registry.GetCounter("frames_received_total", "").Get()
+            << " frames of " << client.GetWidth() << "x"
+            << client.GetHeight() << " at " << client.GetFps() << " fps"
+            << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Stage latency totals, so runs can be compared with global histograms
+ */
+struct StageTotals {
+  uint64_t count[std::size(kStages)]; //!< Number of recorded durations
+  uint64_t sum[std::size(kStages)]; //!< Sum of durations in microseconds
+};
+
+StageTotals GetStageTotals() {
+  StageTotals totals{};
+  for (std::size_t i = 0; i < std::size(kStages); ++i) {
+    const metrics::Histogram &histogram = metrics::GetStageLatency(kStages[i]);
+    totals.count[i] = histogram.GetCount();
+    totals.sum[i] = histogram.GetSum();
+  }
+
+  return totals;
+}
+
+/**
+ * @brief Replay capture through a new pipeline and print its throughput
+ *
+ * @param source_ptr Source of frames
+ * @param speed Replay speed, 0 means unthrottled
+ * @param loop_count Number of times to replay capture
+ * @param options Transcoding options
+ * @return Processed frames per second
+ */
+double PlayOnce(const std::shared_ptr<replay::ReplaySource> &source_ptr,
+                const double speed, const int loop_count,
+                const converters::MjpegToH264Options &options) {
+  const rtp::StreamInfo &info = source_ptr->GetStreamInfo();
+  auto mjpeg_to_h264_ptr = std::make_shared<converters::MjpegToH264>(
+      info.width, info.height, info.fps, options);
+  auto mpeg2ts_packager_ptr = std::make_shared<converters::Mpeg2TsPackager>(
+      info.width, info.height, info.fps, kChunkDurationSec);
+  auto encoded_counter_ptr = std::make_shared<FrameCounter<types::H264Frame>>();
+  source_ptr->AddObserver(mjpeg_to_h264_ptr);
+  mjpeg_to_h264_ptr->AddObserver(mpeg2ts_packager_ptr);
+  mjpeg_to_h264_ptr->AddObserver(encoded_counter_ptr);
+
+  const StageTotals start_totals = GetStageTotals();
+  const double start_cpu_seconds = GetProcessCpuSeconds();
+  const auto start_time = std::chrono::steady_clock::now();
+  uint64_t frame_count = 0;
+  for (int i = 0; (i < loop_count) && !stop_flag; ++i) {
+    frame_count += source_ptr->Run(speed, [] { return stop_flag; });
+  }
+  mjpeg_to_h264_ptr->Flush();
+  const double elapsed_sec = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start_time).count();
+  const double cpu_sec = GetProcessCpuSeconds() - start_cpu_seconds;
+  const StageTotals totals = GetStageTotals();
+  const uint64_t encoded_count = encoded_counter_ptr->GetCount();
+  source_ptr->RemoveObserver(mjpeg_to_h264_ptr);
+
+  // Frames skipped as static are processed too, so they count in throughput
+  const double fps = frame_count / elapsed_sec;
+  std::cout << std::fixed << std::setprecision(2)
+            << "Decoder threads: " << options.decoder_count << "\n"
+            << "Replayed " << frame_count << " frames in " << elapsed_sec
+            << " s, encoded " << encoded_count << " frames ("
+            << (frame_count == 0 ? 0.0 : 100.0 * encoded_count / frame_count)
+            << "%)\n"
+            << "Throughput: " << fps << " fps (" << fps / info.fps
+            << "x realtime)\n"
+            << "Process CPU: " << cpu_sec << " s (" << 100 * cpu_sec /
+                                                       elapsed_sec
+            << "% of one core)\n"
+            << "Stage time per frame, decode time is summed over threads:\n";
+  for (std::size_t i = 0; i < std::size(kStages); ++i) {
+    const uint64_t count = totals.count[i] - start_totals.count[i];
+    const double total_sec = (totals.sum[i] - start_totals.sum[i]) / 1e6;
+    std::cout << "  " << std::left << std::setw(12) << kStages[i] << std::right
+              << std::setw(10) << (count == 0 ? 0.0 : total_sec * 1e3 / count)
+              << " ms  " << std::setw(6) << 100 * total_sec / elapsed_sec
+              << "% of wall time\n";
+  }
+  std::cout << std::endl;
+
+  return fps;
+}
+
+int Play(const std::string &path, const double speed, const int loop_count,
+         const std::vector<std::size_t> &decoder_counts,
+         const std::optional<converters::MotionOptions> &motion_options) {
+  auto source_ptr = std::make_shared<replay::ReplaySource>(path);
+  const rtp::StreamInfo &info = source_ptr->GetStreamInfo();
+  LOG(kInfo) << "Replaying " << info.width << "x" << info.height << " at "
+             << info.fps << " fps";
+
+  std::vector<double> fps_values;
+  for (const std::size_t decoder_count : decoder_counts) {
+    if (stop_flag) {
+      break;
+    }
+    converters::MjpegToH264Options options;
+    options.decoder_count = decoder_count;
+    options.motion_options = motion_options;
+    fps_values.push_back(PlayOnce(source_ptr, speed, loop_count, options));
+  }
+
+  if (fps_values.size() > 1) {
+    std::cout << "Decoder pool scaling:\n";
+    for (std::size_t i = 0; i < fps_values.size(); ++i) {
+      std::cout << "  " << std::setw(3) << decoder_counts[i] << " threads "
+                << std::setw(10) << fps_values[i] << " fps  "
+                << fps_values[i] / fps_values.front() << "x\n";
+    }
+    std::cout << std::flush;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    signal(SIGINT, SignalHandler);
+    signal(SIGTERM, SignalHandler);
+
+    if (const char *log_level = std::getenv("MEDIA_SERVER_LOG_LEVEL")) {
+      logging::Logger::GetInstance().SetLevel(logging::ParseLevel(log_level));
+    }
+
+    if (argc < 2) {
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    const std::string mode = argv[1];
+
+    int duration_sec = 0;
+    double speed = 0;
+    int loop_count = 1;
+    std::vector<std::size_t> decoder_counts = {1};
+    std::optional<converters::MotionOptions> motion_options;
+    int opt = 0;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "d:s:n:j:m:")) != -1) {
+      switch (opt) {
+        case 'd':
+          duration_sec = std::stoi(optarg);
+          break;
+        case 's':
+          speed = std::stod(optarg);
+          break;
+        case 'n':
+          loop_count = std::stoi(optarg);
+          break;
+        case 'j':
+          decoder_counts.clear();
+          for (const std::string &count : Split(optarg, ",")) {
+            decoder_counts.push_back(std::stoul(count));
+          }
+          break;
+        case 'm':
+          motion_options.emplace();
+          motion_options->block_threshold = std::stoi(optarg);
+          break;
+        default:
+          PrintUsage(argv[0]);
+          return EXIT_FAILURE;
+      }
+    }
+
+    if ((mode == "record") && (argc - optind == 2) && (duration_sec >= 0)) {
+      return Record(argv[optind], argv[optind + 1], duration_sec);
+    }
+    const bool valid_decoder_counts = std::none_of(
+        decoder_counts.begin(), decoder_counts.end(),
+        [] (const std::size_t count) { return count == 0; });
+    if ((mode == "play") && (argc - optind == 1) && (speed >= 0) &&
+        (loop_count > 0) && valid_decoder_counts) {
+      return Play(argv[optind], speed, loop_count, decoder_counts,
+                  motion_options);
+    }
+    PrintUsage(argv[0]);
+  } catch (const std::exception &ex) {
+    LOG(kError) << ex.what();
+  } catch (...) {
+    LOG(kError) << "Unknown error occurred";
+  }
+
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,89 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "replay_source.h"
+
+#include <chrono>
+#include <thread>
+
+#include "logging/logger.h"
+#include "metrics/registry.h"
+
+namespace replay {
+
+ReplaySource::ReplaySource(const std::string &path) :
+stream_info_(),
+records_(),
+depacketizer_(),
+dropped_frames_counter_(metrics::Registry::GetInstance().GetCounter(
+    "frames_dropped_total", "Number of frames dropped because of errors")) {
+  rtp::CaptureReader reader(path);
+  stream_info_ = reader.GetStreamInfo();
+
+  rtp::CaptureRecord record;
+  while (reader.Read(record)) {
+    records_.push_back(std::move(record));
+  }
+  if (records_.empty()) {
+    throw std::runtime_error(path + " has no datagrams");
+  }
+}
+
+const rtp::StreamInfo &ReplaySource::GetStreamInfo() const {
+  return stream_info_;
+}
+
+uint64_t ReplaySource::Run(const double speed,
+                           const std::function<bool()> &should_stop) {
+  const types::Timestamp start_time = types::Clock::now();
+  uint64_t frame_count = 0;
+
+  for (const rtp::CaptureRecord &record : records_) {
+    if (speed > 0) {
+      std::this_thread::sleep_until(
+          start_time + std::chrono::duration_cast<types::Clock::duration>(
+              record.offset / speed));
+    }
+
+    std::optional<types::MjpegFrame> frame =
+        depacketizer_.Push(record.datagram, types::Clock::now());
+    if (!frame) {
+      continue;
+    }
+    try {
+      ProvideToAll(std::move(*frame));
+      ++frame_count;
+    } catch (const std::runtime_error &ex) {
+      dropped_frames_counter_.Add();
+      LOG_EVERY_N(kWarning, 100) << ex.what();
+    }
+    if (should_stop()) {
+      break;
+    }
+  }
+
+  return frame_count;
+}
+
+} // namespace replay
@@ -0,0 +1,75 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "provider.h"
+#include "types/mjpeg_frame.h"
+#include "rtp/capture.h"
+#include "rtp/mjpeg/depacketizer.h"
+
+namespace replay {
+
+/**
+ * @brief Provides frames from RTP capture without any sockets
+ */
+class ReplaySource : public Provider<types::MjpegFrame> {
+ public:
+  /**
+   * @details Whole capture is loaded into memory, so disk doesn't limit
+   * replay speed
+   * @throw std::runtime_error if capture can't be read
+   *
+   * @param path Path of capture file
+   */
+  explicit ReplaySource(const std::string &path);
+
+  /**
+   * @return Parameters of captured stream
+   */
+  [[nodiscard]] const rtp::StreamInfo &GetStreamInfo() const;
+
+  /**
+   * @brief Replay capture once
+   * @details Datagrams are passed through the same depacketizer as in
+   * rtsp::Client. Frames, that observers failed to process, are dropped
+   *
+   * @param speed Speed relative to capture timing. 0 means unthrottled
+   * @param should_stop Checked after every frame
+   * @return Number of provided frames
+   */
+  uint64_t Run(double speed, const std::function<bool()> &should_stop);
+
+ private:
+  rtp::StreamInfo stream_info_;
+  std::vector<rtp::CaptureRecord> records_;
+  rtp::mjpeg::Depacketizer depacketizer_;
+  metrics::Counter &dropped_frames_counter_;
+};
+
+} // namespace replay
@@ -0,0 +1,230 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "file_source.h"
+
+#include <array>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+
+namespace {
+
+using namespace std::string_literals;
+
+const uint8_t kMarkerPrefix = 0xff;
+const uint8_t kStartOfImage = 0xd8;
+const uint8_t kEndOfImage = 0xd9;
+const uint8_t kBaselineStartOfFrame = 0xc0;
+const uint8_t kDefineHuffmanTable = 0xc4;
+const uint8_t kDefineQuantizationTable = 0xdb;
+const uint8_t kDefineRestartInterval = 0xdd;
+const uint8_t kStartOfScan = 0xda;
+const std::size_t kQuantizationTableSize = 64;
+//! Max image dimension, that can be sent with RTP/JPEG
+const int kMaxDimension = 2040;
+
+/**
+ * @brief Read big-endian 16-bit value
+ *
+ * @param bytes Bytes
+ * @param pos Position of the value
+ * @return Value
+ */
+uint16_t Read16(const types::Bytes &bytes, const std::size_t pos) {
+  if (pos + 2 > bytes.size()) {
+    throw std::runtime_error("Unexpected end of JPEG");
+  }
+  return (bytes[pos] << 8) | bytes[pos + 1];
+}
+
+} // namespace
+
+namespace test_source {
+
+FileSource::FileSource(const std::vector<std::string> &paths) :
+frames_() {
+  if (paths.empty()) {
+    throw std::invalid_argument("No JPEG files provided");
+  }
+
+  for (const std::string &path : paths) {
+    frames_.push_back(ParseFile(path));
+    if ((frames_.back()->width != frames_.front()->width) ||
+        (frames_.back()->height != frames_.front()->height)) {
+      throw std::runtime_error("All JPEG files must have the same dimensions");
+    }
+  }
+}
+
+std::shared_ptr<const JpegFrame> FileSource::GetFrame(
+    const uint64_t frame_number) const {
+  return frames_[frame_number % frames_.size()];
+}
+
+int FileSource::GetWidth() const {
+  return frames_.front()->width;
+}
+
+int FileSource::GetHeight() const {
+  return frames_.front()->height;
+}
+
+std::shared_ptr<const JpegFrame> FileSource::ParseFile(
+    const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Can't open "s + path);
+  }
+  const types::Bytes bytes{std::istreambuf_iterator<char>(file),
+                           std::istreambuf_iterator<char>()};
+  if ((bytes.size() < 4) || (bytes[0] != kMarkerPrefix) ||
+      (bytes[1] != kStartOfImage)) {
+    throw std::runtime_error(path + " isn't a JPEG file");
+  }
+
+  auto frame_ptr = std::make_shared<JpegFrame>();
+  // Quality above 127 means, that tables are sent in-band
+  frame_ptr->quality = 255;
+  std::map<uint8_t, std::array<uint8_t, kQuantizationTableSize>> tables;
+  std::array<uint8_t, 2> component_tables{};
+  bool has_frame_header = false;
+
+  std::size_t pos = 2;
+  for (;;) {
+    if ((pos + 4 > bytes.size()) || (bytes[pos] != kMarkerPrefix)) {
+      throw std::runtime_error(path + ": invalid JPEG marker");
+    }
+    const uint8_t marker = bytes[pos + 1];
+    if (marker == kMarkerPrefix) {
+      // Fill byte
+      ++pos;
+      continue;
+    }
+    const std::size_t segment_begin = pos + 4;
+    const std::size_t segment_end = pos + 2 + Read16(bytes, pos + 2);
+    if (segment_end > bytes.size()) {
+      throw std::runtime_error(path + ": truncated JPEG segment");
+    }
+
+    if (marker == kDefineQuantizationTable) {
+      for (std::size_t it = segment_begin; it < segment_end;
+           it += 1 + kQuantizationTableSize) {
+        if ((bytes[it] >> 4) != 0) {
+          throw std::runtime_error(path + ": 16-bit quantization tables "
+                                   "aren't supported");
+        }
+        if (it + 1 + kQuantizationTableSize > segment_end) {
+          throw std::runtime_error(path + ": truncated quantization table");
+        }
+        std::copy(bytes.begin() + it + 1,
+                  bytes.begin() + it + 1 + kQuantizationTableSize,
+                  tables[bytes[it] & 0x0f].begin());
+      }
+    } else if (marker == kBaselineStartOfFrame) {
+      frame_ptr->height = Read16(bytes, segment_begin + 1);
+      frame_ptr->width = Read16(bytes, segment_begin + 3);
+      const std::size_t component_count = bytes.at(segment_begin + 5);
+      if ((component_count != 3) ||
+          (segment_begin + 6 + component_count * 3 > segment_end)) {
+        throw std::runtime_error(path + ": only YCbCr images are supported");
+      }
+
+      const std::size_t components_begin = segment_begin + 6;
+      const uint8_t luma_sampling = bytes[components_begin + 1];
+      if (luma_sampling == 0x21) {
+        frame_ptr->type = 0;
+      } else if (luma_sampling == 0x22) {
+        frame_ptr->type = 1;
+      } else {
+        throw std::runtime_error(path + ": only 4:2:2 and 4:2:0 chroma "
+                                 "subsampling is supported");
+      }
+      for (std::size_t i = 1; i < component_count; ++i) {
+        if (bytes[components_begin + i * 3 + 1] != 0x11) {
+          throw std::runtime_error(path + ": unsupported chroma sampling");
+        }
+      }
+      // RTP/JPEG has only luma and chroma tables
+      component_tables[0] = bytes[components_begin + 2];
+      component_tables[1] = bytes[components_begin + 3 + 2];
+      if (bytes[components_begin + 6 + 2] != component_tables[1]) {
+        throw std::runtime_error(path + ": chroma components must share "
+                                 "quantization table");
+      }
+      has_frame_header = true;
+    } else if ((marker >= 0xc1) && (marker <= 0xcf) &&
+               (marker != kDefineHuffmanTable) && (marker != 0xc8) &&
+               (marker != 0xcc)) {
+      throw std::runtime_error(path + ": only baseline JPEG is supported");
+    } else if (marker == kDefineRestartInterval) {
+      if (Read16(bytes, segment_begin) != 0) {
+        throw std::runtime_error(path + ": restart markers aren't supported");
+      }
+    } else if (marker == kStartOfScan) {
+      pos = segment_end;
+      break;
+    }
+    // Huffman tables are expected to be standard ones, other segments are
+    // not needed for RTP/JPEG
+    pos = segment_end;
+  }
+
+  if (!has_frame_header) {
+    throw std::runtime_error(path + ": there is no frame header");
+  }
+  if ((frame_ptr->width % 8 != 0) || (frame_ptr->height % 8 != 0) ||
+      (frame_ptr->width > kMaxDimension) ||
+      (frame_ptr->height > kMaxDimension)) {
+    throw std::runtime_error(path + ": dimensions must be multiples of 8 and "
+                             "not bigger than 2040");
+  }
+  for (const uint8_t table_id : component_tables) {
+    auto it = tables.find(table_id);
+    if (it == tables.end()) {
+      throw std::runtime_error(path + ": quantization table is missing");
+    }
+    frame_ptr->quantization_tables.insert(
+        frame_ptr->quantization_tables.end(), it->second.begin(),
+        it->second.end());
+  }
+
+  // Scan data lasts until EOI, markers inside it are always stuffed
+  std::size_t scan_end = bytes.size();
+  while ((scan_end >= pos + 2) &&
+         !((bytes[scan_end - 2] == kMarkerPrefix) &&
+           (bytes[scan_end - 1] == kEndOfImage))) {
+    --scan_end;
+  }
+  if (scan_end < pos + 2) {
+    throw std::runtime_error(path + ": there is no end of image marker");
+  }
+  frame_ptr->scan_data.assign(bytes.begin() + pos,
+                              bytes.begin() + scan_end - 2);
+
+  return frame_ptr;
+}
+
+} // namespace test_source
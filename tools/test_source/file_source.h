@@ -0,0 +1,71 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "frame_source.h"
+
+namespace test_source {
+
+/**
+ * @brief Source, that cycles through baseline JPEG files
+ * @details RTP/JPEG receivers always use standard Huffman tables, so files
+ * must be encoded with them (no optimized tables)
+ */
+class FileSource : public FrameSource {
+ public:
+  /**
+   * @throw std::runtime_error if some file can't be read or isn't suitable for
+   * RTP/JPEG: not baseline, has restart markers, not 4:2:0 or 4:2:2 or images
+   * have different dimensions
+   *
+   * @param paths Paths to JPEG files
+   */
+  explicit FileSource(const std::vector<std::string> &paths);
+
+  [[nodiscard]] std::shared_ptr<const JpegFrame> GetFrame(
+      uint64_t frame_number) const override;
+
+  [[nodiscard]] int GetWidth() const override;
+
+  [[nodiscard]] int GetHeight() const override;
+
+ private:
+  //! Frames are parsed once and shared between sessions
+  std::vector<std::shared_ptr<const JpegFrame>> frames_;
+
+  /**
+   * @brief Parse JPEG file into frame, that can be packetized
+   * @throw std::runtime_error if file can't be read or parsed
+   *
+   * @param path Path to JPEG file
+   * @return Frame with in-band quantization tables
+   */
+  static std::shared_ptr<const JpegFrame> ParseFile(const std::string &path);
+};
+
+} // namespace test_source
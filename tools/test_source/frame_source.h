@@ -0,0 +1,75 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "types/byte.h"
+
+namespace test_source {
+
+/**
+ * @brief JPEG frame prepared for RTP/JPEG (RFC 2435) packetization
+ */
+struct JpegFrame {
+  uint8_t type = 1; //!< 0 for 4:2:2 and 1 for 4:2:0 chroma subsampling
+  //! 1-99 for standard tables scaled by quality, 128-255 for in-band tables
+  uint8_t quality = 0;
+  int width = 0; //!< Image width. Multiple of 8
+  int height = 0; //!< Image height. Multiple of 8
+  //! Luma and chroma tables in zigzag order. Used only if quality >= 128
+  types::Bytes quantization_tables;
+  types::Bytes scan_data; //!< Entropy-coded data without headers and EOI
+};
+
+/**
+ * @brief Interface class for sources of JPEG frames
+ */
+class FrameSource {
+ public:
+  virtual ~FrameSource() = default;
+
+  /**
+   * @brief Get frame. Can be called from several threads at once
+   *
+   * @param frame_number Number of frame from the start of stream
+   * @return Frame
+   */
+  [[nodiscard]] virtual std::shared_ptr<const JpegFrame> GetFrame(
+      uint64_t frame_number) const = 0;
+
+  /**
+   * @return Image width
+   */
+  [[nodiscard]] virtual int GetWidth() const = 0;
+
+  /**
+   * @return Image height
+   */
+  [[nodiscard]] virtual int GetHeight() const = 0;
+};
+
+} // namespace test_source
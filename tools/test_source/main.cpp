@@ -0,0 +1,174 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <getopt.h>
+
+#include <csignal>
+#include <cstdlib>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "port_handler/port_handler.h"
+#include "port_handler/port_handler_manager.h"
+#include "rtsp/request.h"
+#include "rtsp/response.h"
+#include "logging/logger.h"
+#include "file_source.h"
+#include "synthetic_source.h"
+#include "rtsp_servlet.h"
+
+namespace {
+
+volatile bool stop_flag = false;
+
+const int kDefaultPort = 8554;
+const int kDefaultWidth = 640;
+const int kDefaultHeight = 480;
+
+void SignalHandler(int) {
+  stop_flag = true;
+}
+
+void PrintUsage(const char *program_name) {
+  std::cerr << "Usage: " << program_name << " [options] [jpeg-file...]\n"
+            << "Streams MJPEG over RTSP/RTP. Without files synthetic frames "
+               "are generated\n"
+            << "  -p, --port <port>       RTSP port (default " << kDefaultPort
+            << ")\n"
+            << "  -w, --width <pixels>    Synthetic frame width, multiple of "
+               "16 (default " << kDefaultWidth << ")\n"
+            << "  -h, --height <pixels>   Synthetic frame height, multiple of "
+               "16 (default " << kDefaultHeight << ")\n"
+            << "  -f, --fps <fps>         Frames per second (default "
+            << test_source::StreamOptions().fps << ")\n"
+            << "  -l, --loss <0..1>       Probability to drop each RTP packet "
+               "(default 0)\n"
+            << "  -s, --max-packet-size <bytes>  Max RTP packet size (default "
+            << test_source::StreamOptions().max_packet_size << ")\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    signal(SIGINT, SignalHandler);
+    signal(SIGTERM, SignalHandler);
+
+    if (const char *log_level = std::getenv("MEDIA_SERVER_LOG_LEVEL")) {
+      logging::Logger::GetInstance().SetLevel(logging::ParseLevel(log_level));
+    }
+
+    int port = kDefaultPort;
+    int width = kDefaultWidth;
+    int height = kDefaultHeight;
+    test_source::StreamOptions options;
+
+    const option long_options[] = {
+        {"port", required_argument, nullptr, 'p'},
+        {"width", required_argument, nullptr, 'w'},
+        {"height", required_argument, nullptr, 'h'},
+        {"fps", required_argument, nullptr, 'f'},
+        {"loss", required_argument, nullptr, 'l'},
+        {"max-packet-size", required_argument, nullptr, 's'},
+        {nullptr, 0, nullptr, 0}
+    };
+    int opt = 0;
+    while ((opt = getopt_long(argc, argv, "p:w:h:f:l:s:", long_options,
+                              nullptr)) != -1) {
+      switch (opt) {
+        case 'p':
+          port = std::stoi(optarg);
+          break;
+        case 'w':
+          width = std::stoi(optarg);
+          break;
+        case 'h':
+          height = std::stoi(optarg);
+          break;
+        case 'f':
+          options.fps = std::stoi(optarg);
+          break;
+        case 'l':
+          options.loss_probability = std::stod(optarg);
+          break;
+        case 's':
+          options.max_packet_size = std::stoul(optarg);
+          break;
+        default:
+          PrintUsage(argv[0]);
+          return EXIT_FAILURE;
+      }
+    }
+    if ((options.fps <= 0) || (options.fps > 90000) ||
+        (options.loss_probability < 0.0) ||
+        (options.loss_probability > 1.0)) {
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+    std::shared_ptr<const test_source::FrameSource> source_ptr;
+    if (optind < argc) {
+      source_ptr = std::make_shared<test_source::FileSource>(
+          std::vector<std::string>(argv + optind, argv + argc));
+    } else {
+      source_ptr = std::make_shared<test_source::SyntheticSource>(width,
+                                                                  height);
+    }
+
+    // RTSP connection is idle while client is receiving RTP
+    port_handler::Options port_options;
+    port_options.idle_timeout = std::chrono::hours(24);
+    auto port_handler_ptr = std::make_unique<
+        port_handler::PortHandler<rtsp::Request, rtsp::Response>>(
+            port, port_options);
+    port_handler_ptr->RegisterServlet(
+        "/", std::make_shared<test_source::RtspServlet>(source_ptr, options));
+
+    port_handler::PortHandlerManager port_handler_manager;
+    port_handler_manager.RegisterPortHandler(std::move(port_handler_ptr));
+    LOG(kInfo) << "Streaming " << source_ptr->GetWidth() << "x"
+               << source_ptr->GetHeight() << " at " << options.fps
+               << " fps on rtsp://0.0.0.0:" << port << "/stream";
+
+    const int kAcceptTimeoutInMilliseconds = 2000;
+    port_handler_manager.StartAcceptors(kAcceptTimeoutInMilliseconds);
+    while (!stop_flag) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    port_handler_manager.StopAcceptors();
+  } catch (const std::exception &ex) {
+    LOG(kError) << ex.what();
+    return EXIT_FAILURE;
+  } catch (...) {
+    LOG(kError) << "Unknown error occurred";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
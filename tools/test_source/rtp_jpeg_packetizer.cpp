@@ -0,0 +1,120 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "rtp_jpeg_packetizer.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+const std::size_t kRtpHeaderSize = 12;
+const std::size_t kJpegHeaderSize = 8;
+const std::size_t kQuantizationTableHeaderSize = 4;
+//! Quality values starting from this one mean in-band tables
+const uint8_t kInBandTablesQuality = 128;
+//! Size of luma and chroma quantization tables
+const std::size_t kQuantizationTablesSize = 2 * 64;
+
+void Append16(types::Bytes &bytes, const uint16_t value) {
+  bytes.push_back(value >> 8);
+  bytes.push_back(value & 0xff);
+}
+
+void Append24(types::Bytes &bytes, const uint32_t value) {
+  bytes.push_back((value >> 16) & 0xff);
+  Append16(bytes, value & 0xffff);
+}
+
+void Append32(types::Bytes &bytes, const uint32_t value) {
+  Append16(bytes, value >> 16);
+  Append16(bytes, value & 0xffff);
+}
+
+} // namespace
+
+namespace test_source {
+
+RtpJpegPacketizer::RtpJpegPacketizer(const uint32_t synchronization_source,
+                                     const std::size_t max_packet_size) :
+synchronization_source_(synchronization_source),
+max_packet_size_(max_packet_size),
+sequence_number_(0) {
+  // First packet must fit all headers, tables and at least one byte of data
+  if (max_packet_size_ <= kRtpHeaderSize + kJpegHeaderSize +
+                          kQuantizationTableHeaderSize +
+                          kQuantizationTablesSize) {
+    throw std::invalid_argument("Max packet size is too small");
+  }
+}
+
+std::vector<types::Bytes> RtpJpegPacketizer::Packetize(const JpegFrame &frame,
+                                                       const uint32_t timestamp) {
+  std::vector<types::Bytes> packets;
+  const types::Bytes &data = frame.scan_data;
+  const bool has_tables = (frame.quality >= kInBandTablesQuality);
+
+  std::size_t offset = 0;
+  do {
+    types::Bytes packet;
+    packet.reserve(max_packet_size_);
+
+    // RTP header. Marker is set later
+    packet.push_back(0x80);
+    packet.push_back(kPayloadType);
+    Append16(packet, sequence_number_++);
+    Append32(packet, timestamp);
+    Append32(packet, synchronization_source_);
+
+    // JPEG header
+    packet.push_back(0);
+    Append24(packet, offset);
+    packet.push_back(frame.type);
+    packet.push_back(frame.quality);
+    packet.push_back(frame.width / 8);
+    packet.push_back(frame.height / 8);
+
+    // Tables are sent only in the first packet of the frame
+    if (has_tables && (offset == 0)) {
+      packet.push_back(0);
+      packet.push_back(0);
+      Append16(packet, frame.quantization_tables.size());
+      packet.insert(packet.end(), frame.quantization_tables.begin(),
+                    frame.quantization_tables.end());
+    }
+
+    const std::size_t size = std::min(max_packet_size_ - packet.size(),
+                                      data.size() - offset);
+    packet.insert(packet.end(), data.begin() + offset,
+                  data.begin() + offset + size);
+    offset += size;
+    packets.push_back(std::move(packet));
+  } while (offset < data.size());
+
+  packets.back()[1] |= 0x80;
+
+  return packets;
+}
+
+} // namespace test_source
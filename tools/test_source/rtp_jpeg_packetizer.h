@@ -0,0 +1,67 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "frame_source.h"
+
+namespace test_source {
+
+/**
+ * @brief Splits JPEG frames into RTP packets according to RFC 2435
+ */
+class RtpJpegPacketizer {
+ public:
+  //! Payload type of JPEG according to RFC 3551
+  static constexpr uint8_t kPayloadType = 26;
+
+  /**
+   * @throw std::invalid_argument if max_packet_size can't fit headers
+   *
+   * @param synchronization_source SSRC of the stream
+   * @param max_packet_size Max size of RTP packet in bytes
+   */
+  RtpJpegPacketizer(uint32_t synchronization_source,
+                    std::size_t max_packet_size);
+
+  /**
+   * @brief Split frame into packets. Marker bit is set on the last one
+   *
+   * @param frame Frame to packetize
+   * @param timestamp RTP timestamp of the frame in 90 kHz units
+   * @return Packets ready to be sent
+   */
+  [[nodiscard]] std::vector<types::Bytes> Packetize(const JpegFrame &frame,
+                                                    uint32_t timestamp);
+
+ private:
+  const uint32_t synchronization_source_;
+  const std::size_t max_packet_size_;
+  uint16_t sequence_number_; //!< Sequence number of the next packet
+};
+
+} // namespace test_source
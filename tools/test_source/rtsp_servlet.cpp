@@ -0,0 +1,224 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "rtsp_servlet.h"
+
+#include <sstream>
+
+#include "logging/logger.h"
+
+namespace {
+
+using namespace std::string_literals;
+
+const char kCSeqHeaderName[] = "CSeq";
+const char kSessionHeaderName[] = "Session";
+const char kTransportHeaderName[] = "Transport";
+const char kClientPortParameter[] = "client_port=";
+const char kTrackName[] = "track1";
+
+const rtsp::Response kSessionNotFoundResponse = {454, "Session Not Found"};
+
+/**
+ * @brief Extract first client RTP port from Transport header
+ * @throw std::invalid_argument if there is no client_port parameter
+ *
+ * @param transport Value of Transport header
+ * @return Port number
+ */
+int ExtractClientPort(const std::string &transport) {
+  const std::string::size_type pos = transport.find(kClientPortParameter);
+  if (pos == std::string::npos) {
+    throw std::invalid_argument("There is no client_port in transport");
+  }
+
+  return std::stoi(transport.substr(pos + sizeof(kClientPortParameter) - 1));
+}
+
+} // namespace
+
+namespace test_source {
+
+RtspServlet::RtspServlet(std::shared_ptr<const FrameSource> source_ptr,
+                         const StreamOptions &options) :
+source_ptr_(std::move(source_ptr)),
+options_(options),
+sessions_(),
+random_engine_(std::random_device()()),
+sessions_mutex_() {
+}
+
+rtsp::Response RtspServlet::Handle(const rtsp::Request &request) {
+  rtsp::Response response;
+  switch (request.method) {
+    case rtsp::Method::kOptions:
+      response = HandleOptions();
+      break;
+    case rtsp::Method::kDescribe:
+      response = HandleDescribe();
+      break;
+    case rtsp::Method::kSetup:
+      response = HandleSetup(request);
+      break;
+    case rtsp::Method::kPlay:
+      response = HandlePlay(request);
+      break;
+    case rtsp::Method::kTeardown:
+      response = HandleTeardown(request);
+      break;
+    default:
+      response = {405, "Method Not Allowed"};
+  }
+
+  if (request.headers.count(kCSeqHeaderName)) {
+    response.headers[kCSeqHeaderName] = request.headers.at(kCSeqHeaderName);
+  }
+
+  return response;
+}
+
+rtsp::Response RtspServlet::HandleOptions() const {
+  rtsp::Response response(200, "OK");
+  response.headers["Public"] = "OPTIONS, DESCRIBE, SETUP, PLAY, TEARDOWN";
+
+  return response;
+}
+
+rtsp::Response RtspServlet::HandleDescribe() const {
+  std::ostringstream sdp;
+  sdp << "v=0\r\n"
+      << "o=- 0 0 IN IP4 0.0.0.0\r\n"
+      << "s=Media server test source\r\n"
+      << "c=IN IP4 0.0.0.0\r\n"
+      << "t=0 0\r\n"
+      << "m=video 0 RTP/AVP " << +RtpJpegPacketizer::kPayloadType << "\r\n"
+      << "a=control:" << kTrackName << "\r\n"
+      << "a=cliprect:0,0," << source_ptr_->GetHeight() << ","
+      << source_ptr_->GetWidth() << "\r\n"
+      << "a=framerate:" << options_.fps << "\r\n";
+
+  rtsp::Response response(200, "OK");
+  response.body = sdp.str();
+  response.headers["Content-Type"] = "application/sdp";
+  response.headers["Content-Length"] = std::to_string(response.body.size());
+
+  return response;
+}
+
+rtsp::Response RtspServlet::HandleSetup(const rtsp::Request &request) {
+  if (!request.headers.count(kTransportHeaderName)) {
+    return {400, "Bad Request"};
+  }
+  const std::string &transport = request.headers.at(kTransportHeaderName);
+  if ((transport.find("RTP/AVP") == std::string::npos) ||
+      (transport.find("RTP/AVP/TCP") != std::string::npos) ||
+      (transport.find("multicast") != std::string::npos)) {
+    return {461, "Unsupported Transport"};
+  }
+
+  int client_port = 0;
+  try {
+    client_port = ExtractClientPort(transport);
+  } catch (const std::logic_error &) {
+    return {461, "Unsupported Transport"};
+  }
+
+  std::lock_guard lock(sessions_mutex_);
+  RemoveFinishedSessions();
+  uint32_t session_id = 0;
+  do {
+    session_id = random_engine_();
+  } while ((session_id == 0) || sessions_.count(session_id));
+  sessions_.emplace(session_id, std::make_unique<Session>(
+      source_ptr_, options_, request.remote_address, client_port));
+  LOG(kInfo) << "Session " << session_id << " created for "
+             << request.remote_address << ":" << client_port;
+
+  rtsp::Response response(200, "OK");
+  response.headers[kTransportHeaderName] =
+      "RTP/AVP;unicast;client_port="s + std::to_string(client_port) + "-" +
+      std::to_string(client_port + 1);
+  response.headers[kSessionHeaderName] = std::to_string(session_id);
+
+  return response;
+}
+
+rtsp::Response RtspServlet::HandlePlay(const rtsp::Request &request) {
+  std::lock_guard lock(sessions_mutex_);
+  RemoveFinishedSessions();
+  auto it = FindSession(request);
+  if (it == sessions_.end()) {
+    return kSessionNotFoundResponse;
+  }
+  it->second->Play();
+
+  rtsp::Response response(200, "OK");
+  response.headers[kSessionHeaderName] = std::to_string(it->first);
+  response.headers["Range"] = "npt=0.000-";
+
+  return response;
+}
+
+rtsp::Response RtspServlet::HandleTeardown(const rtsp::Request &request) {
+  std::unique_ptr<Session> session_ptr;
+  {
+    std::lock_guard lock(sessions_mutex_);
+    auto it = FindSession(request);
+    if (it == sessions_.end()) {
+      return kSessionNotFoundResponse;
+    }
+    LOG(kInfo) << "Session " << it->first << " closed";
+    session_ptr = std::move(it->second);
+    sessions_.erase(it);
+  }
+
+  // Streaming thread is joined outside of the lock
+  session_ptr.reset();
+  return {200, "OK"};
+}
+
+void RtspServlet::RemoveFinishedSessions() {
+  for (auto it = sessions_.begin(); it != sessions_.end();) {
+    if (it->second->IsFinished()) {
+      it = sessions_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+std::map<uint32_t, std::unique_ptr<Session>>::iterator RtspServlet::FindSession(
+    const rtsp::Request &request) {
+  if (!request.headers.count(kSessionHeaderName)) {
+    return sessions_.end();
+  }
+
+  try {
+    return sessions_.find(std::stoul(request.headers.at(kSessionHeaderName)));
+  } catch (const std::logic_error &) {
+    return sessions_.end();
+  }
+}
+
+} // namespace test_source
@@ -0,0 +1,89 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+
+#include "servlet.h"
+#include "rtsp/request.h"
+#include "rtsp/response.h"
+#include "frame_source.h"
+#include "session.h"
+
+namespace test_source {
+
+/**
+ * @brief Minimal RTSP server part: OPTIONS, DESCRIBE, SETUP, PLAY, TEARDOWN
+ * @details Supports only unicast RTP/AVP over UDP with one video track
+ */
+class RtspServlet : public Servlet<rtsp::Request, rtsp::Response> {
+ public:
+  /**
+   * @param source_ptr Source of frames for all sessions
+   * @param options Streaming parameters
+   */
+  RtspServlet(std::shared_ptr<const FrameSource> source_ptr,
+              const StreamOptions &options);
+
+  [[nodiscard]] rtsp::Response Handle(const rtsp::Request &request) override;
+
+ private:
+  const std::shared_ptr<const FrameSource> source_ptr_;
+  const StreamOptions options_;
+  std::map<uint32_t, std::unique_ptr<Session>> sessions_; //!< Id -> session
+  std::mt19937 random_engine_; //!< Generator of session ids
+  std::mutex sessions_mutex_; //!< Mutex for sessions_ and random_engine_
+
+  [[nodiscard]] rtsp::Response HandleOptions() const;
+
+  [[nodiscard]] rtsp::Response HandleDescribe() const;
+
+  [[nodiscard]] rtsp::Response HandleSetup(const rtsp::Request &request);
+
+  [[nodiscard]] rtsp::Response HandlePlay(const rtsp::Request &request);
+
+  [[nodiscard]] rtsp::Response HandleTeardown(const rtsp::Request &request);
+
+  /**
+   * @brief Remove sessions, that stopped streaming by themselves
+   * @details sessions_mutex_ must be locked
+   */
+  void RemoveFinishedSessions();
+
+  /**
+   * @brief Find session by Session header of request
+   * @details sessions_mutex_ must be locked
+   *
+   * @param request Request with Session header
+   * @return Iterator to session or sessions_.end()
+   */
+  std::map<uint32_t, std::unique_ptr<Session>>::iterator FindSession(
+      const rtsp::Request &request);
+};
+
+} // namespace test_source
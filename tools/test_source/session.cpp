@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "session.h"
+
+#include <chrono>
+
+#include "sock/exception.h"
+#include "logging/logger.h"
+
+namespace test_source {
+
+Session::Session(std::shared_ptr<const FrameSource> source_ptr,
+                 const StreamOptions &options, std::string ip,
+                 const int port) :
+source_ptr_(std::move(source_ptr)),
+options_(options),
+ip_(std::move(ip)),
+port_(port),
+socket_(sock::Type::kUdp),
+packetizer_(std::random_device()(), options_.max_packet_size),
+initial_timestamp_(std::random_device()()),
+random_engine_(std::random_device()()),
+worker_(),
+worker_stop_(false),
+worker_mutex_(),
+worker_condition_(),
+is_finished_(false) {
+}
+
+Session::~Session() {
+  {
+    std::lock_guard lock(worker_mutex_);
+    worker_stop_ = true;
+  }
+  worker_condition_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+void Session::Play() {
+  std::lock_guard lock(worker_mutex_);
+  if (!worker_.joinable()) {
+    LOG(kInfo) << "Streaming to " << ip_ << ":" << port_;
+    worker_ = std::thread(&Session::Streaming, this);
+  }
+}
+
+bool Session::IsFinished() const {
+  return is_finished_;
+}
+
+void Session::Streaming() {
+  using Clock = std::chrono::steady_clock;
+
+  const auto frame_interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / options_.fps));
+  const uint32_t timestamp_step = 90000 / options_.fps;
+  std::bernoulli_distribution loss_distribution(options_.loss_probability);
+  const Clock::time_point start_time = Clock::now();
+
+  try {
+    for (uint64_t frame_number = 0;; ++frame_number) {
+      {
+        // Deadlines are counted from start, so slow frames don't shift others
+        std::unique_lock lock(worker_mutex_);
+        if (worker_condition_.wait_until(
+                lock, start_time + frame_number * frame_interval,
+                [this] { return worker_stop_; })) {
+          return;
+        }
+      }
+
+      const auto frame_ptr = source_ptr_->GetFrame(frame_number);
+      const uint32_t timestamp = initial_timestamp_ +
+                                 frame_number * timestamp_step;
+      for (const types::Bytes &packet :
+           packetizer_.Packetize(*frame_ptr, timestamp)) {
+        if (!loss_distribution(random_engine_)) {
+          socket_.SendTo(packet, ip_, port_);
+        }
+      }
+    }
+  } catch (const sock::SendError &ex) {
+    LOG(kWarning) << "Streaming to " << ip_ << ":" << port_
+                  << " stopped: " << ex.what();
+  }
+
+  is_finished_ = true;
+}
+
+} // namespace test_source
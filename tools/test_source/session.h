@@ -0,0 +1,105 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "frame_source.h"
+#include "rtp_jpeg_packetizer.h"
+#include "sock/socket.h"
+
+namespace test_source {
+
+/**
+ * @brief Parameters of streaming, common for all sessions
+ */
+struct StreamOptions {
+  int fps = 25; //!< Frames per second
+  double loss_probability = 0.0; //!< Probability to drop each RTP packet
+  std::size_t max_packet_size = 1400; //!< Max size of RTP packet in bytes
+};
+
+/**
+ * @brief RTP session of one client. Sends frames in a separate thread
+ */
+class Session {
+ public:
+  /**
+   * @param source_ptr Source of frames
+   * @param options Streaming parameters
+   * @param ip Client ip address
+   * @param port Client RTP port
+   */
+  Session(std::shared_ptr<const FrameSource> source_ptr,
+          const StreamOptions &options, std::string ip, int port);
+
+  /**
+   * @brief Stops streaming
+   */
+  ~Session();
+
+  Session(const Session &) = delete;
+  Session &operator=(const Session &) = delete;
+
+  /**
+   * @brief Start streaming. Does nothing, if already started
+   */
+  void Play();
+
+  /**
+   * @brief Check if streaming has stopped because of sending error
+   *
+   * @return true if session can be removed
+   */
+  [[nodiscard]] bool IsFinished() const;
+
+ private:
+  const std::shared_ptr<const FrameSource> source_ptr_;
+  const StreamOptions options_;
+  const std::string ip_;
+  const int port_;
+  sock::Socket socket_;
+  RtpJpegPacketizer packetizer_;
+  const uint32_t initial_timestamp_; //!< Random timestamp of the first frame
+  std::mt19937 random_engine_; //!< Used by streaming thread only
+  std::thread worker_;
+  bool worker_stop_;
+  std::mutex worker_mutex_;
+  std::condition_variable worker_condition_;
+  std::atomic<bool> is_finished_;
+
+  /**
+   * @brief Send frames with constant rate until stop is requested
+   */
+  void Streaming();
+};
+
+} // namespace test_source
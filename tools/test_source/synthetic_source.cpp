@@ -0,0 +1,263 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "synthetic_source.h"
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+//! Max image dimension, that can be sent with RTP/JPEG
+const int kMaxDimension = 2040;
+//! Size of 4:2:0 MCU in pixels
+const int kMcuSize = 16;
+
+//! Standard Huffman tables from JPEG spec: number of codes of each length
+const uint8_t kLumaDcCodeLengths[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0,
+                                        0, 0, 0};
+const uint8_t kChromaDcCodeLengths[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0,
+                                          0, 0, 0};
+const uint8_t kLumaAcCodeLengths[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0,
+                                        0, 1, 0x7d};
+const uint8_t kChromaAcCodeLengths[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0,
+                                          1, 2, 0x77};
+//! First symbols of standard AC tables. Enough to find EOB code
+const uint8_t kLumaAcFirstSymbols[] = {0x01, 0x02, 0x03, 0x00};
+const uint8_t kChromaAcFirstSymbols[] = {0x00};
+
+//! DC quantizers of standard luma and chroma tables from JPEG spec
+const int kLumaBaseDcQuantizer = 16;
+const int kChromaBaseDcQuantizer = 17;
+
+/**
+ * @brief Writer of entropy-coded JPEG data with byte stuffing
+ */
+class BitWriter {
+ public:
+  explicit BitWriter(types::Bytes &bytes) :
+  bytes_(bytes),
+  accumulator_(0),
+  bit_count_(0) {
+  }
+
+  /**
+   * @brief Write bits
+   *
+   * @param bits Bits to write in the least significant part
+   * @param length Number of bits to write
+   */
+  void Write(const uint32_t bits, const int length) {
+    accumulator_ = (accumulator_ << length) | (bits & ((1U << length) - 1));
+    bit_count_ += length;
+    while (bit_count_ >= 8) {
+      bit_count_ -= 8;
+      PutByte((accumulator_ >> bit_count_) & 0xff);
+    }
+  }
+
+  /**
+   * @brief Pad last byte with ones
+   */
+  void Flush() {
+    if (bit_count_ > 0) {
+      Write(0x7f, 8 - bit_count_);
+    }
+  }
+
+ private:
+  types::Bytes &bytes_;
+  uint32_t accumulator_;
+  int bit_count_;
+
+  void PutByte(const types::Byte byte) {
+    bytes_.push_back(byte);
+    if (byte == 0xff) {
+      bytes_.push_back(0x00);
+    }
+  }
+};
+
+/**
+ * @brief Build canonical Huffman code of symbol
+ * @details Algorithm from JPEG spec Annex C
+ *
+ * @param code_lengths Number of codes of each length
+ * @param symbols Symbols in order of codes
+ * @param symbol_count Number of known symbols
+ * @param symbol Symbol to find code for
+ * @return Code and its length
+ */
+std::pair<uint16_t, int> FindHuffmanCode(const uint8_t code_lengths[16],
+                                         const uint8_t *symbols,
+                                         const std::size_t symbol_count,
+                                         const uint8_t symbol) {
+  uint16_t code = 0;
+  std::size_t index = 0;
+  for (int length = 1; length <= 16; ++length) {
+    for (int i = 0; i < code_lengths[length - 1]; ++i, ++index, ++code) {
+      if ((index < symbol_count) && (symbols[index] == symbol)) {
+        return {code, length};
+      }
+    }
+    code <<= 1;
+  }
+
+  throw std::logic_error("Symbol is absent in Huffman table");
+}
+
+/**
+ * @brief Get DC quantizer of standard table scaled by quality
+ * @details Same scaling as in RFC 2435 Appendix A
+ *
+ * @param base_quantizer Quantizer of the standard table
+ * @param quality Quality in range [1, 99]
+ * @return Quantizer
+ */
+int ScaleQuantizer(const int base_quantizer, const int quality) {
+  const int scale = (quality < 50) ? (5000 / quality) : (200 - quality * 2);
+  return std::clamp((base_quantizer * scale + 50) / 100, 1, 255);
+}
+
+/**
+ * @brief Get number of bits needed to represent absolute value
+ *
+ * @param value Value
+ * @return JPEG magnitude category
+ */
+int GetCategory(const int value) {
+  int category = 0;
+  for (int magnitude = std::abs(value); magnitude > 0; magnitude >>= 1) {
+    ++category;
+  }
+
+  return category;
+}
+
+} // namespace
+
+namespace test_source {
+
+SyntheticSource::SyntheticSource(const int width, const int height) :
+width_(width),
+height_(height),
+luma_dc_table_(),
+chroma_dc_table_(),
+luma_end_of_block_(FindHuffmanCode(kLumaAcCodeLengths, kLumaAcFirstSymbols,
+                                   sizeof(kLumaAcFirstSymbols), 0x00)),
+chroma_end_of_block_(FindHuffmanCode(kChromaAcCodeLengths,
+                                     kChromaAcFirstSymbols,
+                                     sizeof(kChromaAcFirstSymbols), 0x00)),
+luma_dc_quantizer_(ScaleQuantizer(kLumaBaseDcQuantizer, kQuality)),
+chroma_dc_quantizer_(ScaleQuantizer(kChromaBaseDcQuantizer, kQuality)) {
+  if ((width_ <= 0) || (height_ <= 0) ||
+      (width_ % kMcuSize != 0) || (height_ % kMcuSize != 0)) {
+    throw std::invalid_argument("Width and height must be multiples of 16");
+  }
+  if ((width_ > kMaxDimension) || (height_ > kMaxDimension)) {
+    throw std::invalid_argument("Width and height must not exceed 2040");
+  }
+
+  // DC symbols are just categories in order
+  const uint8_t dc_symbols[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+  for (uint8_t category = 0; category < luma_dc_table_.size(); ++category) {
+    luma_dc_table_[category] = FindHuffmanCode(
+        kLumaDcCodeLengths, dc_symbols, sizeof(dc_symbols), category);
+    chroma_dc_table_[category] = FindHuffmanCode(
+        kChromaDcCodeLengths, dc_symbols, sizeof(dc_symbols), category);
+  }
+}
+
+std::shared_ptr<const JpegFrame> SyntheticSource::GetFrame(
+    const uint64_t frame_number) const {
+  auto frame_ptr = std::make_shared<JpegFrame>();
+  frame_ptr->type = 1;
+  frame_ptr->quality = kQuality;
+  frame_ptr->width = width_;
+  frame_ptr->height = height_;
+
+  const int mcu_columns = width_ / kMcuSize;
+  const int mcu_rows = height_ / kMcuSize;
+  // DC-only block takes about one byte
+  frame_ptr->scan_data.reserve(mcu_columns * mcu_rows * 6 + 16);
+  BitWriter writer(frame_ptr->scan_data);
+
+  const auto encode_block = [&writer] (const int value, const int quantizer,
+                                       int &predictor, const DcTable &dc_table,
+                                       const HuffmanCode &end_of_block) {
+    // DC coefficient of the block filled with value is 8 * (value - 128)
+    const int dc = static_cast<int>(std::lround(8.0 * (value - 128) /
+                                                quantizer));
+    const int diff = dc - predictor;
+    predictor = dc;
+
+    const int category = GetCategory(diff);
+    writer.Write(dc_table[category].first, dc_table[category].second);
+    if (category > 0) {
+      writer.Write(diff >= 0 ? diff : diff + (1 << category) - 1, category);
+    }
+    writer.Write(end_of_block.first, end_of_block.second);
+  };
+
+  // Diagonal gradient moves by 4 levels per frame, chroma changes slowly
+  const int phase = static_cast<int>(frame_number % 256);
+  int y_predictor = 0;
+  int cb_predictor = 0;
+  int cr_predictor = 0;
+  for (int mcu_row = 0; mcu_row < mcu_rows; ++mcu_row) {
+    for (int mcu_column = 0; mcu_column < mcu_columns; ++mcu_column) {
+      for (int block = 0; block < 4; ++block) {
+        const int block_x = mcu_column * 2 + block % 2;
+        const int block_y = mcu_row * 2 + block / 2;
+        const int y = ((block_x + block_y) * 8 + phase * 4) % 256;
+        encode_block(y, luma_dc_quantizer_, y_predictor, luma_dc_table_,
+                     luma_end_of_block_);
+      }
+
+      const int cb = 96 + (mcu_column * 4 + phase) % 64;
+      const int cr = 96 + (mcu_row * 4) % 64;
+      encode_block(cb, chroma_dc_quantizer_, cb_predictor, chroma_dc_table_,
+                   chroma_end_of_block_);
+      encode_block(cr, chroma_dc_quantizer_, cr_predictor, chroma_dc_table_,
+                   chroma_end_of_block_);
+    }
+  }
+  writer.Flush();
+
+  return frame_ptr;
+}
+
+int SyntheticSource::GetWidth() const {
+  return width_;
+}
+
+int SyntheticSource::GetHeight() const {
+  return height_;
+}
+
+} // namespace test_source
@@ -0,0 +1,77 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <utility>
+
+#include "frame_source.h"
+
+namespace test_source {
+
+/**
+ * @brief Source of synthetic frames with moving gradient
+ * @details Frames are baseline 4:2:0 JPEG images, where every 8x8 block has
+ * only DC coefficient. Such images are cheap to generate, but still are
+ * ordinary JPEG for decoder and give encoder some motion to work with
+ */
+class SyntheticSource : public FrameSource {
+ public:
+  /**
+   * @throw std::invalid_argument if dimensions aren't multiple of 16 or are
+   * bigger than RTP/JPEG allows
+   *
+   * @param width Image width
+   * @param height Image height
+   */
+  SyntheticSource(int width, int height);
+
+  [[nodiscard]] std::shared_ptr<const JpegFrame> GetFrame(
+      uint64_t frame_number) const override;
+
+  [[nodiscard]] int GetWidth() const override;
+
+  [[nodiscard]] int GetHeight() const override;
+
+ private:
+  //! Huffman code: {code, length in bits}
+  using HuffmanCode = std::pair<uint16_t, int>;
+  //! Huffman codes of DC difference categories
+  using DcTable = std::array<HuffmanCode, 12>;
+
+  //! Quality used for standard tables. Only their DC quantizers matter
+  static constexpr uint8_t kQuality = 50;
+
+  const int width_;
+  const int height_;
+  DcTable luma_dc_table_;
+  DcTable chroma_dc_table_;
+  HuffmanCode luma_end_of_block_; //!< Code of EOB in luma AC table
+  HuffmanCode chroma_end_of_block_; //!< Code of EOB in chroma AC table
+  int luma_dc_quantizer_;
+  int chroma_dc_quantizer_;
+};
+
+} // namespace test_source
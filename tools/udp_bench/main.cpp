@@ -0,0 +1,256 @@
+/*
+MIT License
+
+Copyright (c) 2021 Polyakov Daniil Alexandrovich
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <time.h>
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "sock/datagram_batch.h"
+#include "sock/exception.h"
+#include "sock/server_socket.h"
+
+namespace {
+
+const int kDefaultPort = 4590;
+const int kDefaultDurationSec = 5;
+//! Typical RTP/JPEG packet
+const std::size_t kDefaultPacketSize = 1400;
+//! Same as rtsp::Client
+const std::size_t kDefaultBatchSize = 32;
+const std::size_t kMaxDatagramSize = 4096;
+//! Receiver wakes up this often to check the end of measurement
+const std::chrono::milliseconds kReadTimeout{100};
+
+/**
+ * @brief Receiving method to measure
+ */
+enum class Mode {
+  kRead, //!< Socket::Read(), one recvfrom(2) per packet, as before batching
+  kBatch //!< Socket::Receive(), one recvmmsg(2) per batch
+};
+
+/**
+ * @brief Result of one measurement
+ */
+struct Result {
+  uint64_t packet_count = 0;
+  uint64_t byte_count = 0;
+  uint64_t syscall_count = 0;
+  double seconds = 0; //!< Wall time of receiving
+  double cpu_seconds = 0; //!< CPU time of receiver thread
+};
+
+/**
+ * @return CPU time of calling thread in seconds
+ */
+double GetThreadCpuSeconds() {
+  timespec time{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Send datagrams to localhost with sendmmsg(2) until stop
+ *
+ * @param port Destination port
+ * @param packet_size Size of every datagram
+ * @param stop Stop flag
+ */
+void SendRoutine(const int port, const std::size_t packet_size,
+                 const std::atomic<bool> &stop) {
+  sockaddr_in destination{};
+  destination.sin_family = AF_INET;
+  destination.sin_port = htons(port);
+  destination.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  sock::Socket socket(sock::Type::kUdp);
+  sock::DatagramSendBatch batch;
+  const types::Bytes datagram(packet_size, 0x80);
+  for (std::size_t i = 0; i < kDefaultBatchSize; ++i) {
+    batch.Add(datagram, destination);
+  }
+  while (!stop) {
+    socket.Send(batch);
+  }
+}
+
+/**
+ * @brief Receive datagrams from sender thread for the given time
+ *
+ * @param mode Receiving method
+ * @param port Port to receive on
+ * @param packet_size Size of sent datagrams
+ * @param batch_size Max number of datagrams received with one call
+ * @param duration Time of measurement
+ * @return Result
+ */
+Result Measure(const Mode mode, const int port, const std::size_t packet_size,
+               const std::size_t batch_size,
+               const std::chrono::seconds duration) {
+  sock::ServerSocket socket(sock::Type::kUdp, port);
+  socket.SetTimeouts(kReadTimeout, kReadTimeout);
+  sock::DatagramBatch batch(batch_size, kMaxDatagramSize);
+
+  std::atomic<bool> stop(false);
+  std::thread sender(SendRoutine, port, packet_size, std::cref(stop));
+
+  Result result;
+  const auto start_time = std::chrono::steady_clock::now();
+  const auto end_time = start_time + duration;
+  const double start_cpu_seconds = GetThreadCpuSeconds();
+  while (std::chrono::steady_clock::now() < end_time) {
+    ++result.syscall_count;
+    if (mode == Mode::kRead) {
+      try {
+        const std::string datagram = socket.Read(kMaxDatagramSize);
+        ++result.packet_count;
+        result.byte_count += datagram.size();
+      } catch (const sock::ReadError &) {
+        // Timeout
+      }
+    } else {
+      const std::size_t count = socket.Receive(batch);
+      for (std::size_t i = 0; i < count; ++i) {
+        result.byte_count += batch.GetDatagram(i).size();
+      }
+      result.packet_count += count;
+    }
+  }
+  result.cpu_seconds = GetThreadCpuSeconds() - start_cpu_seconds;
+  result.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start_time).count();
+
+  stop = true;
+  sender.join();
+  return result;
+}
+
+void PrintResult(const std::string &name, const Result &result) {
+  const double gbits = result.byte_count * 8 / 1e9;
+  std::cout << name << ":\n"
+            << "  packets/s:        " << result.packet_count / result.seconds
+            << "\n"
+            << "  syscalls/s:       " << result.syscall_count / result.seconds
+            << "\n"
+            << "  packets/syscall:  "
+            << static_cast<double>(result.packet_count) /
+               std::max<uint64_t>(result.syscall_count, 1) << "\n"
+            << "  throughput:       " << gbits / result.seconds << " Gbit/s\n"
+            << "  receiver CPU:     " << 100.0 * result.cpu_seconds /
+                                         result.seconds << " %\n"
+            << "  CPU per Gbit:     "
+            << ((gbits > 0) ? result.cpu_seconds / gbits : 0) << " s\n";
+}
+
+void PrintUsage(const char *program_name) {
+  std::cerr << "Usage: " << program_name << " [options]\n"
+            << "Compares RTP-like UDP receiving on localhost with one "
+               "recvfrom(2) per packet and with recvmmsg(2) batches\n"
+            << "  -p, --port <port>       Receiving port (default "
+            << kDefaultPort << ")\n"
+            << "  -d, --duration <sec>    Duration of every measurement "
+               "(default " << kDefaultDurationSec << ")\n"
+            << "  -s, --size <bytes>      Datagram size (default "
+            << kDefaultPacketSize << ")\n"
+            << "  -b, --batch <count>     Max datagrams per recvmmsg(2) "
+               "(default " << kDefaultBatchSize << ")\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    int port = kDefaultPort;
+    int duration_sec = kDefaultDurationSec;
+    std::size_t packet_size = kDefaultPacketSize;
+    std::size_t batch_size = kDefaultBatchSize;
+
+    const option long_options[] = {
+        {"port", required_argument, nullptr, 'p'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"size", required_argument, nullptr, 's'},
+        {"batch", required_argument, nullptr, 'b'},
+        {nullptr, 0, nullptr, 0}
+    };
+    int opt = 0;
+    while ((opt = getopt_long(argc, argv, "p:d:s:b:", long_options,
+                              nullptr)) != -1) {
+      switch (opt) {
+        case 'p':
+          port = std::stoi(optarg);
+          break;
+        case 'd':
+          duration_sec = std::stoi(optarg);
+          break;
+        case 's':
+          packet_size = std::stoul(optarg);
+          break;
+        case 'b':
+          batch_size = std::stoul(optarg);
+          break;
+        default:
+          PrintUsage(argv[0]);
+          return EXIT_FAILURE;
+      }
+    }
+    if ((packet_size == 0) || (packet_size > kMaxDatagramSize) ||
+        (batch_size == 0)) {
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+    const std::chrono::seconds duration(duration_sec);
+    const Result read_result = Measure(Mode::kRead, port, packet_size,
+                                       batch_size, duration);
+    const Result batch_result = Measure(Mode::kBatch, port, packet_size,
+                                        batch_size, duration);
+
+    std::cout << std::fixed << std::setprecision(2);
+    PrintResult("recvfrom", read_result);
+    PrintResult("recvmmsg/" + std::to_string(batch_size), batch_result);
+
+    // Lower is better: CPU spent by receiver per received byte
+    const double read_cost = read_result.cpu_seconds /
+                             std::max<uint64_t>(read_result.byte_count, 1);
+    const double batch_cost = batch_result.cpu_seconds /
+                              std::max<uint64_t>(batch_result.byte_count, 1);
+    std::cout << "CPU per Gbit, recvfrom / recvmmsg: "
+              << ((batch_cost > 0) ? read_cost / batch_cost : 0) << std::endl;
+  } catch (const std::exception &ex) {
+    std::cerr << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}